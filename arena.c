@@ -0,0 +1,116 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define ARENA_FIRST_BLOCK_SIZE 1024
+#define ARENA_MAX_BLOCK_SIZE (1 << 20)
+
+/* a type with the strictest alignment of the types that are kept in an arena */
+typedef union arena_align_t
+{
+    long long integer;
+    long double floating;
+    void* pointer;
+} ArenaAlign;
+
+#define ARENA_ALIGNMENT sizeof(ArenaAlign)
+
+/* a block of the arena. the memory of the block follows its header */
+typedef struct arena_block_t
+{
+    struct arena_block_t* previous;
+    ArenaAlign align;
+} *ArenaBlock;
+
+struct arena_t
+{
+    ArenaBlock blocks;
+    char* next;
+    size_t available;
+    size_t next_block_size;
+    int num_blocks;
+};
+
+/* allocate a new block that has at least size bytes and make it the current block. false if failed */
+static bool arenaAddBlock(Arena arena, size_t size);
+
+Arena arenaCreate()
+{
+    Arena arena = malloc(sizeof(*arena));
+    if(arena == NULL) {
+        return NULL;
+    }
+    arena->blocks = NULL;
+    arena->next = NULL;
+    arena->available = 0;
+    arena->next_block_size = ARENA_FIRST_BLOCK_SIZE;
+    arena->num_blocks = 0;
+    return arena;
+}
+
+void arenaDestroy(Arena arena)
+{
+    if(arena == NULL) {
+        return;
+    }
+    ArenaBlock block = arena->blocks;
+    while(block != NULL)
+    {
+        ArenaBlock previous = block->previous;
+        free(block);
+        block = previous;
+    }
+    free(arena);
+}
+
+void* arenaAlloc(Arena arena, size_t size)
+{
+    if(arena == NULL) {
+        return NULL;
+    }
+    size = arenaAlignSize(size == 0 ? 1 : size);
+    if(size > arena->available && arenaAddBlock(arena, size) == false) {
+        return NULL;
+    }
+    void* memory = arena->next;
+    arena->next += size;
+    arena->available -= size;
+    return memory;
+}
+
+int arenaGetNumBlocks(Arena arena)
+{
+    if(arena == NULL) {
+        return -1;
+    }
+    return arena->num_blocks;
+}
+
+size_t arenaAlignSize(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+static bool arenaAddBlock(Arena arena, size_t size)
+{
+    assert(arena != NULL);
+    // the blocks double up to a limit, so a large arena has few blocks and a small one wastes little
+    size_t block_size = arena->next_block_size;
+    if(block_size < size) {
+        block_size = size;
+    }
+    ArenaBlock block = malloc(offsetof(struct arena_block_t, align) + block_size);
+    if(block == NULL) {
+        return false;
+    }
+    block->previous = arena->blocks;
+    arena->blocks = block;
+    arena->next = (char*)&block->align;
+    arena->available = block_size;
+    arena->num_blocks++;
+    if(arena->next_block_size < ARENA_MAX_BLOCK_SIZE) {
+        arena->next_block_size *= 2;
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct arena_t *Arena;
+
+/**
+* arenaCreate: create a new empty arena. the memory of an arena is taken in blocks that grow
+* with the arena, and is freed only all together, when the arena is destroyed.
+*
+* @return
+* 	NULL - allocation failed.
+* 	pointer to the arena - otherwise.
+*/
+Arena arenaCreate();
+
+/**
+* arenaDestroy: deallocate the arena and all the memory that was allocated from it,
+* in a time that depends on the number of blocks only.
+*
+* @param arena - pointer to the arena.
+*/
+void arenaDestroy(Arena arena);
+
+/**
+* arenaAlloc: allocate memory from the arena, aligned for any type.
+* the memory is not freed on its own, it is valid until the arena is destroyed.
+*
+* @param arena - pointer to the arena.
+* @param size - the number of bytes.
+* @return
+* 	NULL - a NULL arena was sent or allocation failed.
+* 	pointer to the memory - otherwise.
+*/
+void* arenaAlloc(Arena arena, size_t size);
+
+/**
+* arenaAlignSize: round a size up to the alignment of the arena, so several objects
+* can be placed one after the other in a single allocation.
+*
+* @param size - the number of bytes.
+* @return
+* 	the aligned size.
+*/
+size_t arenaAlignSize(size_t size);
+
+/**
+* arenaGetNumBlocks: return the number of blocks that the arena has allocated.
+*
+* @param arena - pointer to the arena.
+* @return
+* 	-1 - a NULL arena was sent.
+* 	the number of blocks - otherwise.
+*/
+int arenaGetNumBlocks(Arena arena);
+
+#endif //ARENA_H
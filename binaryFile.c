@@ -0,0 +1,48 @@
+#include "binaryFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+BinaryFileResult binaryFileRead(const char* path, unsigned char** content, size_t* length)
+{
+    *content = NULL;
+    *length = 0;
+    FILE* file = fopen(path, "rb");
+    if(file == NULL) {
+        return errno == ENOENT ? BINARY_FILE_NOT_FOUND : BINARY_FILE_ERROR;
+    }
+    if(fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return BINARY_FILE_ERROR;
+    }
+    long size = ftell(file);
+    if(size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return BINARY_FILE_ERROR;
+    }
+    unsigned char* new_content = malloc(size > 0 ? (size_t)size : 1);
+    if(new_content == NULL) {
+        fclose(file);
+        return BINARY_FILE_OUT_OF_MEMORY;
+    }
+    if(fread(new_content, 1, (size_t)size, file) != (size_t)size) {
+        free(new_content);
+        fclose(file);
+        return BINARY_FILE_ERROR;
+    }
+    fclose(file);
+    *content = new_content;
+    *length = (size_t)size;
+    return BINARY_FILE_SUCCESS;
+}
+
+uint64_t binaryFileChecksum(uint64_t checksum, uint64_t prime, const unsigned char* bytes, size_t length)
+{
+    // the low bits of a product depend only on the low bits of its factors, so a 32 bits checksum
+    // that is kept in 64 bits has the right low 32 bits
+    for(size_t i = 0; i < length; i++) {
+        checksum ^= bytes[i];
+        checksum *= prime;
+    }
+    return checksum;
+}
@@ -0,0 +1,49 @@
+#ifndef BINARY_FILE_H
+#define BINARY_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The parameters of the 32 and 64 bits FNV-1a checksums of the binary files */
+#define FNV_32_OFFSET_BASIS 0x811c9dc5u
+#define FNV_32_PRIME 0x01000193u
+#define FNV_64_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_64_PRIME 0x100000001b3ull
+
+/** Type used for returning error codes from binary file functions */
+typedef enum BinaryFileResult_t {
+    BINARY_FILE_SUCCESS,
+    BINARY_FILE_OUT_OF_MEMORY,
+    BINARY_FILE_NOT_FOUND,
+    BINARY_FILE_ERROR
+} BinaryFileResult;
+
+/**
+* binaryFileRead: read the whole content of a file into a new buffer, with one read.
+*
+* @param path - the path of the file.
+* @param content - a pointer where to put the content. the caller frees it. NULL is put if the read failed.
+* @param length - a pointer where to put the length of the content. 0 is put if the read failed.
+* @return
+* 	BINARY_FILE_NOT_FOUND - the file does not exist.
+* 	BINARY_FILE_ERROR - the file could not be opened or read.
+* 	BINARY_FILE_OUT_OF_MEMORY - allocation failed.
+* 	BINARY_FILE_SUCCESS - otherwise.
+*/
+BinaryFileResult binaryFileRead(const char* path, unsigned char** content, size_t* length);
+
+/**
+* binaryFileChecksum: add bytes to a FNV-1a checksum. the checksum starts as FNV_32_OFFSET_BASIS or
+* FNV_64_OFFSET_BASIS, and is continued with the prime of the same width. a 32 bits checksum is in the low
+* 32 bits of the result.
+*
+* @param checksum - the checksum of the bytes before.
+* @param prime - FNV_32_PRIME or FNV_64_PRIME.
+* @param bytes - the bytes to add.
+* @param length - the number of bytes.
+* @return
+* 	the checksum with the bytes added.
+*/
+uint64_t binaryFileChecksum(uint64_t checksum, uint64_t prime, const unsigned char* bytes, size_t length);
+
+#endif //BINARY_FILE_H
@@ -0,0 +1,301 @@
+#define _POSIX_C_SOURCE 200809L
+#include "callTrace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define TRACE_MAGIC "CHSTRACE"
+#define TRACE_MAGIC_SIZE 8
+#define TRACE_VERSION 2
+#define TRACE_BUFFER_SIZE (1 << 16)
+#define TRACE_MAX_NUMBER_SIZE 5
+#define TRACE_MAX_NUMBER_SHIFT 28
+#define TRACE_INITIAL_CAPACITY 16
+#define TRACE_GROWTH_FACTOR 2
+#define NO_TEXT 0
+#define SEVEN_BITS 0x7fu
+#define MORE_BYTES 0x80u
+#define BITS_IN_BYTE_GROUP 7
+#define SIGN_SHIFT 31
+
+// the calls are encoded into the buffer under the lock, and the buffer is written when it is full
+struct call_trace_t
+{
+    FILE* file;
+    pthread_mutex_t lock;
+    unsigned char buffer[TRACE_BUFFER_SIZE];
+    size_t length;
+    bool failed;
+};
+
+// the values, the items and the text of the last call that was read; they grow to the largest call of the trace
+struct trace_reader_t
+{
+    FILE* file;
+    int* values;
+    int values_capacity;
+    int* items;
+    int items_capacity;
+    char* text;
+    unsigned int text_capacity;
+};
+
+/* add a number to the buffer, zigzag encoded so a small negative number is short too. called with the lock held */
+static void callTraceWriteNumber(CallTrace trace, int value);
+
+/* add bytes to the buffer, writing it when it is full. called with the lock held */
+static void callTraceWriteBytes(CallTrace trace, const unsigned char* bytes, size_t length);
+
+/* write the buffer to the file. called with the lock held */
+static void callTraceFlush(CallTrace trace);
+
+/* read a zigzag encoded number. at_start tells whether it is the first number of a call, where the end
+ * of the file is the end of the trace and not a torn call */
+static CallTraceResult traceReaderNumber(TraceReader reader, int* value, bool at_start);
+
+/* read a count and then that many numbers into an array of the reader, that grows to hold them */
+static CallTraceResult traceReaderNumbers(TraceReader reader, int** numbers, int* capacity, int* count);
+
+/* make sure the text of the reader can hold a string of this length */
+static CallTraceResult traceReaderReserveText(TraceReader reader, unsigned int length);
+
+CallTrace callTraceOpen(const char* path)
+{
+    if(path == NULL) {
+        return NULL;
+    }
+    CallTrace trace = malloc(sizeof(*trace));
+    if(trace == NULL) {
+        return NULL;
+    }
+    trace->file = fopen(path, "wb");
+    if(trace->file == NULL) {
+        free(trace);
+        return NULL;
+    }
+    pthread_mutex_init(&trace->lock, NULL);
+    trace->length = 0;
+    trace->failed = false;
+    callTraceWriteBytes(trace, (const unsigned char*)TRACE_MAGIC, TRACE_MAGIC_SIZE);
+    callTraceWriteNumber(trace, TRACE_VERSION);
+    return trace;
+}
+
+void callTraceAppend(CallTrace trace, const TraceCall* call)
+{
+    assert(trace != NULL && call != NULL && call->num_of_values >= 0 && call->num_of_items >= 0);
+    pthread_mutex_lock(&trace->lock);
+    callTraceWriteNumber(trace, call->function);
+    callTraceWriteNumber(trace, call->result);
+    callTraceWriteNumber(trace, call->num_of_values);
+    for(int i = 0; i < call->num_of_values; i++) {
+        callTraceWriteNumber(trace, call->values[i]);
+    }
+    callTraceWriteNumber(trace, call->num_of_items);
+    for(int i = 0; i < call->num_of_items; i++) {
+        callTraceWriteNumber(trace, call->items[i]);
+    }
+    // the length is written plus one, so an empty text is not mistaken for no text
+    if(call->text == NULL) {
+        callTraceWriteNumber(trace, NO_TEXT);
+    } else {
+        size_t length = strlen(call->text);
+        callTraceWriteNumber(trace, (int)length + 1);
+        callTraceWriteBytes(trace, (const unsigned char*)call->text, length);
+    }
+    pthread_mutex_unlock(&trace->lock);
+}
+
+CallTraceResult callTraceClose(CallTrace trace)
+{
+    if(trace == NULL) {
+        return TRACE_SUCCESS;
+    }
+    callTraceFlush(trace);
+    bool failed = trace->failed;
+    if(fclose(trace->file) != 0) {
+        failed = true;
+    }
+    pthread_mutex_destroy(&trace->lock);
+    free(trace);
+    return failed ? TRACE_FILE_ERROR : TRACE_SUCCESS;
+}
+
+CallTraceResult traceReaderCreate(const char* path, TraceReader* reader)
+{
+    if(path == NULL || reader == NULL) {
+        return TRACE_FILE_ERROR;
+    }
+    TraceReader new_reader = malloc(sizeof(*new_reader));
+    if(new_reader == NULL) {
+        return TRACE_OUT_OF_MEMORY;
+    }
+    new_reader->values = NULL;
+    new_reader->values_capacity = 0;
+    new_reader->items = NULL;
+    new_reader->items_capacity = 0;
+    new_reader->text = NULL;
+    new_reader->text_capacity = 0;
+    new_reader->file = fopen(path, "rb");
+    if(new_reader->file == NULL) {
+        free(new_reader);
+        return TRACE_FILE_ERROR;
+    }
+    char magic[TRACE_MAGIC_SIZE];
+    int version = 0;
+    if(fread(magic, 1, TRACE_MAGIC_SIZE, new_reader->file) != TRACE_MAGIC_SIZE ||
+       memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_SIZE) != 0 ||
+       traceReaderNumber(new_reader, &version, false) != TRACE_SUCCESS || version != TRACE_VERSION) {
+        traceReaderDestroy(new_reader);
+        return TRACE_BAD_FORMAT;
+    }
+    *reader = new_reader;
+    return TRACE_SUCCESS;
+}
+
+CallTraceResult traceReaderNext(TraceReader reader, TraceCall* call)
+{
+    assert(reader != NULL && call != NULL);
+    CallTraceResult result = traceReaderNumber(reader, &call->function, true);
+    if(result != TRACE_SUCCESS) {
+        return result;
+    }
+    int text_length = NO_TEXT;
+    if((result = traceReaderNumber(reader, &call->result, false)) != TRACE_SUCCESS ||
+       (result = traceReaderNumbers(reader, &reader->values, &reader->values_capacity,
+                                    &call->num_of_values)) != TRACE_SUCCESS ||
+       (result = traceReaderNumbers(reader, &reader->items, &reader->items_capacity,
+                                    &call->num_of_items)) != TRACE_SUCCESS ||
+       (result = traceReaderNumber(reader, &text_length, false)) != TRACE_SUCCESS) {
+        return result;
+    }
+    if(text_length < NO_TEXT) {
+        return TRACE_BAD_FORMAT;
+    }
+    call->values = reader->values;
+    call->items = reader->items;
+    call->text = NULL;
+    if(text_length == NO_TEXT) {
+        return TRACE_SUCCESS;
+    }
+    unsigned int length = text_length - 1;
+    if((result = traceReaderReserveText(reader, length + 1)) != TRACE_SUCCESS) {
+        return result;
+    }
+    if(fread(reader->text, 1, length, reader->file) != length) {
+        return ferror(reader->file) ? TRACE_FILE_ERROR : TRACE_BAD_FORMAT;
+    }
+    reader->text[length] = '\0';
+    call->text = reader->text;
+    return TRACE_SUCCESS;
+}
+
+void traceReaderDestroy(TraceReader reader)
+{
+    if(reader == NULL) {
+        return;
+    }
+    fclose(reader->file);
+    free(reader->values);
+    free(reader->items);
+    free(reader->text);
+    free(reader);
+}
+
+static void callTraceWriteNumber(CallTrace trace, int value)
+{
+    unsigned int zigzag = ((unsigned int)value << 1) ^ (unsigned int)(value >> SIGN_SHIFT);
+    unsigned char bytes[TRACE_MAX_NUMBER_SIZE];
+    size_t length = 0;
+    while(zigzag > SEVEN_BITS) {
+        bytes[length++] = (unsigned char)((zigzag & SEVEN_BITS) | MORE_BYTES);
+        zigzag >>= BITS_IN_BYTE_GROUP;
+    }
+    bytes[length++] = (unsigned char)zigzag;
+    callTraceWriteBytes(trace, bytes, length);
+}
+
+static void callTraceWriteBytes(CallTrace trace, const unsigned char* bytes, size_t length)
+{
+    while(length > 0) {
+        if(trace->length == TRACE_BUFFER_SIZE) {
+            callTraceFlush(trace);
+        }
+        size_t part = TRACE_BUFFER_SIZE - trace->length;
+        part = part < length ? part : length;
+        memcpy(trace->buffer + trace->length, bytes, part);
+        trace->length += part;
+        bytes += part;
+        length -= part;
+    }
+}
+
+static void callTraceFlush(CallTrace trace)
+{
+    if(trace->length > 0 && fwrite(trace->buffer, 1, trace->length, trace->file) != trace->length) {
+        trace->failed = true;
+    }
+    trace->length = 0;
+}
+
+static CallTraceResult traceReaderNumber(TraceReader reader, int* value, bool at_start)
+{
+    unsigned int zigzag = 0;
+    for(int shift = 0; shift <= TRACE_MAX_NUMBER_SHIFT; shift += BITS_IN_BYTE_GROUP) {
+        int byte = getc(reader->file);
+        if(byte == EOF) {
+            if(ferror(reader->file)) {
+                return TRACE_FILE_ERROR;
+            }
+            return at_start && shift == 0 ? TRACE_END : TRACE_BAD_FORMAT;
+        }
+        zigzag |= ((unsigned int)byte & SEVEN_BITS) << shift;
+        if(((unsigned int)byte & MORE_BYTES) == 0) {
+            *value = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+            return TRACE_SUCCESS;
+        }
+    }
+    return TRACE_BAD_FORMAT;
+}
+
+static CallTraceResult traceReaderNumbers(TraceReader reader, int** numbers, int* capacity, int* count)
+{
+    CallTraceResult result = traceReaderNumber(reader, count, false);
+    if(result != TRACE_SUCCESS) {
+        return result;
+    }
+    if(*count < 0) {
+        return TRACE_BAD_FORMAT;
+    }
+    if(*count > *capacity) {
+        int new_capacity = *capacity == 0 ? TRACE_INITIAL_CAPACITY : *capacity * TRACE_GROWTH_FACTOR;
+        new_capacity = new_capacity < *count ? *count : new_capacity;
+        int* new_numbers = realloc(*numbers, new_capacity * sizeof(*new_numbers));
+        if(new_numbers == NULL) {
+            return TRACE_OUT_OF_MEMORY;
+        }
+        *numbers = new_numbers;
+        *capacity = new_capacity;
+    }
+    for(int i = 0; i < *count; i++) {
+        if((result = traceReaderNumber(reader, &(*numbers)[i], false)) != TRACE_SUCCESS) {
+            return result;
+        }
+    }
+    return TRACE_SUCCESS;
+}
+
+static CallTraceResult traceReaderReserveText(TraceReader reader, unsigned int length)
+{
+    if(length > reader->text_capacity) {
+        char* text = realloc(reader->text, length);
+        if(text == NULL) {
+            return TRACE_OUT_OF_MEMORY;
+        }
+        reader->text = text;
+        reader->text_capacity = length;
+    }
+    return TRACE_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#ifndef CALL_TRACE_H
+#define CALL_TRACE_H
+
+#include <stdbool.h>
+
+typedef struct call_trace_t *CallTrace;
+typedef struct trace_reader_t *TraceReader;
+
+/** Type used for returning error codes from call trace functions */
+typedef enum CallTraceResult_t {
+    TRACE_SUCCESS,
+    TRACE_OUT_OF_MEMORY,
+    TRACE_FILE_ERROR,
+    TRACE_BAD_FORMAT,
+    TRACE_END
+} CallTraceResult;
+
+/** A call of one function: the function, its integer arguments in an order that the function defines,
+ * the elements of an array argument (none if it has none), a string argument (NULL if it has none)
+ * and the result it has returned */
+typedef struct TraceCall_t {
+    int function;
+    int result;
+    int num_of_values;
+    const int* values;
+    int num_of_items;
+    const int* items;
+    const char* text;
+} TraceCall;
+
+/**
+* callTraceOpen: create a trace file and write its header.
+* every number of a call is written as a variable length integer, so a small argument takes one byte.
+*
+* @param path - the path of the file, it is truncated if it exists.
+* @return
+* 	NULL - a NULL path was sent, the file could not be opened or allocation failed.
+* 	pointer to the trace - otherwise.
+*/
+CallTrace callTraceOpen(const char* path);
+
+/**
+* callTraceAppend: add a call to the trace. the call is encoded into a buffer that is written
+* when it is full, so most calls do not reach the file. may be called from several threads at once,
+* the calls are written in the order they were added.
+* a failure is remembered by the trace and reported by callTraceClose.
+*
+* @param trace - the trace.
+* @param call - the call to add.
+*/
+void callTraceAppend(CallTrace trace, const TraceCall* call);
+
+/**
+* callTraceClose: write the buffered calls, close the file and deallocate the trace.
+*
+* @param trace - the trace to close.
+* @return
+* 	TRACE_FILE_ERROR - one of the writes (or the close) failed.
+* 	TRACE_SUCCESS - otherwise, or for a NULL trace.
+*/
+CallTraceResult callTraceClose(CallTrace trace);
+
+/**
+* traceReaderCreate: open a trace file and check its header.
+*
+* @param path - the path of the file.
+* @param reader - a pointer where to put the new reader.
+* @return
+* 	TRACE_FILE_ERROR - a NULL argument was sent or the file could not be opened.
+* 	TRACE_BAD_FORMAT - the file is not a trace of this version.
+* 	TRACE_OUT_OF_MEMORY - allocation failed.
+* 	TRACE_SUCCESS - otherwise.
+*/
+CallTraceResult traceReaderCreate(const char* path, TraceReader* reader);
+
+/**
+* traceReaderNext: read the next call of the trace, in the order they were added.
+* the values, the items and the text of the call point into the reader, and are valid until the next call to
+* traceReaderNext.
+*
+* @param reader - the reader.
+* @param call - where to put the call.
+* @return
+* 	TRACE_END - there are no more calls.
+* 	TRACE_BAD_FORMAT - the call is torn or corrupted, which is the tail of a trace that was not closed.
+* 	TRACE_FILE_ERROR - the file could not be read.
+* 	TRACE_OUT_OF_MEMORY - allocation failed.
+* 	TRACE_SUCCESS - otherwise.
+*/
+CallTraceResult traceReaderNext(TraceReader reader, TraceCall* call);
+
+/**
+* traceReaderDestroy: close the file and deallocate the reader.
+*
+* @param reader - the reader to destroy.
+*/
+void traceReaderDestroy(TraceReader reader);
+
+#endif //CALL_TRACE_H
@@ -0,0 +1,379 @@
+#define _POSIX_C_SOURCE 200809L
+#include "chessSystemExtended.h"
+#include "histogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define BENCH_DEFAULT_TOURNAMENTS 200
+#define BENCH_DEFAULT_PLAYERS 2000
+#define BENCH_DEFAULT_GAMES 100
+#define BENCH_DEFAULT_MAX_GAMES 20
+#define BENCH_DEFAULT_PLAYER_REMOVAL_RATE 0.002
+#define BENCH_DEFAULT_TOURNAMENT_REMOVAL_RATE 0.1
+#define BENCH_DEFAULT_QUERY_RATE 0.1
+#define BENCH_DEFAULT_ZIPF_EXPONENT 1.0
+#define BENCH_DEFAULT_SEED 1
+#define BENCH_DEFAULT_STATISTICS_PATH "chessBenchmark.statistics"
+#define BENCH_OPEN_TOURNAMENTS 16
+#define BENCH_MAX_PLAY_TIME 3600
+#define BENCH_DRAW_PERCENT 30
+#define BENCH_PERCENT 100
+#define BENCH_FRACTION_BITS 53
+#define NANOSECONDS_PER_SECOND 1000000000LL
+#define NANOSECONDS_PER_MICROSECOND 1000.0
+#define KILOBYTES_PER_MEGABYTE 1024.0
+
+/** The operations that are measured, each one a call of the public API */
+typedef enum BenchOperation_t {
+    BENCH_ADD_TOURNAMENT,
+    BENCH_ADD_GAME,
+    BENCH_END_TOURNAMENT,
+    BENCH_REMOVE_TOURNAMENT,
+    BENCH_REMOVE_PLAYER,
+    BENCH_AVERAGE_PLAY_TIME,
+    BENCH_GET_PLAYER_STATS,
+    BENCH_SAVE_PLAYERS_LEVELS,
+    BENCH_SAVE_TOURNAMENT_STATISTICS,
+    BENCH_NUM_OPERATIONS
+} BenchOperation;
+
+/** The shape of the workload, from the command line */
+typedef struct BenchConfig_t {
+    int num_of_tournaments;
+    int num_of_players;
+    int games_per_tournament;
+    int max_games_per_player;
+    double player_removal_rate;
+    double tournament_removal_rate;
+    double query_rate;
+    double zipf_exponent;
+    unsigned long long seed;
+    char* statistics_path;
+} BenchConfig;
+
+// the players are drawn by a Zipf distribution over their popularity ranks. the rank of a player
+// is not its id, so the popular players are spread over the ids like in a real system
+typedef struct bench_t {
+    ChessSystem chess;
+    BenchConfig config;
+    unsigned long long random_state;
+    double* popularity;
+    int* player_ids;
+    Histogram latencies[BENCH_NUM_OPERATIONS];
+    long long successes[BENCH_NUM_OPERATIONS];
+} Bench;
+
+static const char* const operation_names[BENCH_NUM_OPERATIONS] = {
+        "chessAddTournament", "chessAddGame", "chessEndTournament", "chessRemoveTournament",
+        "chessRemovePlayer", "chessCalculateAveragePlayTime", "chessGetPlayerStats",
+        "chessSavePlayersLevels", "chessSaveTournamentStatistics"};
+
+static const char* const locations[] = {"London", "Paris", "Haifa", "Tel aviv", "Rome", "Moscow", "Oslo"};
+
+/* parse the command line into the configuration. false if it is not valid */
+static bool benchParseArguments(int argc, char** argv, BenchConfig* config);
+
+/* print how to run the benchmark */
+static void benchUsage(const char* program);
+
+/* allocate the system, the histograms and the popularity of the players. false if allocation failed */
+static bool benchCreate(Bench* bench, BenchConfig config);
+
+/* deallocate everything that benchCreate has allocated */
+static void benchDestroy(Bench* bench);
+
+/* run the workload: the tournaments are played a few at a time, with removals and queries between the games,
+ * and the exports at the end */
+static void benchRun(Bench* bench);
+
+/* end a tournament that has played all its games, and remove it by the removal rate */
+static void benchCloseTournament(Bench* bench, int tournament_id);
+
+/* the current time in nanoseconds */
+static long long benchNow();
+
+/* record the latency of an operation since start, and its success */
+static void benchRecord(Bench* bench, BenchOperation operation, long long start, ChessResult result);
+
+/* print the throughput and the latency percentiles of every operation, and the peak memory */
+static void benchReport(Bench* bench, long long elapsed_ns);
+
+/* the next random number of the generator (xorshift64*) */
+static unsigned long long benchRandom(Bench* bench);
+
+/* a random number in [0, 1) */
+static double benchUniform(Bench* bench);
+
+/* a random id of a player, by the Zipf distribution of the popularity */
+static int benchPlayer(Bench* bench);
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+    if(benchParseArguments(argc, argv, &config) == false) {
+        benchUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    Bench bench;
+    if(benchCreate(&bench, config) == false) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("tournaments=%d players=%d games_per_tournament=%d max_games_per_player=%d player_removal_rate=%g "
+           "tournament_removal_rate=%g query_rate=%g zipf_exponent=%g seed=%llu\n",
+           config.num_of_tournaments, config.num_of_players, config.games_per_tournament,
+           config.max_games_per_player, config.player_removal_rate, config.tournament_removal_rate,
+           config.query_rate, config.zipf_exponent, config.seed);
+    long long start = benchNow();
+    benchRun(&bench);
+    benchReport(&bench, benchNow() - start);
+    benchDestroy(&bench);
+    remove(config.statistics_path);
+    return EXIT_SUCCESS;
+}
+
+static bool benchParseArguments(int argc, char** argv, BenchConfig* config)
+{
+    config->num_of_tournaments = BENCH_DEFAULT_TOURNAMENTS;
+    config->num_of_players = BENCH_DEFAULT_PLAYERS;
+    config->games_per_tournament = BENCH_DEFAULT_GAMES;
+    config->max_games_per_player = BENCH_DEFAULT_MAX_GAMES;
+    config->player_removal_rate = BENCH_DEFAULT_PLAYER_REMOVAL_RATE;
+    config->tournament_removal_rate = BENCH_DEFAULT_TOURNAMENT_REMOVAL_RATE;
+    config->query_rate = BENCH_DEFAULT_QUERY_RATE;
+    config->zipf_exponent = BENCH_DEFAULT_ZIPF_EXPONENT;
+    config->seed = BENCH_DEFAULT_SEED;
+    config->statistics_path = BENCH_DEFAULT_STATISTICS_PATH;
+    int option;
+    while((option = getopt(argc, argv, "t:p:g:m:r:R:q:z:s:o:")) != -1)
+    {
+        switch(option) {
+            case 't': config->num_of_tournaments = atoi(optarg); break;
+            case 'p': config->num_of_players = atoi(optarg); break;
+            case 'g': config->games_per_tournament = atoi(optarg); break;
+            case 'm': config->max_games_per_player = atoi(optarg); break;
+            case 'r': config->player_removal_rate = atof(optarg); break;
+            case 'R': config->tournament_removal_rate = atof(optarg); break;
+            case 'q': config->query_rate = atof(optarg); break;
+            case 'z': config->zipf_exponent = atof(optarg); break;
+            case 's': config->seed = strtoull(optarg, NULL, 10); break;
+            case 'o': config->statistics_path = optarg; break;
+            default: return false;
+        }
+    }
+    return optind == argc && config->num_of_tournaments > 0 && config->num_of_players > 1 &&
+           config->games_per_tournament > 0 && config->max_games_per_player > 0 &&
+           config->player_removal_rate >= 0 && config->player_removal_rate <= 1 &&
+           config->tournament_removal_rate >= 0 && config->tournament_removal_rate <= 1 &&
+           config->query_rate >= 0 && config->zipf_exponent >= 0;
+}
+
+static void benchUsage(const char* program)
+{
+    fprintf(stderr, "usage: %s [-t tournaments] [-p players] [-g games per tournament] [-m max games per player]\n"
+                    "       [-r player removal rate] [-R tournament removal rate] [-q queries per game]\n"
+                    "       [-z zipf exponent] [-s seed] [-o statistics file]\n"
+                    "the rates are probabilities: -r after every game, -R after every ended tournament.\n",
+            program);
+}
+
+static bool benchCreate(Bench* bench, BenchConfig config)
+{
+    bench->config = config;
+    bench->random_state = config.seed == 0 ? 1 : config.seed;
+    bench->chess = chessCreate();
+    bench->popularity = malloc(config.num_of_players * sizeof(*bench->popularity));
+    bench->player_ids = malloc(config.num_of_players * sizeof(*bench->player_ids));
+    bool allocated = bench->chess != NULL && bench->popularity != NULL && bench->player_ids != NULL;
+    for(int i = 0; i < BENCH_NUM_OPERATIONS; i++) {
+        bench->latencies[i] = histogramCreate();
+        bench->successes[i] = 0;
+        allocated = allocated && bench->latencies[i] != NULL;
+    }
+    if(allocated == false) {
+        benchDestroy(bench);
+        return false;
+    }
+    double total = 0;
+    for(int rank = 0; rank < config.num_of_players; rank++) {
+        total += 1.0 / pow(rank + 1, config.zipf_exponent);
+        bench->popularity[rank] = total;
+        bench->player_ids[rank] = rank + 1;
+    }
+    for(int rank = 0; rank < config.num_of_players; rank++) {
+        bench->popularity[rank] /= total;
+    }
+    for(int rank = config.num_of_players - 1; rank > 0; rank--) {
+        int other = (int)(benchRandom(bench) % (rank + 1));
+        int id = bench->player_ids[rank];
+        bench->player_ids[rank] = bench->player_ids[other];
+        bench->player_ids[other] = id;
+    }
+    return true;
+}
+
+static void benchDestroy(Bench* bench)
+{
+    chessDestroy(bench->chess);
+    free(bench->popularity);
+    free(bench->player_ids);
+    for(int i = 0; i < BENCH_NUM_OPERATIONS; i++) {
+        histogramDestroy(bench->latencies[i]);
+    }
+}
+
+static void benchRun(Bench* bench)
+{
+    BenchConfig* config = &bench->config;
+    int num_of_locations = sizeof(locations) / sizeof(*locations);
+    int open[BENCH_OPEN_TOURNAMENTS];
+    int games_left[BENCH_OPEN_TOURNAMENTS];
+    int num_of_open = 0;
+    int next_tournament = 1;
+    while(num_of_open > 0 || next_tournament <= config->num_of_tournaments)
+    {
+        while(num_of_open < BENCH_OPEN_TOURNAMENTS && next_tournament <= config->num_of_tournaments) {
+            long long start = benchNow();
+            ChessResult result = chessAddTournament(bench->chess, next_tournament, config->max_games_per_player,
+                                                    locations[next_tournament % num_of_locations]);
+            benchRecord(bench, BENCH_ADD_TOURNAMENT, start, result);
+            open[num_of_open] = next_tournament++;
+            games_left[num_of_open++] = config->games_per_tournament;
+        }
+        int slot = (int)(benchRandom(bench) % num_of_open);
+        int first_player = benchPlayer(bench);
+        int second_player = benchPlayer(bench);
+        while(second_player == first_player) {
+            second_player = benchPlayer(bench);
+        }
+        int outcome = (int)(benchRandom(bench) % BENCH_PERCENT);
+        Winner winner = outcome < BENCH_DRAW_PERCENT ? DRAW : outcome % 2 == 0 ? FIRST_PLAYER : SECOND_PLAYER;
+        int play_time = 1 + (int)(benchRandom(bench) % BENCH_MAX_PLAY_TIME);
+        long long start = benchNow();
+        ChessResult result = chessAddGame(bench->chess, open[slot], first_player, second_player, winner, play_time);
+        benchRecord(bench, BENCH_ADD_GAME, start, result);
+        if(--games_left[slot] == 0) {
+            benchCloseTournament(bench, open[slot]);
+            open[slot] = open[num_of_open - 1];
+            games_left[slot] = games_left[num_of_open - 1];
+            num_of_open--;
+        }
+        if(benchUniform(bench) < config->player_removal_rate) {
+            start = benchNow();
+            result = chessRemovePlayer(bench->chess, benchPlayer(bench));
+            benchRecord(bench, BENCH_REMOVE_PLAYER, start, result);
+        }
+        for(double queries = config->query_rate; queries > 0; queries--) {
+            if(queries < 1 && benchUniform(bench) >= queries) {
+                break;
+            }
+            ChessPlayerStatistics statistics;
+            start = benchNow();
+            result = chessGetPlayerStats(bench->chess, benchPlayer(bench), &statistics);
+            benchRecord(bench, BENCH_GET_PLAYER_STATS, start, result);
+            start = benchNow();
+            chessCalculateAveragePlayTime(bench->chess, benchPlayer(bench), &result);
+            benchRecord(bench, BENCH_AVERAGE_PLAY_TIME, start, result);
+        }
+    }
+    FILE* levels = tmpfile();
+    long long start = benchNow();
+    ChessResult result = chessSavePlayersLevels(bench->chess, levels);
+    benchRecord(bench, BENCH_SAVE_PLAYERS_LEVELS, start, result);
+    if(levels != NULL) {
+        fclose(levels);
+    }
+    start = benchNow();
+    result = chessSaveTournamentStatistics(bench->chess, config->statistics_path);
+    benchRecord(bench, BENCH_SAVE_TOURNAMENT_STATISTICS, start, result);
+}
+
+static void benchCloseTournament(Bench* bench, int tournament_id)
+{
+    long long start = benchNow();
+    ChessResult result = chessEndTournament(bench->chess, tournament_id);
+    benchRecord(bench, BENCH_END_TOURNAMENT, start, result);
+    if(benchUniform(bench) < bench->config.tournament_removal_rate) {
+        start = benchNow();
+        result = chessRemoveTournament(bench->chess, tournament_id);
+        benchRecord(bench, BENCH_REMOVE_TOURNAMENT, start, result);
+    }
+}
+
+static long long benchNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+static void benchRecord(Bench* bench, BenchOperation operation, long long start, ChessResult result)
+{
+    histogramRecord(bench->latencies[operation], benchNow() - start);
+    if(result == CHESS_SUCCESS) {
+        bench->successes[operation]++;
+    }
+}
+
+static void benchReport(Bench* bench, long long elapsed_ns)
+{
+    printf("%-30s %10s %10s %12s %10s %10s %10s %10s %10s %10s\n", "operation", "calls", "successes",
+           "ops_per_sec", "mean_us", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+    long long total_calls = 0;
+    for(int operation = 0; operation < BENCH_NUM_OPERATIONS; operation++) {
+        Histogram latencies = bench->latencies[operation];
+        long long calls = histogramGetCount(latencies);
+        if(calls == 0) {
+            continue;
+        }
+        total_calls += calls;
+        long long total_ns = histogramGetTotal(latencies);
+        printf("%-30s %10lld %10lld %12.0f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+               operation_names[operation], calls, bench->successes[operation],
+               total_ns > 0 ? calls * (double)NANOSECONDS_PER_SECOND / total_ns : 0,
+               total_ns / NANOSECONDS_PER_MICROSECOND / calls,
+               histogramGetPercentile(latencies, 50.0) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetPercentile(latencies, 90.0) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetPercentile(latencies, 99.0) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetPercentile(latencies, 99.9) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetMax(latencies) / NANOSECONDS_PER_MICROSECOND);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("total calls=%lld elapsed_s=%.3f ops_per_sec=%.0f peak_rss_mb=%.1f\n", total_calls,
+           elapsed_ns / (double)NANOSECONDS_PER_SECOND,
+           elapsed_ns > 0 ? total_calls * (double)NANOSECONDS_PER_SECOND / elapsed_ns : 0,
+           usage.ru_maxrss / KILOBYTES_PER_MEGABYTE);
+}
+
+static unsigned long long benchRandom(Bench* bench)
+{
+    bench->random_state ^= bench->random_state >> 12;
+    bench->random_state ^= bench->random_state << 25;
+    bench->random_state ^= bench->random_state >> 27;
+    return bench->random_state * 2685821657736338717ULL;
+}
+
+static double benchUniform(Bench* bench)
+{
+    return (benchRandom(bench) >> (64 - BENCH_FRACTION_BITS)) / (double)(1ULL << BENCH_FRACTION_BITS);
+}
+
+static int benchPlayer(Bench* bench)
+{
+    double value = benchUniform(bench);
+    int low = 0, high = bench->config.num_of_players - 1;
+    while(low < high) {
+        int middle = low + (high - low) / 2;
+        if(bench->popularity[middle] <= value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return bench->player_ids[low];
+}
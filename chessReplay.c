@@ -0,0 +1,397 @@
+#define _POSIX_C_SOURCE 200809L
+#include "chessSystemExtended.h"
+#include "callTrace.h"
+#include "histogram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REPLAY_DEFAULT_OUTPUT_PATH "chessReplay.out"
+#define REPLAY_FEED_SUFFIX ".feed"
+#define REPLAY_MAX_REPORTED_MISMATCHES 10
+#define REPLAY_INITIAL_RESULTS 16
+#define REPLAY_GROWTH_FACTOR 2
+#define NANOSECONDS_PER_SECOND 1000000000LL
+#define NANOSECONDS_PER_MICROSECOND 1000.0
+#define NULLS 0
+#define FIRST_VALUE 1
+#define SECOND_VALUE 2
+#define THIRD_VALUE 3
+#define FOURTH_VALUE 4
+#define FIFTH_VALUE 5
+#define TOURNAMENT_VALUES 3
+#define GAME_VALUES 6
+#define ID_VALUES 2
+#define TOURNAMENT_PLAYER_VALUES 3
+#define INGEST_VALUES 2
+#define FEED_NOT_OPENED 0
+#define FEED_NOT_RECORDED 2
+#define FEED_RECORD_VALUES 6
+
+// the outputs of the replayed calls go to scratch files, so a trace never writes over the files it has recorded.
+// the feeds of chessIngestFile are written from the records of the trace to a scratch feed, so the replay
+// does not depend on the files that were ingested
+typedef struct replay_t {
+    ChessSystem chess;
+    char* output_path;
+    char* feed_path;
+    FILE* output;
+    ChessResult* results;
+    int results_capacity;
+    Histogram latencies[CHESS_NUM_APIS];
+    long long mismatches[CHESS_NUM_APIS];
+    long long num_of_calls;
+    long long num_of_mismatches;
+    long long replay_ns;
+} Replay;
+
+/* allocate the system, the scratch file and the histograms. false if allocation failed */
+static bool replayCreate(Replay* replay, char* output_path);
+
+/* deallocate everything that replayCreate has allocated, and remove the scratch file */
+static void replayDestroy(Replay* replay);
+
+/* run one call of the trace, and record its latency and whether it returned the recorded result.
+ * false if the call is not a call of a known function */
+static bool replayCall(Replay* replay, const TraceCall* call);
+
+/* run a call against the system, and put its result. false if the call is not a call of a known function */
+static bool replayRun(Replay* replay, const TraceCall* call, ChessResult* result);
+
+/* check that a call has the number of values of its function */
+static bool replayHasValues(const TraceCall* call, int num_of_values);
+
+/* the pointer of an argument, or NULL if it was NULL in the recorded call */
+static void* replayArgument(const TraceCall* call, int position, void* pointer);
+
+/* write the records of a call of chessIngestFile to the scratch feed, and return the path to ingest:
+ * the scratch feed (removed if the recorded feed was not opened), or the recorded path if the call
+ * was traced without its records */
+static const char* replayFeed(Replay* replay, const TraceCall* call);
+
+/* make sure the results array of chessEndTournaments can hold the results of a call */
+static bool replayReserveResults(Replay* replay, int num_of_results);
+
+/* the current time in nanoseconds */
+static long long replayNow();
+
+/* print the number of calls, the mismatches and the latency percentiles of every function */
+static void replayReport(Replay* replay, long long elapsed_ns);
+
+int main(int argc, char** argv)
+{
+    char* output_path = REPLAY_DEFAULT_OUTPUT_PATH;
+    int option;
+    while((option = getopt(argc, argv, "o:")) != -1)
+    {
+        if(option != 'o') {
+            optind = argc + 1;
+            break;
+        }
+        output_path = optarg;
+    }
+    if(optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-o output file] trace_file\n"
+                        "the outputs of the saves of the trace are written to the output file.\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    TraceReader reader = NULL;
+    CallTraceResult trace_result = traceReaderCreate(argv[optind], &reader);
+    if(trace_result != TRACE_SUCCESS) {
+        fprintf(stderr, "%s: %s\n", argv[optind],
+                trace_result == TRACE_BAD_FORMAT ? "not a trace of this version" : "cannot read the trace");
+        return EXIT_FAILURE;
+    }
+    Replay replay;
+    if(replayCreate(&replay, output_path) == false) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        traceReaderDestroy(reader);
+        return EXIT_FAILURE;
+    }
+    bool valid = true;
+    TraceCall call;
+    long long start = replayNow();
+    while(valid && (trace_result = traceReaderNext(reader, &call)) == TRACE_SUCCESS) {
+        valid = replayCall(&replay, &call);
+    }
+    long long elapsed_ns = replayNow() - start;
+    traceReaderDestroy(reader);
+    if(valid == false) {
+        fprintf(stderr, "%s: call %lld is not a call of a known function\n", argv[optind], replay.num_of_calls + 1);
+    } else if(trace_result == TRACE_BAD_FORMAT) {
+        fprintf(stderr, "%s: the trace ends with a torn call after %lld calls\n", argv[optind], replay.num_of_calls);
+    } else if(trace_result != TRACE_END) {
+        fprintf(stderr, "%s: cannot read the trace after %lld calls\n", argv[optind], replay.num_of_calls);
+        valid = false;
+    }
+    replayReport(&replay, elapsed_ns);
+    bool matched = replay.num_of_mismatches == 0;
+    replayDestroy(&replay);
+    return valid && matched ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static bool replayCreate(Replay* replay, char* output_path)
+{
+    replay->chess = chessCreate();
+    replay->output_path = output_path;
+    replay->feed_path = malloc(strlen(output_path) + strlen(REPLAY_FEED_SUFFIX) + 1);
+    if(replay->feed_path != NULL) {
+        sprintf(replay->feed_path, "%s%s", output_path, REPLAY_FEED_SUFFIX);
+    }
+    replay->output = tmpfile();
+    replay->results = malloc(REPLAY_INITIAL_RESULTS * sizeof(*replay->results));
+    replay->results_capacity = REPLAY_INITIAL_RESULTS;
+    replay->num_of_calls = 0;
+    replay->num_of_mismatches = 0;
+    replay->replay_ns = 0;
+    bool allocated = replay->chess != NULL && replay->feed_path != NULL && replay->output != NULL &&
+                     replay->results != NULL;
+    for(int i = 0; i < CHESS_NUM_APIS; i++) {
+        replay->latencies[i] = histogramCreate();
+        replay->mismatches[i] = 0;
+        allocated = allocated && replay->latencies[i] != NULL;
+    }
+    if(allocated == false) {
+        replayDestroy(replay);
+        return false;
+    }
+    return true;
+}
+
+static void replayDestroy(Replay* replay)
+{
+    chessDestroy(replay->chess);
+    if(replay->output != NULL) {
+        fclose(replay->output);
+    }
+    free(replay->results);
+    for(int i = 0; i < CHESS_NUM_APIS; i++) {
+        histogramDestroy(replay->latencies[i]);
+    }
+    remove(replay->output_path);
+    if(replay->feed_path != NULL) {
+        remove(replay->feed_path);
+        free(replay->feed_path);
+    }
+}
+
+static bool replayCall(Replay* replay, const TraceCall* call)
+{
+    if(call->function < 0 || call->function >= CHESS_NUM_APIS || call->num_of_values <= NULLS) {
+        return false;
+    }
+    if(call->function == CHESS_API_SAVE_PLAYERS_LEVELS || call->function == CHESS_API_SAVE_PLAYERS_LEVELS_DELTA) {
+        rewind(replay->output);
+    }
+    ChessResult result;
+    long long start = replayNow();
+    if(replayRun(replay, call, &result) == false) {
+        return false;
+    }
+    long long latency = replayNow() - start;
+    histogramRecord(replay->latencies[call->function], latency);
+    replay->replay_ns += latency;
+    replay->num_of_calls++;
+    if((int)result != call->result) {
+        if(replay->num_of_mismatches < REPLAY_MAX_REPORTED_MISMATCHES) {
+            fprintf(stderr, "call %lld: %s returned %d, the trace has %d\n", replay->num_of_calls,
+                    chessGetApiName(call->function), result, call->result);
+        }
+        replay->mismatches[call->function]++;
+        replay->num_of_mismatches++;
+    }
+    return true;
+}
+
+static bool replayRun(Replay* replay, const TraceCall* call, ChessResult* result)
+{
+    ChessSystem chess = replay->chess;
+    const int* values = call->values;
+    int num_of_items = 0;
+    ChessPlayerStatistics player_statistics;
+    ChessLocationStatistics location_statistics;
+    int* tournament_ids = NULL;
+    switch(call->function) {
+        case CHESS_API_ADD_TOURNAMENT:
+            if(replayHasValues(call, TOURNAMENT_VALUES) == false) {
+                return false;
+            }
+            *result = chessAddTournament(chess, values[FIRST_VALUE], values[SECOND_VALUE], call->text);
+            return true;
+        case CHESS_API_ADD_GAME:
+            if(replayHasValues(call, GAME_VALUES) == false) {
+                return false;
+            }
+            *result = chessAddGame(chess, values[FIRST_VALUE], values[SECOND_VALUE], values[THIRD_VALUE],
+                                   (Winner)values[FOURTH_VALUE], values[FIFTH_VALUE]);
+            return true;
+        case CHESS_API_REMOVE_TOURNAMENT:
+            if(replayHasValues(call, ID_VALUES) == false) {
+                return false;
+            }
+            *result = chessRemoveTournament(chess, values[FIRST_VALUE]);
+            return true;
+        case CHESS_API_END_TOURNAMENT:
+            if(replayHasValues(call, ID_VALUES) == false) {
+                return false;
+            }
+            *result = chessEndTournament(chess, values[FIRST_VALUE]);
+            return true;
+        case CHESS_API_REMOVE_PLAYER:
+            if(replayHasValues(call, ID_VALUES) == false) {
+                return false;
+            }
+            *result = chessRemovePlayer(chess, values[FIRST_VALUE]);
+            return true;
+        case CHESS_API_END_TOURNAMENTS:
+            if(replayHasValues(call, ID_VALUES) == false ||
+               replayReserveResults(replay, values[FIRST_VALUE]) == false) {
+                return false;
+            }
+            *result = chessEndTournaments(chess, replayArgument(call, 0, (int*)call->items), values[FIRST_VALUE],
+                                          replayArgument(call, 1, replay->results));
+            return true;
+        case CHESS_API_AVERAGE_PLAY_TIME:
+            if(replayHasValues(call, ID_VALUES) == false) {
+                return false;
+            }
+            // the result of a player without games is left as it was, so it starts as the recorded one
+            *result = call->result;
+            chessCalculateAveragePlayTime(chess, values[FIRST_VALUE], replayArgument(call, 0, result));
+            return true;
+        case CHESS_API_SAVE_PLAYERS_LEVELS:
+            *result = chessSavePlayersLevels(chess, replayArgument(call, 0, replay->output));
+            return true;
+        case CHESS_API_SAVE_PLAYERS_LEVELS_DELTA:
+            *result = chessSavePlayersLevelsDelta(chess, replayArgument(call, 0, replay->output),
+                                                  replayArgument(call, 1, &num_of_items));
+            return true;
+        case CHESS_API_SAVE_TOURNAMENT_STATISTICS:
+            *result = chessSaveTournamentStatistics(chess, replayArgument(call, 0, replay->output_path));
+            return true;
+        case CHESS_API_SAVE_TOURNAMENT_STATISTICS_DELTA:
+            *result = chessSaveTournamentStatisticsDelta(chess, replayArgument(call, 0, replay->output_path),
+                                                         replayArgument(call, 1, &num_of_items));
+            return true;
+        case CHESS_API_SAVE_SNAPSHOT:
+            *result = chessSaveSnapshot(chess, replayArgument(call, 0, replay->output_path));
+            return true;
+        case CHESS_API_INGEST_FILE:
+            if(replayHasValues(call, INGEST_VALUES) == false || call->num_of_items % FEED_RECORD_VALUES != 0) {
+                return false;
+            }
+            *result = chessIngestFile(chess, replayArgument(call, 0, (char*)replayFeed(replay, call)), NULL, NULL,
+                                      replayArgument(call, 1, &num_of_items));
+            return true;
+        case CHESS_API_GET_TOURNAMENTS_AT_LOCATION:
+            *result = chessGetTournamentsAtLocation(chess, call->text, replayArgument(call, 1, &tournament_ids),
+                                                    replayArgument(call, 2, &num_of_items));
+            free(tournament_ids);
+            return true;
+        case CHESS_API_GET_LOCATION_STATISTICS:
+            *result = chessGetLocationStatistics(chess, call->text, replayArgument(call, 1, &location_statistics));
+            return true;
+        case CHESS_API_GET_PLAYER_STATS:
+            if(replayHasValues(call, ID_VALUES) == false) {
+                return false;
+            }
+            *result = chessGetPlayerStats(chess, values[FIRST_VALUE], replayArgument(call, 0, &player_statistics));
+            return true;
+        case CHESS_API_GET_TOURNAMENT_PLAYER_STATS:
+            if(replayHasValues(call, TOURNAMENT_PLAYER_VALUES) == false) {
+                return false;
+            }
+            *result = chessGetTournamentPlayerStats(chess, values[FIRST_VALUE], values[SECOND_VALUE],
+                                                    replayArgument(call, 0, &player_statistics));
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool replayHasValues(const TraceCall* call, int num_of_values)
+{
+    return call->num_of_values == num_of_values;
+}
+
+static void* replayArgument(const TraceCall* call, int position, void* pointer)
+{
+    return (call->values[NULLS] & (1 << position)) != 0 ? NULL : pointer;
+}
+
+static const char* replayFeed(Replay* replay, const TraceCall* call)
+{
+    if(call->values[FIRST_VALUE] == FEED_NOT_RECORDED) {
+        return call->text;
+    }
+    remove(replay->feed_path);
+    if(call->values[FIRST_VALUE] == FEED_NOT_OPENED) {
+        return replay->feed_path;
+    }
+    // a line that is not valid is written as a line that is not five integers, so it is not valid again
+    FILE* feed = fopen(replay->feed_path, "w");
+    for(int i = 0; feed != NULL && i < call->num_of_items; i += FEED_RECORD_VALUES) {
+        const int* record = call->items + i;
+        if(record[0]) {
+            fprintf(feed, "%d %d %d %d %d\n", record[1], record[2], record[3], record[4], record[5]);
+        } else {
+            fprintf(feed, "-\n");
+        }
+    }
+    if(feed != NULL) {
+        fclose(feed);
+    }
+    return replay->feed_path;
+}
+
+static bool replayReserveResults(Replay* replay, int num_of_results)
+{
+    if(num_of_results <= replay->results_capacity) {
+        return true;
+    }
+    int capacity = replay->results_capacity * REPLAY_GROWTH_FACTOR;
+    capacity = capacity < num_of_results ? num_of_results : capacity;
+    ChessResult* results = realloc(replay->results, capacity * sizeof(*results));
+    if(results == NULL) {
+        return false;
+    }
+    replay->results = results;
+    replay->results_capacity = capacity;
+    return true;
+}
+
+static long long replayNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+static void replayReport(Replay* replay, long long elapsed_ns)
+{
+    printf("%-34s %10s %10s %12s %10s %10s %10s %10s %10s %10s\n", "function", "calls", "mismatches",
+           "ops_per_sec", "mean_us", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+    for(int api = 0; api < CHESS_NUM_APIS; api++) {
+        Histogram latencies = replay->latencies[api];
+        long long calls = histogramGetCount(latencies);
+        if(calls == 0) {
+            continue;
+        }
+        long long total_ns = histogramGetTotal(latencies);
+        printf("%-34s %10lld %10lld %12.0f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+               chessGetApiName(api), calls, replay->mismatches[api],
+               total_ns > 0 ? calls * (double)NANOSECONDS_PER_SECOND / total_ns : 0,
+               total_ns / NANOSECONDS_PER_MICROSECOND / calls,
+               histogramGetPercentile(latencies, 50.0) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetPercentile(latencies, 90.0) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetPercentile(latencies, 99.0) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetPercentile(latencies, 99.9) / NANOSECONDS_PER_MICROSECOND,
+               histogramGetMax(latencies) / NANOSECONDS_PER_MICROSECOND);
+    }
+    printf("total calls=%lld mismatches=%lld calls_s=%.3f elapsed_s=%.3f ops_per_sec=%.0f\n",
+           replay->num_of_calls, replay->num_of_mismatches, replay->replay_ns / (double)NANOSECONDS_PER_SECOND,
+           elapsed_ns / (double)NANOSECONDS_PER_SECOND,
+           elapsed_ns > 0 ? replay->num_of_calls * (double)NANOSECONDS_PER_SECOND / elapsed_ns : 0);
+}
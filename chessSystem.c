@@ -1,22 +1,185 @@
+#define _POSIX_C_SOURCE 200809L
 #include "games.h"
 #include "tournament.h"
+#include "chessSystemExtended.h"
+#include "operationLog.h"
+#include "gameFeed.h"
+#include "histogram.h"
+#include "callTrace.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <time.h>
 
 #define DUMMY_LIMB_ID (-1)
 #define MIN 1
 #define NOT_VALID 0
 #define MIN_PRINT_SUCCESS 0
 #define NO_GAMES 0
+#define PARALLEL_EXPORT_MIN_PLAYERS (1 << 16)
+#define PARALLEL_END_MIN_TOURNAMENTS 64
+#define PARALLEL_STATISTICS_MIN_TOURNAMENTS 1024
+#define PARALLEL_INGEST_MIN_GAMES 256
+#define THREAD_PER_PROCESSOR 0
+#define TOURNAMENT_SHARDS 16
+#define MIN_TOURNAMENT_RECORD_SIZE 49
+#define FEED_DRAW 0
+#define NANOSECONDS_PER_SECOND 1000000000LL
+#define NANOSECONDS_PER_MICROSECOND 1000.0
+#define TRACE_NO_NULLS 0
+#define TRACE_NULL(pointer, position) ((pointer) == NULL ? 1 << (position) : 0)
+#define TRACE_FEED_NOT_OPENED 0
+#define TRACE_FEED_RECORDED 1
+#define TRACE_FEED_NOT_RECORDED 2
+#define TRACE_FEED_RECORD_VALUES 6
+#define TRACE_FEED_INITIAL_CAPACITY (FEED_BATCH_SIZE * TRACE_FEED_RECORD_VALUES)
+#define TRACE_FEED_GROWTH_FACTOR 2
 
+// a function that receives the events of the system
+typedef struct ChessSubscriber_t {
+    int id;
+    ChessEventFunction on_event;
+    void* context;
+} ChessSubscriber;
+
+// the tournaments are split into shards by id, each with its own lock, so chessAddGame calls
+// for tournaments of different shards run in parallel. the external players have a lock of their own,
+// held only while their results are updated. a lock of a shard is always taken before the external lock.
 struct chess_system_t{
-    Map tournaments;
+    Map tournaments[TOURNAMENT_SHARDS];
+    pthread_mutex_t shard_locks[TOURNAMENT_SHARDS];
     Map external_players;
+    PlayerRemovals removed_players;
+    pthread_mutex_t external_lock;
+    TourIndex tournament_index;
+    ThreadPool pool;
+    OperationLog log;
+    CallTrace trace;
+    ChessSubscriber* subscribers;
+    int num_of_subscribers;
+    int next_subscription_id;
+    pthread_rwlock_t subscribers_lock;
+#ifndef CHESS_NO_METRICS
+    Histogram latencies[CHESS_NUM_APIS];
+    long long result_counts[CHESS_NUM_APIS][CHESS_NUM_RESULTS];
+#endif
+};
+
+// an export of the levels owns a copy of the external players, so the system may change while it is written
+struct chess_levels_export_t{
+    pthread_t writer;
+    bool has_writer;
+    PlayerTable table;
+    FILE* file;
+    pthread_mutex_t lock;
+    bool done;
+    ChessResult result;
 };
 
 
+// returns the shard of the tournaments map that holds the tournament
+
+static Map chessGetShard(ChessSystem chess, int tournament_id);
+
+// returns the lock of the shard that holds the tournament
+
+static pthread_mutex_t* chessGetShardLock(ChessSystem chess, int tournament_id);
+
+// reads the tournaments and the external players of a snapshot into a new system
+
+static ChessResult chessLoadSnapshotData(ChessSystem chess, SnapshotReader reader);
+
+// appends a successful mutating call to the log of the system, if it has one
+
+static void chessLog(ChessSystem chess, LogRecord record);
+
+// replays a record of the log on the system (the context)
+
+static void chessReplayRecord(const LogRecord* record, void* chess);
+
+// sends an event to all the subscribers of the system
+
+static void chessPublish(ChessSystem chess, const ChessEvent* event);
+
+// checks if the system has subscribers, without taking their lock
+
+static bool chessHasSubscribers(ChessSystem chess);
+
+// the common fields of the events of the changes of results that one call sends
+
+typedef struct ChessStatsEvent_t {
+    ChessSystem chess;
+    int tournament_id;
+    int opponent_id;
+    int factor;
+} ChessStatsEvent;
+
+// sends a change of the results of a player (multiplied by the factor of the context) to the subscribers
+
+static void chessPublishPlayerStats(int player_id, PlayerStats stats, void* stats_event);
+
+// a batch of feed records that chessIngestFile applies, and the result of every record
+
+typedef struct ChessIngestBatch_t {
+    ChessSystem chess;
+    const GameFeedRecord* records;
+    int num_of_records;
+    ChessResult* results;
+} ChessIngestBatch;
+
+// the records that a traced chessIngestFile has read, so the trace holds the feed and a replay does not read
+// the file again: for every record whether it is valid and its five integers. the state is
+// TRACE_FEED_NOT_OPENED until the feed is opened, and TRACE_FEED_NOT_RECORDED if the records could not be kept
+
+typedef struct ChessIngestTrace_t {
+    int state;
+    int* items;
+    int num_of_items;
+    int capacity;
+} ChessIngestTrace;
+
+// appends the records of a batch to the trace of an ingest, if it is traced
+
+static void chessTraceFeedRecords(ChessIngestTrace* trace, const GameFeedRecord* records, int num_of_records);
+
+// adds the game of a feed record. CHESS_INVALID_ID for a line that is not valid,
+// or a winner that is neither of the players nor a draw
+
+static ChessResult chessIngestRecord(ChessSystem chess, const GameFeedRecord* record);
+
+// returns the shard of the tournament of a feed record, 0 for a record without a valid tournament id
+
+static int chessIngestShard(const GameFeedRecord* record);
+
+// adds the games of a batch (the context) that belong to one shard, in the order of the batch
+
+static void chessIngestShardTask(int shard, void* batch);
+
+// writes the levels of an export (the argument) to its file, on the thread of the export
+
+static void* chessExportLevels(void* levels_export);
+
+// returns the thread pool of the system, creates it on the first use.
+// NULL (run on the calling thread) if it could not be created
+
+static ThreadPool chessGetPool(ChessSystem chess);
+
+// returns the time of the monotonic clock in nanoseconds, for the start of a measured call
+
+static long long chessMetricsStart();
+
+// records the latency and the result of a measured call of a public function
+
+static void chessMetricsRecord(ChessSystem chess, ChessApi api, long long start, ChessResult result);
+
+// records a call of a public function in the trace of the system, if it is traced. the first value of
+// the call is a mask of its pointer arguments that were NULL (TRACE_NULL), then its integer arguments
+
+static void chessTraceCall(ChessSystem chess, TraceCall call);
+
 // Checks whether the tournament_location meets the given requirements
 
 static bool isTourLocationValid(const char* tournament_location);
@@ -31,6 +194,10 @@ static ChessResult chessAddGamesResults(ChessSystem chess, int tournament_id ,
 
 static ChessResult PlayerLevelsResult(PlayerNodeResult result);
 
+// copies the results of a player to the statistics that are returned to the user
+
+static void chessSetPlayerStatistics(ChessPlayerStatistics* statistics, PlayerStats stats);
+
 //converts TournamentResult to ChessResult
 
 static ChessResult convertTourToChess(TournamentResult tour_result);
@@ -41,16 +208,60 @@ ChessSystem chessCreate() {
     {
         return NULL;
     }
-    new_chess_system->tournaments = tournamentCreateNew();
-    if(new_chess_system->tournaments == NULL){
+    new_chess_system->pool = NULL;
+    new_chess_system->log = NULL;
+    new_chess_system->trace = NULL;
+    new_chess_system->external_players = NULL;
+    new_chess_system->removed_players = NULL;
+    new_chess_system->tournament_index = NULL;
+    new_chess_system->subscribers = NULL;
+    new_chess_system->num_of_subscribers = 0;
+    new_chess_system->next_subscription_id = MIN;
+    pthread_rwlock_init(&new_chess_system->subscribers_lock, NULL);
+#ifndef CHESS_NO_METRICS
+    for (int i = 0; i < CHESS_NUM_APIS; ++i) {
+        new_chess_system->latencies[i] = NULL;
+        for (int j = 0; j < CHESS_NUM_RESULTS; ++j) {
+            new_chess_system->result_counts[i][j] = 0;
+        }
+    }
+#endif
+    pthread_mutex_init(&new_chess_system->external_lock, NULL);
+    for (int i = 0; i < TOURNAMENT_SHARDS; ++i) {
+        pthread_mutex_init(&new_chess_system->shard_locks[i], NULL);
+        new_chess_system->tournaments[i] = NULL;
+    }
+    for (int i = 0; i < TOURNAMENT_SHARDS; ++i) {
+        new_chess_system->tournaments[i] = tournamentCreateNew();
+        if(new_chess_system->tournaments[i] == NULL){
+            chessDestroy(new_chess_system);
+            return NULL;
+        }
+    }
+    new_chess_system->external_players = playersCreateMap(NULL);
+    if(new_chess_system->external_players == NULL){
+        chessDestroy(new_chess_system);
+        return NULL;
+    }
+    new_chess_system->removed_players = playerRemovalsCreate();
+    if(new_chess_system->removed_players == NULL){
         chessDestroy(new_chess_system);
         return NULL;
     }
-    new_chess_system->external_players = playersCreateMap();
-    if(new_chess_system->external_players == NULL){
+    new_chess_system->tournament_index = tournamentCreateIndex();
+    if(new_chess_system->tournament_index == NULL){
         chessDestroy(new_chess_system);
         return NULL;
     }
+#ifndef CHESS_NO_METRICS
+    for (int i = 0; i < CHESS_NUM_APIS; ++i) {
+        new_chess_system->latencies[i] = histogramCreate();
+        if(new_chess_system->latencies[i] == NULL){
+            chessDestroy(new_chess_system);
+            return NULL;
+        }
+    }
+#endif
     return new_chess_system;
 }
 
@@ -59,14 +270,30 @@ void chessDestroy(ChessSystem chess){
     {
         return;
     }
-    mapDestroy(chess->tournaments);
+    for (int i = 0; i < TOURNAMENT_SHARDS; ++i) {
+        mapDestroy(chess->tournaments[i]);
+        pthread_mutex_destroy(&chess->shard_locks[i]);
+    }
     mapDestroy(chess->external_players);
+    playerRemovalsDestroy(chess->removed_players);
+    pthread_mutex_destroy(&chess->external_lock);
+    tournamentDestroyIndex(chess->tournament_index);
+    threadPoolDestroy(chess->pool);
+    operationLogClose(chess->log);
+    callTraceClose(chess->trace);
+    free(chess->subscribers);
+    pthread_rwlock_destroy(&chess->subscribers_lock);
+#ifndef CHESS_NO_METRICS
+    for (int i = 0; i < CHESS_NUM_APIS; ++i) {
+        histogramDestroy(chess->latencies[i]);
+    }
+#endif
     free(chess);
 }
 
 
-ChessResult chessAddTournament (ChessSystem chess, int tournament_id, int max_games_per_player,
-                                const char* tournament_location){
+static ChessResult chessAddTournamentUnmeasured(ChessSystem chess, int tournament_id, int max_games_per_player,
+                                                const char* tournament_location){
     if(chess == NULL || tournament_location == NULL){
         return CHESS_NULL_ARGUMENT;
     }
@@ -75,18 +302,32 @@ ChessResult chessAddTournament (ChessSystem chess, int tournament_id, int max_ga
     if(result1 != CHESS_SUCCESS){
         return result1;
     }
-    TournamentResult result = tournamentAdd(chess->tournaments,tournament_id,
+    TournamentResult result = tournamentAdd(chessGetShard(chess, tournament_id),chess->tournament_index,tournament_id,
                                             tournament_location,max_games_per_player);
     if(result == TOUR_MEMORY_PROBLEM)
     {
         return CHESS_OUT_OF_MEMORY;
     }
+    chessLog(chess , (LogRecord){LOG_ADD_TOURNAMENT , 2 , {tournament_id , max_games_per_player} ,
+                                 tournament_location});
     return CHESS_SUCCESS;
 }
 
+ChessResult chessAddTournament (ChessSystem chess, int tournament_id, int max_games_per_player,
+                                const char* tournament_location){
+    long long start = chessMetricsStart();
+    ChessResult result = chessAddTournamentUnmeasured(chess , tournament_id , max_games_per_player ,
+                                                      tournament_location);
+    chessMetricsRecord(chess , CHESS_API_ADD_TOURNAMENT , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_ADD_TOURNAMENT , result , 3 ,
+                                       (int[]){TRACE_NULL(tournament_location , 0) , tournament_id ,
+                                               max_games_per_player} , 0 , NULL , tournament_location});
+    return result;
+}
+
 
-ChessResult chessAddGame (ChessSystem chess, int tournament_id, int first_player,
-                         int second_player, Winner winner, int play_time)
+static ChessResult chessAddGameUnmeasured(ChessSystem chess, int tournament_id, int first_player,
+                                         int second_player, Winner winner, int play_time)
 {
     if(chess == NULL){
         return CHESS_NULL_ARGUMENT;
@@ -94,30 +335,90 @@ ChessResult chessAddGame (ChessSystem chess, int tournament_id, int first_player
     if(first_player < MIN || second_player < MIN || first_player == second_player || tournament_id <MIN){
         return CHESS_INVALID_ID;
     }
+    pthread_mutex_t* shard_lock = chessGetShardLock(chess , tournament_id);
+    pthread_mutex_lock(shard_lock);
+    TourData tour_data = NULL;
+    TournamentResult result = tournamentCheckGame(chessGetShard(chess , tournament_id) , tournament_id ,
+                                                  first_player , second_player , play_time , &tour_data);
+    if(result != TOUR_SUCCESS)
+    {
+        // a rejected game is found by the lookups of the check only, nothing was allocated to undo
+        pthread_mutex_unlock(shard_lock);
+        return convertTourToChess(result);
+    }
+    // the game is valid, so the external players are reserved now and the game is committed after them.
+    // the shard lock is held until the commit, so the check stays true. the reservation pins the players,
+    // so a failed commit of another thread does not remove them before this one updates them
     bool first_player_was_allocated = false , second_player_was_allocated =false ;
+    pthread_mutex_lock(&chess->external_lock);
     PlayerNodeResult result_players = playersAdd(chess->external_players , first_player , second_player ,
                                                  &first_player_was_allocated, &second_player_was_allocated);
+    if(result_players == PLAYER_SUCCESS){
+        playersReserve(chess->external_players , first_player , second_player ,
+                       first_player_was_allocated , second_player_was_allocated);
+    }
+    pthread_mutex_unlock(&chess->external_lock);
     if(result_players == PLAYER_MEMORY_FAILED){
+        pthread_mutex_unlock(shard_lock);
         return CHESS_OUT_OF_MEMORY;
     }
-    TournamentResult result = tournamentAddGame(chess->tournaments , tournament_id , first_player,
-                                                second_player , winner , play_time);
+    result = tournamentCommitGame(tour_data , chess->tournament_index , tournament_id , first_player ,
+                                  second_player , winner , play_time);
+    if(result == TOUR_SUCCESS){
+        chessLog(chess , (LogRecord){LOG_ADD_GAME , 5 , {tournament_id , first_player , second_player ,
+                                                         winner , play_time} , NULL});
+    }
+    pthread_mutex_unlock(shard_lock);
+    // the players are still reserved, so the update finds them and cannot fail
+    pthread_mutex_lock(&chess->external_lock);
+    if(result == TOUR_SUCCESS){
+        updateExternalPlayer(chess->external_players , winner , first_player , second_player);
+    }
+    playersRelease(chess->external_players , first_player , second_player , result == TOUR_SUCCESS);
+    pthread_mutex_unlock(&chess->external_lock);
     if(result != TOUR_SUCCESS)
     {
-        if(first_player_was_allocated){
-            mapRemove(chess->external_players, &first_player);
-        }
-        if(second_player_was_allocated){
-            mapRemove(chess->external_players, &second_player);
-        }
         return convertTourToChess(result);
     }
-    updateExternalPlayer(chess->external_players , winner , first_player , second_player);
+    if(chessHasSubscribers(chess))
+    {
+        chessPublish(chess , &(ChessEvent){CHESS_EVENT_GAME_ADDED , tournament_id , first_player , second_player ,
+                                           winner , play_time});
+        ChessStatsEvent first_stats = {chess , tournament_id , second_player , 1};
+        ChessStatsEvent second_stats = {chess , tournament_id , first_player , 1};
+        chessPublishPlayerStats(first_player , (PlayerStats){winner == FIRST_PLAYER , winner == SECOND_PLAYER ,
+                                                             winner == DRAW , 1} , &first_stats);
+        chessPublishPlayerStats(second_player , (PlayerStats){winner == SECOND_PLAYER , winner == FIRST_PLAYER ,
+                                                              winner == DRAW , 1} , &second_stats);
+    }
     return CHESS_SUCCESS;
 }
 
+// the games of chessIngestFile are measured as calls of chessAddGame, but only the call of chessIngestFile
+// is traced, so a replay of the trace adds them once
+static ChessResult chessAddGameMeasured(ChessSystem chess, int tournament_id, int first_player,
+                                       int second_player, Winner winner, int play_time)
+{
+    long long start = chessMetricsStart();
+    ChessResult result = chessAddGameUnmeasured(chess , tournament_id , first_player ,
+                                                second_player , winner , play_time);
+    chessMetricsRecord(chess , CHESS_API_ADD_GAME , start , result);
+    return result;
+}
+
+ChessResult chessAddGame (ChessSystem chess, int tournament_id, int first_player,
+                         int second_player, Winner winner, int play_time)
+{
+    ChessResult result = chessAddGameMeasured(chess , tournament_id , first_player ,
+                                              second_player , winner , play_time);
+    chessTraceCall(chess , (TraceCall){CHESS_API_ADD_GAME , result , 6 ,
+                                       (int[]){TRACE_NO_NULLS , tournament_id , first_player , second_player ,
+                                               winner , play_time}});
+    return result;
+}
 
-ChessResult chessRemoveTournament (ChessSystem chess, int tournament_id){
+
+static ChessResult chessRemoveTournamentUnmeasured(ChessSystem chess, int tournament_id){
     if(chess == NULL)
     {
         return CHESS_NULL_ARGUMENT;
@@ -126,15 +427,38 @@ ChessResult chessRemoveTournament (ChessSystem chess, int tournament_id){
     {
         return CHESS_INVALID_ID;
     }
-    if(mapContains(chess->tournaments , &tournament_id) == false)
+    if(mapContains(chessGetShard(chess , tournament_id) , &tournament_id) == false)
     {
         return CHESS_TOURNAMENT_NOT_EXIST;
     }
-    tournamentDestroy(chess->tournaments , chess->external_players , tournament_id);
+    bool has_subscribers = chessHasSubscribers(chess);
+    if(has_subscribers)
+    {
+        // the results of the tournament are taken away from its players
+        ChessStatsEvent stats_event = {chess , tournament_id , 0 , -1};
+        tournamentForEachPlayer(chessGetShard(chess , tournament_id) , tournament_id , chessPublishPlayerStats ,
+                                &stats_event);
+    }
+    tournamentDestroy(chessGetShard(chess , tournament_id) , chess->external_players , chess->tournament_index ,
+                      tournament_id);
+    chessLog(chess , (LogRecord){LOG_REMOVE_TOURNAMENT , 1 , {tournament_id} , NULL});
+    if(has_subscribers)
+    {
+        chessPublish(chess , &(ChessEvent){CHESS_EVENT_TOURNAMENT_REMOVED , tournament_id});
+    }
     return CHESS_SUCCESS;
 }
 
-ChessResult chessEndTournament(ChessSystem chess, int tournament_id){
+ChessResult chessRemoveTournament (ChessSystem chess, int tournament_id){
+    long long start = chessMetricsStart();
+    ChessResult result = chessRemoveTournamentUnmeasured(chess , tournament_id);
+    chessMetricsRecord(chess , CHESS_API_REMOVE_TOURNAMENT , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_REMOVE_TOURNAMENT , result , 2 ,
+                                       (int[]){TRACE_NO_NULLS , tournament_id}});
+    return result;
+}
+
+static ChessResult chessEndTournamentUnmeasured(ChessSystem chess, int tournament_id){
     if(chess == NULL)
     {
         return CHESS_NULL_ARGUMENT;
@@ -143,11 +467,12 @@ ChessResult chessEndTournament(ChessSystem chess, int tournament_id){
     {
         return CHESS_INVALID_ID;
     }
-    if(mapContains(chess->tournaments , &tournament_id) == false)
+    if(mapContains(chessGetShard(chess , tournament_id) , &tournament_id) == false)
     {
         return CHESS_TOURNAMENT_NOT_EXIST;
     }
-    TournamentResult result = tournamentEnd (chess->tournaments , tournament_id);
+    TournamentResult result = tournamentEnd (chessGetShard(chess , tournament_id) , chess->tournament_index ,
+                                             tournament_id);
     if(result == TOUR_ENDED)
     {
         return CHESS_TOURNAMENT_ENDED;
@@ -156,10 +481,91 @@ ChessResult chessEndTournament(ChessSystem chess, int tournament_id){
     {
         return CHESS_NO_GAMES;
     }
+    if(result == TOUR_MEMORY_PROBLEM)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    chessLog(chess , (LogRecord){LOG_END_TOURNAMENT , 1 , {tournament_id} , NULL});
+    if(chessHasSubscribers(chess))
+    {
+        chessPublish(chess , &(ChessEvent){CHESS_EVENT_TOURNAMENT_ENDED , tournament_id ,
+                                           tournamentGetWinner(chessGetShard(chess , tournament_id) ,
+                                                               tournament_id)});
+    }
     return CHESS_SUCCESS;
 }
 
-double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessResult *chess_result){
+ChessResult chessEndTournament(ChessSystem chess, int tournament_id){
+    long long start = chessMetricsStart();
+    ChessResult result = chessEndTournamentUnmeasured(chess , tournament_id);
+    chessMetricsRecord(chess , CHESS_API_END_TOURNAMENT , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_END_TOURNAMENT , result , 2 ,
+                                       (int[]){TRACE_NO_NULLS , tournament_id}});
+    return result;
+}
+
+static ChessResult chessEndTournamentsUnmeasured(ChessSystem chess, const int* tournament_ids, int num_of_tournaments,
+                                                 ChessResult* results){
+    if(chess == NULL || (num_of_tournaments > 0 && (tournament_ids == NULL || results == NULL)))
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(num_of_tournaments <= 0)
+    {
+        return CHESS_SUCCESS;
+    }
+    Map* tournaments = malloc(num_of_tournaments * sizeof(*tournaments));
+    TournamentResult* tour_results = malloc(num_of_tournaments * sizeof(*tour_results));
+    if(tournaments == NULL || tour_results == NULL)
+    {
+        free(tournaments);
+        free(tour_results);
+        for (int i = 0; i < num_of_tournaments; ++i) {
+            results[i] = CHESS_OUT_OF_MEMORY;
+        }
+        return CHESS_OUT_OF_MEMORY;
+    }
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        // an invalid id is not in any shard, so any shard reports it as not existing
+        int shard_id = tournament_ids[i] < MIN ? MIN : tournament_ids[i];
+        tournaments[i] = chessGetShard(chess , shard_id);
+    }
+    ThreadPool pool = num_of_tournaments >= PARALLEL_END_MIN_TOURNAMENTS ? chessGetPool(chess) : NULL;
+    TournamentResult result = tournamentEndAll(tournaments , chess->tournament_index , tournament_ids ,
+                                               num_of_tournaments , pool , tour_results);
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        results[i] = tournament_ids[i] < MIN ? CHESS_INVALID_ID : convertTourToChess(tour_results[i]);
+        if(results[i] == CHESS_SUCCESS){
+            chessLog(chess , (LogRecord){LOG_END_TOURNAMENT , 1 , {tournament_ids[i]} , NULL});
+            if(chessHasSubscribers(chess))
+            {
+                chessPublish(chess , &(ChessEvent){CHESS_EVENT_TOURNAMENT_ENDED , tournament_ids[i] ,
+                                                   tournamentGetWinner(tournaments[i] , tournament_ids[i])});
+            }
+        }
+    }
+    free(tournaments);
+    free(tour_results);
+    if(result == TOUR_MEMORY_PROBLEM)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessEndTournaments(ChessSystem chess, const int* tournament_ids, int num_of_tournaments,
+                                ChessResult* results){
+    long long start = chessMetricsStart();
+    ChessResult result = chessEndTournamentsUnmeasured(chess , tournament_ids , num_of_tournaments , results);
+    chessMetricsRecord(chess , CHESS_API_END_TOURNAMENTS , start , result);
+    int num_of_ids = tournament_ids == NULL || num_of_tournaments < 0 ? 0 : num_of_tournaments;
+    chessTraceCall(chess , (TraceCall){CHESS_API_END_TOURNAMENTS , result , 2 ,
+                                       (int[]){TRACE_NULL(tournament_ids , 0) | TRACE_NULL(results , 1) ,
+                                               num_of_tournaments} , num_of_ids , tournament_ids});
+    return result;
+}
+
+static double chessCalculateAveragePlayTimeUnmeasured(ChessSystem chess, int player_id, ChessResult *chess_result){
     if(chess_result == NULL){
         return NOT_VALID;
     }
@@ -178,47 +584,144 @@ double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessRes
     int num_of_games = playerGetNumOfGames(chess->external_players, &player_id);
     if(num_of_games == NO_GAMES)
         return NO_GAMES;
-    double average_time = tournamentCalculateTotalTime (chess->tournaments , player_id);
+    double average_time = tournamentCalculateTotalTime (chess->tournament_index , player_id);
     *chess_result = CHESS_SUCCESS;
     return average_time / (num_of_games);
 }
 
-ChessResult chessSavePlayersLevels (ChessSystem chess, FILE* file){
+double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessResult *chess_result){
+    long long start = chessMetricsStart();
+    double average_time = chessCalculateAveragePlayTimeUnmeasured(chess , player_id , chess_result);
+    if(chess_result != NULL){
+        chessMetricsRecord(chess , CHESS_API_AVERAGE_PLAY_TIME , start , *chess_result);
+    }
+    chessTraceCall(chess , (TraceCall){CHESS_API_AVERAGE_PLAY_TIME ,
+                                       chess_result == NULL ? CHESS_NULL_ARGUMENT : *chess_result , 2 ,
+                                       (int[]){TRACE_NULL(chess_result , 0) , player_id}});
+    return average_time;
+}
+
+static ChessResult chessSavePlayersLevelsUnmeasured(ChessSystem chess, FILE* file){
     if(chess == NULL || file == NULL)
     {
         return CHESS_NULL_ARGUMENT;
     }
-    double level;
+    PlayerTable table = playerTableCreate(chess->external_players);
+    if(table == NULL){
+        return CHESS_OUT_OF_MEMORY;
+    }
     PlayerNodeResult result;
-    playerInitiateStatus(chess->external_players);
-    int player_to_print = playerGetPlayerByLevels(chess->external_players , &level , &result);
-    if(player_to_print == DUMMY_LIMB_ID){
-        return PlayerLevelsResult(result);
+    if(playerTableGetSize(table) >= PARALLEL_EXPORT_MIN_PLAYERS){
+        result = playerTablePrintLevelsParallel(table , file , chessGetPool(chess));
+    } else{
+        result = playerTablePrintLevels(table , file);
     }
-    while (player_to_print != DUMMY_LIMB_ID){
-        if(fprintf(file,"%d %.2lf\n", player_to_print , level) < MIN_PRINT_SUCCESS)
-        {
-            return CHESS_SAVE_FAILURE;
-        }
+    playerTableDestroy(table);
+    return PlayerLevelsResult(result);
+}
+
+ChessResult chessSavePlayersLevels (ChessSystem chess, FILE* file){
+    long long start = chessMetricsStart();
+    ChessResult result = chessSavePlayersLevelsUnmeasured(chess , file);
+    chessMetricsRecord(chess , CHESS_API_SAVE_PLAYERS_LEVELS , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_SAVE_PLAYERS_LEVELS , result , 1 ,
+                                       (int[]){TRACE_NULL(file , 0)}});
+    return result;
+}
+
+static ChessResult chessSavePlayersLevelsDeltaUnmeasured(ChessSystem chess, FILE* file, int* num_of_players){
+    if(chess == NULL || file == NULL || num_of_players == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    pthread_mutex_lock(&chess->external_lock);
+    PlayerNodeResult result = playerPrintLevelsDelta(chess->external_players , chess->removed_players , file ,
+                                                     num_of_players);
+    pthread_mutex_unlock(&chess->external_lock);
+    return PlayerLevelsResult(result);
+}
 
-        player_to_print = playerGetPlayerByLevels(chess->external_players , &level , &result);
+ChessResult chessSavePlayersLevelsDelta(ChessSystem chess, FILE* file, int* num_of_players){
+    long long start = chessMetricsStart();
+    ChessResult result = chessSavePlayersLevelsDeltaUnmeasured(chess , file , num_of_players);
+    chessMetricsRecord(chess , CHESS_API_SAVE_PLAYERS_LEVELS_DELTA , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_SAVE_PLAYERS_LEVELS_DELTA , result , 1 ,
+                                       (int[]){TRACE_NULL(file , 0) | TRACE_NULL(num_of_players , 1)}});
+    return result;
+}
+
+ChessResult chessSavePlayersLevelsAsync(ChessSystem chess, FILE* file, ChessLevelsExport* levels_export){
+    if(chess == NULL || file == NULL || levels_export == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
     }
-    if(result == PLAYER_MEMORY_FAILED){
+    ChessLevelsExport new_export = malloc(sizeof(*new_export));
+    if(new_export == NULL)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    // the copy is taken under the external lock, so it is consistent with the games that were added before it
+    pthread_mutex_lock(&chess->external_lock);
+    new_export->table = playerTableCreate(chess->external_players);
+    pthread_mutex_unlock(&chess->external_lock);
+    if(new_export->table == NULL)
+    {
+        free(new_export);
         return CHESS_OUT_OF_MEMORY;
     }
-    playerResetStatus(chess->external_players);
+    new_export->file = file;
+    new_export->done = false;
+    new_export->result = CHESS_SUCCESS;
+    pthread_mutex_init(&new_export->lock, NULL);
+    new_export->has_writer = pthread_create(&new_export->writer, NULL, chessExportLevels, new_export) == 0;
+    if(new_export->has_writer == false)
+    {
+        // without a thread the levels are written now, and the export is already done
+        chessExportLevels(new_export);
+    }
+    *levels_export = new_export;
     return CHESS_SUCCESS;
 }
 
-ChessResult chessSaveTournamentStatistics(ChessSystem chess, char* path_file){
+bool chessIsPlayersLevelsExportDone(ChessLevelsExport levels_export){
+    if(levels_export == NULL)
+    {
+        return true;
+    }
+    pthread_mutex_lock(&levels_export->lock);
+    bool done = levels_export->done;
+    pthread_mutex_unlock(&levels_export->lock);
+    return done;
+}
+
+ChessResult chessWaitPlayersLevelsExport(ChessLevelsExport levels_export){
+    if(levels_export == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(levels_export->has_writer)
+    {
+        pthread_join(levels_export->writer, NULL);
+    }
+    ChessResult result = levels_export->result;
+    pthread_mutex_destroy(&levels_export->lock);
+    free(levels_export);
+    return result;
+}
+
+static ChessResult chessSaveTournamentStatisticsUnmeasured(ChessSystem chess, char* path_file){
     if(chess == NULL || path_file == NULL)
     {
         return CHESS_NULL_ARGUMENT;
     }
-    if(tournamentExistEnded(chess->tournaments) == false){
+    if(tournamentExistEnded(chess->tournament_index) == false){
         return CHESS_NO_TOURNAMENTS_ENDED;
     }
-    TournamentResult result = tournamentStatistic(path_file , chess->tournaments);
+    ThreadPool pool = NULL;
+    if(tournamentGetNumEnded(chess->tournament_index) >= PARALLEL_STATISTICS_MIN_TOURNAMENTS){
+        pool = chessGetPool(chess);
+    }
+    TournamentResult result = tournamentStatistic(path_file , chess->tournament_index , pool);
     if(result == TOUR_MEMORY_PROBLEM)
     {
         return CHESS_SAVE_FAILURE;
@@ -226,77 +729,861 @@ ChessResult chessSaveTournamentStatistics(ChessSystem chess, char* path_file){
     return CHESS_SUCCESS;
 }
 
-ChessResult chessRemovePlayer(ChessSystem chess, int player_id){
-    if(chess == NULL)
+ChessResult chessSaveTournamentStatistics(ChessSystem chess, char* path_file){
+    long long start = chessMetricsStart();
+    ChessResult result = chessSaveTournamentStatisticsUnmeasured(chess , path_file);
+    chessMetricsRecord(chess , CHESS_API_SAVE_TOURNAMENT_STATISTICS , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_SAVE_TOURNAMENT_STATISTICS , result , 1 ,
+                                       (int[]){TRACE_NULL(path_file , 0)} , 0 , NULL , path_file});
+    return result;
+}
+
+static ChessResult chessSaveTournamentStatisticsDeltaUnmeasured(ChessSystem chess, char* path_file,
+                                                                int* num_of_tournaments){
+    if(chess == NULL || path_file == NULL || num_of_tournaments == NULL)
     {
         return CHESS_NULL_ARGUMENT;
     }
-    if(player_id < MIN)
-    {
-        return CHESS_INVALID_ID;
+    *num_of_tournaments = 0;
+    ThreadPool pool = NULL;
+    if(tournamentGetNumPending(chess->tournament_index) >= PARALLEL_STATISTICS_MIN_TOURNAMENTS){
+        pool = chessGetPool(chess);
     }
-    assert(chess->external_players != NULL);
-    if(mapRemove(chess->external_players , &player_id) == MAP_ITEM_DOES_NOT_EXIST)
+    TournamentResult result = tournamentStatisticDelta(path_file , chess->tournament_index , pool ,
+                                                       num_of_tournaments);
+    if(result == TOUR_MEMORY_PROBLEM)
     {
-        return CHESS_PLAYER_NOT_EXIST;
+        return CHESS_SAVE_FAILURE;
     }
-    assert(chess->tournaments != NULL);
-    tournamentRemovePlayer(chess->tournaments , chess->external_players , player_id);
     return CHESS_SUCCESS;
 }
-//static functions
 
-static bool isTourLocationValid(const char* tournament_location) {
-    assert(tournament_location != NULL);
-    if (*tournament_location < 'A' || *tournament_location > 'Z')
+ChessResult chessSaveTournamentStatisticsDelta(ChessSystem chess, char* path_file, int* num_of_tournaments){
+    long long start = chessMetricsStart();
+    ChessResult result = chessSaveTournamentStatisticsDeltaUnmeasured(chess , path_file , num_of_tournaments);
+    chessMetricsRecord(chess , CHESS_API_SAVE_TOURNAMENT_STATISTICS_DELTA , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_SAVE_TOURNAMENT_STATISTICS_DELTA , result , 1 ,
+                                       (int[]){TRACE_NULL(path_file , 0) | TRACE_NULL(num_of_tournaments , 1)} ,
+                                       0 , NULL , path_file});
+    return result;
+}
+
+static ChessResult chessSaveSnapshotUnmeasured(ChessSystem chess, const char* path_file){
+    if(chess == NULL || path_file == NULL)
     {
-        return false;
+        return CHESS_NULL_ARGUMENT;
     }
-    for (int i = 1; i < *(tournament_location+i); ++i) {
-        if((*(tournament_location+i) >= 'a' && *(tournament_location+i) <= 'z') ||
-           *(tournament_location+i) == ' ')
-        {
-            continue;
-        }
-        return false;
+    SnapshotWriter writer = snapshotWriterCreate(path_file);
+    if(writer == NULL)
+    {
+        return CHESS_SAVE_FAILURE;
     }
-    return true;
+    int num_of_tournaments = 0;
+    for (int i = 0; i < TOURNAMENT_SHARDS; ++i) {
+        num_of_tournaments += mapGetSize(chess->tournaments[i]);
+    }
+    snapshotWriteInt(writer , num_of_tournaments);
+    for (int i = 0; i < TOURNAMENT_SHARDS; ++i) {
+        tournamentSave(chess->tournaments[i] , writer);
+    }
+    playersSave(chess->external_players , writer);
+    if(snapshotWriterClose(writer) != SNAPSHOT_SUCCESS)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    return CHESS_SUCCESS;
 }
 
-static ChessResult convertTourToChess(TournamentResult tour_result)
-{
-    if(tour_result == TOUR_NOT_EXIST)
+ChessResult chessSaveSnapshot(ChessSystem chess, const char* path_file){
+    long long start = chessMetricsStart();
+    ChessResult result = chessSaveSnapshotUnmeasured(chess , path_file);
+    chessMetricsRecord(chess , CHESS_API_SAVE_SNAPSHOT , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_SAVE_SNAPSHOT , result , 1 ,
+                                       (int[]){TRACE_NULL(path_file , 0)} , 0 , NULL , path_file});
+    return result;
+}
+
+ChessSystem chessLoadSnapshot(const char* path_file, ChessResult* chess_result){
+    if(chess_result == NULL)
     {
-        return CHESS_TOURNAMENT_NOT_EXIST;
+        return NULL;
     }
-    if(tour_result == TOUR_ENDED)
+    if(path_file == NULL)
     {
-        return CHESS_TOURNAMENT_ENDED;
+        *chess_result = CHESS_NULL_ARGUMENT;
+        return NULL;
     }
-    if(tour_result == TOUR_EXIST_GAME)
+    SnapshotReader reader = NULL;
+    SnapshotResult result = snapshotReaderCreate(path_file , &reader);
+    if(result != SNAPSHOT_SUCCESS)
     {
-        return CHESS_GAME_ALREADY_EXISTS;
+        *chess_result = result == SNAPSHOT_OUT_OF_MEMORY ? CHESS_OUT_OF_MEMORY : CHESS_SAVE_FAILURE;
+        return NULL;
     }
-    if(tour_result == TOUR_NEGATIVE_TIME)
+    ChessSystem chess = chessCreate();
+    if(chess == NULL)
     {
-        return CHESS_INVALID_PLAY_TIME;
+        snapshotReaderDestroy(reader);
+        *chess_result = CHESS_OUT_OF_MEMORY;
+        return NULL;
     }
-    if(tour_result == TOUR_EXCEEDED_GAMES)
+    *chess_result = chessLoadSnapshotData(chess , reader);
+    snapshotReaderDestroy(reader);
+    if(*chess_result != CHESS_SUCCESS)
     {
-        return CHESS_EXCEEDED_GAMES;
+        chessDestroy(chess);
+        return NULL;
     }
-    return CHESS_OUT_OF_MEMORY;
+    return chess;
 }
 
-static ChessResult PlayerLevelsResult(PlayerNodeResult result){
-    if(result == PLAYER_NULL_ARGUMENT){
+static ChessResult chessRemovePlayerUnmeasured(ChessSystem chess, int player_id){
+    if(chess == NULL)
+    {
         return CHESS_NULL_ARGUMENT;
     }
-    if(result == PLAYER_MEMORY_FAILED){
+    if(player_id < MIN)
+    {
+        return CHESS_INVALID_ID;
+    }
+    assert(chess->external_players != NULL);
+    PlayerNodeResult remove_result = playerRemove(chess->external_players , chess->removed_players , player_id);
+    if(remove_result == PLAYER_NOT_EXIST)
+    {
+        return CHESS_PLAYER_NOT_EXIST;
+    }
+    if(remove_result == PLAYER_MEMORY_FAILED)
+    {
         return CHESS_OUT_OF_MEMORY;
     }
-    if(result == PLAYER_NO_PLAYERS_TO_PRINT){
-        return CHESS_SUCCESS;
+    bool has_subscribers = chessHasSubscribers(chess);
+    ChessStatsEvent stats_event = {chess , 0 , player_id , 1};
+    tournamentRemovePlayer(chess->tournament_index , chess->external_players , player_id ,
+                           has_subscribers ? chessPublishPlayerStats : NULL , &stats_event);
+    chessLog(chess , (LogRecord){LOG_REMOVE_PLAYER , 1 , {player_id} , NULL});
+    if(has_subscribers)
+    {
+        chessPublish(chess , &(ChessEvent){CHESS_EVENT_PLAYER_REMOVED , 0 , player_id});
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessRemovePlayer(ChessSystem chess, int player_id){
+    long long start = chessMetricsStart();
+    ChessResult result = chessRemovePlayerUnmeasured(chess , player_id);
+    chessMetricsRecord(chess , CHESS_API_REMOVE_PLAYER , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_REMOVE_PLAYER , result , 2 ,
+                                       (int[]){TRACE_NO_NULLS , player_id}});
+    return result;
+}
+
+ChessResult chessEnableLog(ChessSystem chess, const char* path_file){
+    if(chess == NULL || path_file == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    OperationLogResult previous_result = operationLogClose(chess->log);
+    chess->log = operationLogOpen(path_file);
+    if(chess->log == NULL || previous_result != LOG_SUCCESS)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessSyncLog(ChessSystem chess){
+    if(chess == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(chess->log != NULL && operationLogSync(chess->log) != LOG_SUCCESS)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessEnableTrace(ChessSystem chess, const char* path_file){
+    if(chess == NULL || path_file == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    CallTraceResult previous_result = callTraceClose(chess->trace);
+    chess->trace = callTraceOpen(path_file);
+    if(chess->trace == NULL || previous_result != TRACE_SUCCESS)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessDisableTrace(ChessSystem chess){
+    if(chess == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    CallTraceResult result = callTraceClose(chess->trace);
+    chess->trace = NULL;
+    return result == TRACE_SUCCESS ? CHESS_SUCCESS : CHESS_SAVE_FAILURE;
+}
+
+ChessResult chessReplayLog(ChessSystem chess, const char* path_file, int* num_of_records){
+    if(chess == NULL || path_file == NULL || num_of_records == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    // the replayed calls are already in the file, so they are not logged again
+    OperationLog log = chess->log;
+    chess->log = NULL;
+    OperationLogResult result = operationLogReplay(path_file , chessReplayRecord , chess , num_of_records);
+    chess->log = log;
+    if(result == LOG_OUT_OF_MEMORY)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    if(result == LOG_FILE_ERROR)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    return CHESS_SUCCESS;
+}
+static ChessResult chessIngestFileUnmeasured(ChessSystem chess, const char* path_file,
+                                             ChessIngestErrorFunction on_error, void* context,
+                                             int* num_of_games, ChessIngestTrace* trace){
+    if(chess == NULL || path_file == NULL || num_of_games == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    ChessResult* results = malloc(FEED_BATCH_SIZE * sizeof(*results));
+    if(results == NULL)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    GameFeed feed = gameFeedOpen(path_file);
+    if(feed == NULL)
+    {
+        free(results);
+        return CHESS_SAVE_FAILURE;
+    }
+    if(trace != NULL)
+    {
+        trace->state = TRACE_FEED_RECORDED;
+    }
+    *num_of_games = 0;
+    bool out_of_memory = false;
+    int num_of_records = 0;
+    const GameFeedRecord* records = NULL;
+    // the feed parses the next batches while this one is applied
+    while(out_of_memory == false && (records = gameFeedNext(feed , &num_of_records)) != NULL)
+    {
+        chessTraceFeedRecords(trace , records , num_of_records);
+        ChessIngestBatch batch = {chess , records , num_of_records , results};
+        if(num_of_records >= PARALLEL_INGEST_MIN_GAMES)
+        {
+            // the games of a tournament are all in its shard and keep their order,
+            // so the shards are applied in parallel with the same results as in the order of the file
+            threadPoolRun(chessGetPool(chess) , TOURNAMENT_SHARDS , chessIngestShardTask , &batch);
+        }
+        else
+        {
+            for (int i = 0; i < num_of_records; ++i) {
+                results[i] = chessIngestRecord(chess , &records[i]);
+            }
+        }
+        for (int i = 0; i < num_of_records; ++i) {
+            if(results[i] == CHESS_SUCCESS)
+            {
+                (*num_of_games)++;
+                continue;
+            }
+            if(results[i] == CHESS_OUT_OF_MEMORY)
+            {
+                out_of_memory = true;
+            }
+            if(on_error != NULL)
+            {
+                on_error(records[i].line , results[i] , context);
+            }
+        }
+    }
+    GameFeedResult feed_result = gameFeedClose(feed);
+    free(results);
+    if(out_of_memory)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    if(feed_result != FEED_SUCCESS)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessIngestFile(ChessSystem chess, const char* path_file, ChessIngestErrorFunction on_error,
+                            void* context, int* num_of_games){
+    long long start = chessMetricsStart();
+    ChessIngestTrace trace = {TRACE_FEED_NOT_OPENED , NULL , 0 , 0};
+    bool traced = chess != NULL && chess->trace != NULL;
+    ChessResult result = chessIngestFileUnmeasured(chess , path_file , on_error , context , num_of_games ,
+                                                   traced ? &trace : NULL);
+    chessMetricsRecord(chess , CHESS_API_INGEST_FILE , start , result);
+    // the records of the feed are traced with the call, so the replay does not depend on the file
+    chessTraceCall(chess , (TraceCall){CHESS_API_INGEST_FILE , result , 2 ,
+                                       (int[]){TRACE_NULL(path_file , 0) | TRACE_NULL(num_of_games , 1) ,
+                                               trace.state} ,
+                                       trace.num_of_items , trace.items , path_file});
+    free(trace.items);
+    return result;
+}
+
+ChessResult chessSubscribe(ChessSystem chess, ChessEventFunction on_event, void* context, int* subscription_id){
+    if(chess == NULL || on_event == NULL || subscription_id == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    pthread_rwlock_wrlock(&chess->subscribers_lock);
+    ChessSubscriber* subscribers = realloc(chess->subscribers ,
+                                           (chess->num_of_subscribers + 1) * sizeof(*subscribers));
+    if(subscribers == NULL)
+    {
+        pthread_rwlock_unlock(&chess->subscribers_lock);
+        return CHESS_OUT_OF_MEMORY;
+    }
+    chess->subscribers = subscribers;
+    *subscription_id = chess->next_subscription_id++;
+    subscribers[chess->num_of_subscribers] = (ChessSubscriber){*subscription_id , on_event , context};
+    __atomic_store_n(&chess->num_of_subscribers , chess->num_of_subscribers + 1 , __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&chess->subscribers_lock);
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessUnsubscribe(ChessSystem chess, int subscription_id){
+    if(chess == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    pthread_rwlock_wrlock(&chess->subscribers_lock);
+    for (int i = 0; i < chess->num_of_subscribers; ++i) {
+        if(chess->subscribers[i].id == subscription_id)
+        {
+            // the order of the subscribers is kept, so they receive every event in the order they subscribed
+            for (int j = i + 1; j < chess->num_of_subscribers; ++j) {
+                chess->subscribers[j - 1] = chess->subscribers[j];
+            }
+            __atomic_store_n(&chess->num_of_subscribers , chess->num_of_subscribers - 1 , __ATOMIC_RELEASE);
+            pthread_rwlock_unlock(&chess->subscribers_lock);
+            return CHESS_SUCCESS;
+        }
+    }
+    pthread_rwlock_unlock(&chess->subscribers_lock);
+    return CHESS_INVALID_ID;
+}
+
+ChessResult chessGetMetrics(ChessSystem chess, ChessApi api, ChessApiMetrics* metrics){
+    if(chess == NULL || metrics == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(api < 0 || api >= CHESS_NUM_APIS)
+    {
+        return CHESS_INVALID_ID;
+    }
+    *metrics = (ChessApiMetrics){0};
+#ifndef CHESS_NO_METRICS
+    Histogram latencies = chess->latencies[api];
+    metrics->calls = histogramGetCount(latencies);
+    for (int i = 0; i < CHESS_NUM_RESULTS; ++i) {
+        metrics->result_counts[i] = __atomic_load_n(&chess->result_counts[api][i], __ATOMIC_RELAXED);
+    }
+    metrics->total_ns = histogramGetTotal(latencies);
+    metrics->max_ns = histogramGetMax(latencies);
+    metrics->p50_ns = histogramGetPercentile(latencies , 50.0);
+    metrics->p90_ns = histogramGetPercentile(latencies , 90.0);
+    metrics->p99_ns = histogramGetPercentile(latencies , 99.0);
+    metrics->p999_ns = histogramGetPercentile(latencies , 99.9);
+#endif
+    return CHESS_SUCCESS;
+}
+
+const char* chessGetApiName(ChessApi api){
+    static const char* const api_names[CHESS_NUM_APIS] = {
+            "chessAddTournament", "chessAddGame", "chessRemoveTournament", "chessEndTournament",
+            "chessEndTournaments", "chessRemovePlayer", "chessCalculateAveragePlayTime",
+            "chessSavePlayersLevels", "chessSaveTournamentStatistics", "chessSaveSnapshot", "chessIngestFile",
+            "chessSaveTournamentStatisticsDelta", "chessSavePlayersLevelsDelta", "chessGetTournamentsAtLocation",
+            "chessGetLocationStatistics", "chessGetPlayerStats", "chessGetTournamentPlayerStats"};
+    if(api < 0 || api >= CHESS_NUM_APIS)
+    {
+        return NULL;
+    }
+    return api_names[api];
+}
+
+ChessResult chessDumpMetrics(ChessSystem chess, FILE* file){
+    if(chess == NULL || file == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    for (int api = 0; api < CHESS_NUM_APIS; ++api) {
+        ChessApiMetrics metrics;
+        chessGetMetrics(chess , api , &metrics);
+        if(metrics.calls == 0)
+        {
+            continue;
+        }
+        long long errors = metrics.calls - metrics.result_counts[CHESS_SUCCESS];
+        if(fprintf(file , "%s calls=%lld errors=%lld mean_us=%.3f p50_us=%.3f p90_us=%.3f p99_us=%.3f"
+                          " p999_us=%.3f max_us=%.3f results=" , chessGetApiName(api) , metrics.calls , errors ,
+                   metrics.total_ns / NANOSECONDS_PER_MICROSECOND / metrics.calls ,
+                   metrics.p50_ns / NANOSECONDS_PER_MICROSECOND , metrics.p90_ns / NANOSECONDS_PER_MICROSECOND ,
+                   metrics.p99_ns / NANOSECONDS_PER_MICROSECOND , metrics.p999_ns / NANOSECONDS_PER_MICROSECOND ,
+                   metrics.max_ns / NANOSECONDS_PER_MICROSECOND) < MIN_PRINT_SUCCESS)
+        {
+            return CHESS_SAVE_FAILURE;
+        }
+        for (int result = 0; result < CHESS_NUM_RESULTS; ++result) {
+            if(metrics.result_counts[result] > 0 &&
+               fprintf(file , "%d:%lld," , result , metrics.result_counts[result]) < MIN_PRINT_SUCCESS)
+            {
+                return CHESS_SAVE_FAILURE;
+            }
+        }
+        if(fprintf(file , "\n") < MIN_PRINT_SUCCESS)
+        {
+            return CHESS_SAVE_FAILURE;
+        }
+    }
+    return fflush(file) == 0 ? CHESS_SUCCESS : CHESS_SAVE_FAILURE;
+}
+
+static ChessResult chessGetTournamentsAtLocationUnmeasured(ChessSystem chess, const char* location,
+                                                          int** tournament_ids, int* num_of_tournaments){
+    if(chess == NULL || location == NULL || tournament_ids == NULL || num_of_tournaments == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(isTourLocationValid(location) == false)
+    {
+        return CHESS_INVALID_LOCATION;
+    }
+    TournamentResult result = tournamentGetByLocation(chess->tournament_index , location ,
+                                                      tournament_ids , num_of_tournaments);
+    if(result == TOUR_MEMORY_PROBLEM)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessGetTournamentsAtLocation(ChessSystem chess, const char* location,
+                                          int** tournament_ids, int* num_of_tournaments){
+    long long start = chessMetricsStart();
+    ChessResult result = chessGetTournamentsAtLocationUnmeasured(chess , location , tournament_ids ,
+                                                                 num_of_tournaments);
+    chessMetricsRecord(chess , CHESS_API_GET_TOURNAMENTS_AT_LOCATION , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_GET_TOURNAMENTS_AT_LOCATION , result , 1 ,
+                                       (int[]){TRACE_NULL(location , 0) | TRACE_NULL(tournament_ids , 1) |
+                                               TRACE_NULL(num_of_tournaments , 2)} , 0 , NULL , location});
+    return result;
+}
+
+static ChessResult chessGetLocationStatisticsUnmeasured(ChessSystem chess, const char* location,
+                                                       ChessLocationStatistics* statistics){
+    if(chess == NULL || location == NULL || statistics == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(isTourLocationValid(location) == false)
+    {
+        return CHESS_INVALID_LOCATION;
+    }
+    tournamentLocationStatistic(chess->tournament_index , location , statistics);
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessGetLocationStatistics(ChessSystem chess, const char* location,
+                                       ChessLocationStatistics* statistics){
+    long long start = chessMetricsStart();
+    ChessResult result = chessGetLocationStatisticsUnmeasured(chess , location , statistics);
+    chessMetricsRecord(chess , CHESS_API_GET_LOCATION_STATISTICS , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_GET_LOCATION_STATISTICS , result , 1 ,
+                                       (int[]){TRACE_NULL(location , 0) | TRACE_NULL(statistics , 1)} ,
+                                       0 , NULL , location});
+    return result;
+}
+
+static ChessResult chessGetPlayerStatsUnmeasured(ChessSystem chess, int player_id,
+                                                ChessPlayerStatistics* statistics){
+    if(chess == NULL || statistics == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(player_id < MIN)
+    {
+        return CHESS_INVALID_ID;
+    }
+    PlayerStats stats;
+    if(playerGetStats(chess->external_players , player_id , &stats , &statistics->level) == PLAYER_NOT_EXIST)
+    {
+        return CHESS_PLAYER_NOT_EXIST;
+    }
+    chessSetPlayerStatistics(statistics , stats);
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessGetPlayerStats(ChessSystem chess, int player_id, ChessPlayerStatistics* statistics){
+    long long start = chessMetricsStart();
+    ChessResult result = chessGetPlayerStatsUnmeasured(chess , player_id , statistics);
+    chessMetricsRecord(chess , CHESS_API_GET_PLAYER_STATS , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_GET_PLAYER_STATS , result , 2 ,
+                                       (int[]){TRACE_NULL(statistics , 0) , player_id}});
+    return result;
+}
+
+static ChessResult chessGetTournamentPlayerStatsUnmeasured(ChessSystem chess, int tournament_id, int player_id,
+                                                          ChessPlayerStatistics* statistics){
+    if(chess == NULL || statistics == NULL)
+    {
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(tournament_id < MIN || player_id < MIN)
+    {
+        return CHESS_INVALID_ID;
+    }
+    PlayerStats stats;
+    TournamentResult result = tournamentGetPlayerStats(chessGetShard(chess , tournament_id) , tournament_id ,
+                                                       player_id , &stats , &statistics->level);
+    if(result != TOUR_SUCCESS)
+    {
+        return convertTourToChess(result);
+    }
+    chessSetPlayerStatistics(statistics , stats);
+    return CHESS_SUCCESS;
+}
+
+ChessResult chessGetTournamentPlayerStats(ChessSystem chess, int tournament_id, int player_id,
+                                          ChessPlayerStatistics* statistics){
+    long long start = chessMetricsStart();
+    ChessResult result = chessGetTournamentPlayerStatsUnmeasured(chess , tournament_id , player_id , statistics);
+    chessMetricsRecord(chess , CHESS_API_GET_TOURNAMENT_PLAYER_STATS , start , result);
+    chessTraceCall(chess , (TraceCall){CHESS_API_GET_TOURNAMENT_PLAYER_STATS , result , 3 ,
+                                       (int[]){TRACE_NULL(statistics , 0) , tournament_id , player_id}});
+    return result;
+}
+
+//static functions
+
+static Map chessGetShard(ChessSystem chess, int tournament_id){
+    assert(chess != NULL && tournament_id >= MIN);
+    return chess->tournaments[tournament_id % TOURNAMENT_SHARDS];
+}
+
+static pthread_mutex_t* chessGetShardLock(ChessSystem chess, int tournament_id){
+    assert(chess != NULL && tournament_id >= MIN);
+    return &chess->shard_locks[tournament_id % TOURNAMENT_SHARDS];
+}
+
+static ChessResult chessLoadSnapshotData(ChessSystem chess, SnapshotReader reader){
+    assert(chess != NULL && reader != NULL);
+    int num_of_tournaments = snapshotReadCount(reader , MIN_TOURNAMENT_RECORD_SIZE);
+    for (int i = 0; i < num_of_tournaments && snapshotReaderFailed(reader) == false; ++i) {
+        int tournament_id = snapshotReadInt(reader);
+        if(tournament_id < MIN)
+        {
+            snapshotReaderReject(reader);
+            break;
+        }
+        if(tournamentLoad(chessGetShard(chess , tournament_id) , chess->tournament_index ,
+                          tournament_id , reader) == TOUR_MEMORY_PROBLEM)
+        {
+            return CHESS_OUT_OF_MEMORY;
+        }
+    }
+    if(snapshotReaderFailed(reader) == false &&
+       playersLoad(chess->external_players , reader) == PLAYER_MEMORY_FAILED)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    if(snapshotReaderFailed(reader) == true)
+    {
+        return CHESS_SAVE_FAILURE;
+    }
+    if(tournamentRebuildIndex(chess->tournaments , TOURNAMENT_SHARDS , chess->tournament_index) ==
+       TOUR_MEMORY_PROBLEM)
+    {
+        return CHESS_OUT_OF_MEMORY;
+    }
+    return CHESS_SUCCESS;
+}
+
+static void chessLog(ChessSystem chess, LogRecord record){
+    assert(chess != NULL);
+    if(chess->log != NULL){
+        operationLogAppend(chess->log , &record);
+    }
+}
+
+static void chessReplayRecord(const LogRecord* record, void* chess){
+    assert(record != NULL && chess != NULL);
+    const int* values = record->values;
+    if(record->operation == LOG_ADD_TOURNAMENT && record->num_of_values == 2 && record->location != NULL){
+        chessAddTournament(chess , values[0] , values[1] , record->location);
+    }
+    else if(record->operation == LOG_ADD_GAME && record->num_of_values == 5){
+        chessAddGame(chess , values[0] , values[1] , values[2] , (Winner)values[3] , values[4]);
+    }
+    else if(record->operation == LOG_END_TOURNAMENT && record->num_of_values == 1){
+        chessEndTournament(chess , values[0]);
+    }
+    else if(record->operation == LOG_REMOVE_TOURNAMENT && record->num_of_values == 1){
+        chessRemoveTournament(chess , values[0]);
+    }
+    else if(record->operation == LOG_REMOVE_PLAYER && record->num_of_values == 1){
+        chessRemovePlayer(chess , values[0]);
+    }
+}
+
+static void chessTraceFeedRecords(ChessIngestTrace* trace, const GameFeedRecord* records, int num_of_records){
+    if(trace == NULL || trace->state != TRACE_FEED_RECORDED)
+    {
+        return;
+    }
+    int needed = trace->num_of_items + num_of_records * TRACE_FEED_RECORD_VALUES;
+    if(needed > trace->capacity)
+    {
+        int capacity = trace->capacity == 0 ? TRACE_FEED_INITIAL_CAPACITY : trace->capacity;
+        while(capacity < needed)
+        {
+            capacity *= TRACE_FEED_GROWTH_FACTOR;
+        }
+        int* items = realloc(trace->items , capacity * sizeof(*items));
+        if(items == NULL)
+        {
+            // the call is traced without its records, and the replay reads the feed from its path
+            free(trace->items);
+            *trace = (ChessIngestTrace){TRACE_FEED_NOT_RECORDED , NULL , 0 , 0};
+            return;
+        }
+        trace->items = items;
+        trace->capacity = capacity;
+    }
+    for (int i = 0; i < num_of_records; ++i) {
+        // the integers of a line that is not valid are not parsed, so they are traced as zeros
+        const GameFeedRecord* record = &records[i];
+        int values[TRACE_FEED_RECORD_VALUES] = {false};
+        if(record->valid)
+        {
+            int record_values[TRACE_FEED_RECORD_VALUES] = {true , record->tournament_id , record->first_player ,
+                                                           record->second_player , record->winner ,
+                                                           record->play_time};
+            memcpy(values , record_values , sizeof(values));
+        }
+        memcpy(trace->items + trace->num_of_items , values , sizeof(values));
+        trace->num_of_items += TRACE_FEED_RECORD_VALUES;
+    }
+}
+
+static ChessResult chessIngestRecord(ChessSystem chess, const GameFeedRecord* record){
+    assert(chess != NULL && record != NULL);
+    if(record->valid == false)
+    {
+        return CHESS_INVALID_ID;
+    }
+    Winner winner = DRAW;
+    if(record->winner == record->first_player)
+    {
+        winner = FIRST_PLAYER;
+    }
+    else if(record->winner == record->second_player)
+    {
+        winner = SECOND_PLAYER;
+    }
+    else if(record->winner != FEED_DRAW)
+    {
+        return CHESS_INVALID_ID;
+    }
+    return chessAddGameMeasured(chess , record->tournament_id , record->first_player , record->second_player ,
+                                winner , record->play_time);
+}
+
+static int chessIngestShard(const GameFeedRecord* record){
+    assert(record != NULL);
+    if(record->valid == false || record->tournament_id < MIN)
+    {
+        return 0;
+    }
+    return record->tournament_id % TOURNAMENT_SHARDS;
+}
+
+static void chessIngestShardTask(int shard, void* batch){
+    ChessIngestBatch* ingest_batch = batch;
+    for (int i = 0; i < ingest_batch->num_of_records; ++i) {
+        if(chessIngestShard(&ingest_batch->records[i]) == shard)
+        {
+            ingest_batch->results[i] = chessIngestRecord(ingest_batch->chess , &ingest_batch->records[i]);
+        }
+    }
+}
+
+static void* chessExportLevels(void* levels_export){
+    ChessLevelsExport export_data = levels_export;
+    assert(export_data != NULL);
+    // the pool of the system may be running other work, so the export is written on its own thread only
+    ChessResult result = PlayerLevelsResult(playerTablePrintLevels(export_data->table , export_data->file));
+    playerTableDestroy(export_data->table);
+    export_data->table = NULL;
+    pthread_mutex_lock(&export_data->lock);
+    export_data->result = result;
+    export_data->done = true;
+    pthread_mutex_unlock(&export_data->lock);
+    return NULL;
+}
+
+static ThreadPool chessGetPool(ChessSystem chess){
+    assert(chess != NULL);
+    if(chess->pool == NULL){
+        chess->pool = threadPoolCreate(THREAD_PER_PROCESSOR);
+    }
+    return chess->pool;
+}
+
+static void chessPublish(ChessSystem chess, const ChessEvent* event){
+    assert(chess != NULL && event != NULL);
+    pthread_rwlock_rdlock(&chess->subscribers_lock);
+    for (int i = 0; i < chess->num_of_subscribers; ++i) {
+        chess->subscribers[i].on_event(event , chess->subscribers[i].context);
+    }
+    pthread_rwlock_unlock(&chess->subscribers_lock);
+}
+
+static bool chessHasSubscribers(ChessSystem chess){
+    assert(chess != NULL);
+    // a system without subscribers pays one load per change, and builds no events
+    return __atomic_load_n(&chess->num_of_subscribers , __ATOMIC_ACQUIRE) > 0;
+}
+
+static void chessPublishPlayerStats(int player_id, PlayerStats stats, void* stats_event){
+    ChessStatsEvent* event_data = stats_event;
+    assert(event_data != NULL);
+    if(stats.wins == 0 && stats.losses == 0 && stats.draws == 0 && stats.num_of_games == 0)
+    {
+        return;
+    }
+    int factor = event_data->factor;
+    ChessEvent event = {CHESS_EVENT_PLAYER_STATS , event_data->tournament_id , player_id , event_data->opponent_id ,
+                        0 , 0 , stats.wins * factor , stats.losses * factor , stats.draws * factor ,
+                        stats.num_of_games * factor};
+    chessPublish(event_data->chess , &event);
+}
+
+static long long chessMetricsStart(){
+#ifndef CHESS_NO_METRICS
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC , &now);
+    return now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static void chessTraceCall(ChessSystem chess, TraceCall call){
+    if(chess != NULL && chess->trace != NULL){
+        callTraceAppend(chess->trace , &call);
+    }
+}
+
+static void chessMetricsRecord(ChessSystem chess, ChessApi api, long long start, ChessResult result){
+#ifndef CHESS_NO_METRICS
+    // a call with a NULL system has nowhere to be recorded
+    if(chess == NULL)
+    {
+        return;
+    }
+    histogramRecord(chess->latencies[api] , chessMetricsStart() - start);
+    if(result >= 0 && result < CHESS_NUM_RESULTS)
+    {
+        __atomic_fetch_add(&chess->result_counts[api][result] , 1 , __ATOMIC_RELAXED);
+    }
+#else
+    (void)chess;
+    (void)api;
+    (void)start;
+    (void)result;
+#endif
+}
+
+static bool isTourLocationValid(const char* tournament_location) {
+    assert(tournament_location != NULL);
+    if (*tournament_location < 'A' || *tournament_location > 'Z')
+    {
+        return false;
+    }
+    for (int i = 1; i < *(tournament_location+i); ++i) {
+        if((*(tournament_location+i) >= 'a' && *(tournament_location+i) <= 'z') ||
+           *(tournament_location+i) == ' ')
+        {
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+static void chessSetPlayerStatistics(ChessPlayerStatistics* statistics, PlayerStats stats)
+{
+    assert(statistics != NULL);
+    statistics->wins = stats.wins;
+    statistics->losses = stats.losses;
+    statistics->draws = stats.draws;
+    statistics->num_of_games = stats.num_of_games;
+}
+
+static ChessResult convertTourToChess(TournamentResult tour_result)
+{
+    if(tour_result == TOUR_NOT_EXIST)
+    {
+        return CHESS_TOURNAMENT_NOT_EXIST;
+    }
+    if(tour_result == TOUR_ENDED)
+    {
+        return CHESS_TOURNAMENT_ENDED;
+    }
+    if(tour_result == TOUR_EXIST_GAME)
+    {
+        return CHESS_GAME_ALREADY_EXISTS;
+    }
+    if(tour_result == TOUR_NEGATIVE_TIME)
+    {
+        return CHESS_INVALID_PLAY_TIME;
+    }
+    if(tour_result == TOUR_EXCEEDED_GAMES)
+    {
+        return CHESS_EXCEEDED_GAMES;
+    }
+    if(tour_result == TOUR_N0_GAMES)
+    {
+        return CHESS_NO_GAMES;
+    }
+    if(tour_result == TOUR_PLAYER_NOT_EXIST)
+    {
+        return CHESS_PLAYER_NOT_EXIST;
+    }
+    if(tour_result == TOUR_SUCCESS)
+    {
+        return CHESS_SUCCESS;
+    }
+    return CHESS_OUT_OF_MEMORY;
+}
+
+static ChessResult PlayerLevelsResult(PlayerNodeResult result){
+    if(result == PLAYER_NULL_ARGUMENT){
+        return CHESS_NULL_ARGUMENT;
+    }
+    if(result == PLAYER_MEMORY_FAILED){
+        return CHESS_OUT_OF_MEMORY;
+    }
+    if(result == PLAYER_SAVE_FAILED){
+        return CHESS_SAVE_FAILURE;
     }
     return CHESS_SUCCESS;
 }
@@ -309,7 +1596,7 @@ static ChessResult chessAddGamesResults(ChessSystem chess, int tournament_id ,
     {
         return CHESS_INVALID_ID;
     }
-    if(mapContains(chess->tournaments , &tournament_id) == true)
+    if(mapContains(chessGetShard(chess , tournament_id) , &tournament_id) == true)
     {
         return CHESS_TOURNAMENT_ALREADY_EXISTS;
     }
@@ -0,0 +1,484 @@
+#ifndef CHESS_SYSTEM_EXTENDED_H
+#define CHESS_SYSTEM_EXTENDED_H
+
+#include "chessSystem.h"
+#include <stdbool.h>
+
+/**
+ * Thread safety: chessAddGame may be called from several threads at once on the same system,
+ * games of tournaments in different shards are added in parallel. chessSavePlayersLevelsAsync may
+ * be called while they run, and its export may be checked and waited for from any thread.
+ * every other function needs exclusive access to the system - in particular the functions that
+ * work on a thread pool create the pool of the system on their first call without a lock.
+ */
+
+/** Aggregated statistics of all the tournaments that are held in one location */
+typedef struct ChessLocationStatistics_t {
+    int num_tournaments;
+    int num_ended_tournaments;
+    int num_games;
+    int longest_game;
+    double total_play_time;
+    double average_play_time;
+} ChessLocationStatistics;
+
+/** The results of a player, in the whole system or in one tournament, and the level that they give */
+typedef struct ChessPlayerStatistics_t {
+    int wins;
+    int losses;
+    int draws;
+    int num_of_games;
+    double level;
+} ChessPlayerStatistics;
+
+/**
+ * chessGetTournamentsAtLocation: returns the ids of all the tournaments that are held in a location,
+ * in ascending order. the time is proportional to the number of tournaments in the location.
+ *
+ * @param chess - chess system that contains the tournaments.
+ * @param location - the location to look for.
+ * @param tournament_ids - a pointer where to put a new array of the ids. the caller frees it.
+ *                         NULL is put if there are no tournaments in the location.
+ * @param num_of_tournaments - a pointer where to put the number of ids.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_INVALID_LOCATION - if the location is not a valid tournament location.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessGetTournamentsAtLocation(ChessSystem chess, const char* location,
+                                          int** tournament_ids, int* num_of_tournaments);
+
+/**
+ * chessGetLocationStatistics: aggregates the statistics of all the tournaments (ended or not)
+ * that are held in a location. the time is proportional to the number of tournaments in the location.
+ *
+ * @param chess - chess system that contains the tournaments.
+ * @param location - the location to aggregate.
+ * @param statistics - a pointer where to put the statistics. all zero if there are no tournaments.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_INVALID_LOCATION - if the location is not a valid tournament location.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessGetLocationStatistics(ChessSystem chess, const char* location,
+                                       ChessLocationStatistics* statistics);
+
+/**
+ * chessGetPlayerStats: gets the results and the level of one player, as they are counted by
+ * chessSavePlayersLevels, with a single lookup of the player and without writing a file.
+ *
+ * @param chess - chess system that contains the player.
+ * @param player_id - the id of the player.
+ * @param statistics - a pointer where to put the statistics. the level is 0 if the player has no games.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess or statistics is NULL.
+ *     CHESS_INVALID_ID - if the player id is not positive.
+ *     CHESS_PLAYER_NOT_EXIST - if the player is not in the system.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessGetPlayerStats(ChessSystem chess, int player_id, ChessPlayerStatistics* statistics);
+
+/**
+ * chessGetTournamentPlayerStats: gets the results and the level of one player in one tournament (ended or not),
+ * with a single lookup of the tournament and of the player in it.
+ *
+ * @param chess - chess system that contains the tournament.
+ * @param tournament_id - the id of the tournament.
+ * @param player_id - the id of the player.
+ * @param statistics - a pointer where to put the statistics of the player in the tournament.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess or statistics is NULL.
+ *     CHESS_INVALID_ID - if the tournament id or the player id is not positive.
+ *     CHESS_TOURNAMENT_NOT_EXIST - if the tournament is not in the system.
+ *     CHESS_PLAYER_NOT_EXIST - if the player has no games in the tournament.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessGetTournamentPlayerStats(ChessSystem chess, int tournament_id, int player_id,
+                                          ChessPlayerStatistics* statistics);
+
+/**
+ * chessEndTournaments: ends a batch of tournaments, as calling chessEndTournament for every id in order.
+ * all the ids are validated first, then the winners of the tournaments are computed in parallel
+ * and the batch is committed together: either every tournament that can be ended is ended, or none is.
+ *
+ * @param chess - chess system that contains the tournaments.
+ * @param tournament_ids - the ids of the tournaments to end.
+ * @param num_of_tournaments - the number of ids.
+ * @param results - array of num_of_tournaments results, filled with the result of every id:
+ *     CHESS_INVALID_ID, CHESS_TOURNAMENT_NOT_EXIST, CHESS_TOURNAMENT_ENDED, CHESS_NO_GAMES or
+ *     CHESS_SUCCESS as in chessEndTournament. an id that appears more than once is ended once.
+ *     CHESS_OUT_OF_MEMORY for every id that was not ended because an allocation failed.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess is NULL, or one of the arrays is NULL and there are ids.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed. no tournament is ended.
+ *     CHESS_SUCCESS - otherwise, the result of every id is in results.
+ */
+ChessResult chessEndTournaments(ChessSystem chess, const int* tournament_ids, int num_of_tournaments,
+                                ChessResult* results);
+
+/**
+ * chessSaveSnapshot: saves the whole state of the system to a binary file: the tournaments with their
+ * flags, games and players, and the external players. the file has a version and a checksum,
+ * and is loaded back by chessLoadSnapshot, in a time linear in its size.
+ *
+ * @param chess - chess system to save.
+ * @param path_file - the path of the file. it is overwritten if it exists.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be written.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessSaveSnapshot(ChessSystem chess, const char* path_file);
+
+/**
+ * chessLoadSnapshot: creates a new chess system from a file that was written by chessSaveSnapshot.
+ * the maps are built in the order of the file, so every element is appended instead of searched for.
+ *
+ * @param path_file - the path of the file.
+ * @param chess_result - a pointer where to put the result:
+ *     CHESS_NULL_ARGUMENT - if the path is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be read, is not a snapshot of this version, or is corrupted.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed.
+ *     CHESS_SUCCESS - otherwise.
+ * @return
+ *     NULL - if chess_result is NULL or the load failed.
+ *     the new chess system - otherwise. the caller destroys it with chessDestroy.
+ */
+ChessSystem chessLoadSnapshot(const char* path_file, ChessResult* chess_result);
+
+/**
+ * chessEnableLog: starts a write-ahead log of the system. every successful call of chessAddTournament,
+ * chessAddGame, chessEndTournament(s), chessRemoveTournament and chessRemovePlayer is appended to the file
+ * as a compact binary record. the records are written and synced in groups by a background thread,
+ * so the calls do not wait for the disk; chessSyncLog waits until they are durable.
+ * the records are appended after the records that are already in the file.
+ *
+ * @param chess - chess system to log.
+ * @param path_file - the path of the log file, created if it does not exist.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be opened (the system is not logged),
+ *                          or the previous log of the system has failed.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessEnableLog(ChessSystem chess, const char* path_file);
+
+/**
+ * chessSyncLog: waits until all the calls that were logged before it are written and synced to the log.
+ *
+ * @param chess - chess system.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess is NULL.
+ *     CHESS_SAVE_FAILURE - if a record was lost or the log could not be written.
+ *     CHESS_SUCCESS - otherwise, also when the system has no log.
+ */
+ChessResult chessSyncLog(ChessSystem chess);
+
+/**
+ * chessEnableTrace: starts recording every call of the functions of ChessApi to a compact binary trace:
+ * the function, its arguments (which pointers were NULL, the integers, the ids of chessEndTournaments and
+ * the path or the location) and its result. the calls are buffered, so recording costs an encode per call.
+ * chessIngestFile also records the records of the feed it has read, so the trace does not depend on the
+ * feed file: a feed that was rotated or deleted since replays to the same results.
+ * the chessReplay tool runs a trace against a new system as fast as it can, checks that every call returns
+ * the recorded result and reports the timing of every function, so a trace that is enabled right after
+ * chessCreate can benchmark the library with the calls of a real workload.
+ * a trace that was enabled before is closed first. the calls of chessAddGame from several threads are
+ * recorded in the order they finished, which may not replay to the same results.
+ *
+ * @param chess - chess system to trace.
+ * @param path_file - the path of the trace file, it is truncated if it exists.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be opened, or the previous trace could not be written.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessEnableTrace(ChessSystem chess, const char* path_file);
+
+/**
+ * chessDisableTrace: stops recording the calls and writes the rest of the trace.
+ *
+ * @param chess - chess system.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess is NULL.
+ *     CHESS_SAVE_FAILURE - if the trace could not be written.
+ *     CHESS_SUCCESS - otherwise, also when the system is not traced.
+ */
+ChessResult chessDisableTrace(ChessSystem chess);
+
+/**
+ * chessReplayLog: applies the calls that are recorded in a log file to the system, in order, to rebuild
+ * the state after a crash (on a new system, or on the system that was loaded from the snapshot that the
+ * log started after). a torn record at the end of the file is ignored, and a file that does not exist is
+ * an empty log. the replayed calls are not logged.
+ *
+ * @param chess - chess system to apply the calls to.
+ * @param path_file - the path of the log file.
+ * @param num_of_records - a pointer where to put the number of calls that were replayed.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be read.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessReplayLog(ChessSystem chess, const char* path_file, int* num_of_records);
+
+/** A players levels export that is written by a background thread */
+typedef struct chess_levels_export_t *ChessLevelsExport;
+
+/**
+ * chessSavePlayersLevelsAsync: prints the levels of the players to a file like chessSavePlayersLevels,
+ * from a background thread. the players are copied first into a consistent snapshot (a short pause of
+ * chessAddGame), and the snapshot is written while the system keeps changing - the file holds the levels
+ * at the time of the call. the export must be completed with chessWaitPlayersLevelsExport.
+ *
+ * @param chess - chess system that contains the players.
+ * @param file - the file to print to. it must stay open, and not be used, until the export is completed.
+ * @param levels_export - a pointer where to put the handle of the export.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_OUT_OF_MEMORY - if the snapshot could not be allocated. nothing is written.
+ *     CHESS_SUCCESS - otherwise, the export was started.
+ */
+ChessResult chessSavePlayersLevelsAsync(ChessSystem chess, FILE* file, ChessLevelsExport* levels_export);
+
+/**
+ * chessIsPlayersLevelsExportDone: checks without waiting if an export has finished writing.
+ *
+ * @param levels_export - the export.
+ * @return
+ *     true - if the export has finished, or for NULL.
+ *     false - otherwise.
+ */
+bool chessIsPlayersLevelsExportDone(ChessLevelsExport levels_export);
+
+/**
+ * chessWaitPlayersLevelsExport: waits until an export has finished writing, and deallocates it.
+ *
+ * @param levels_export - the export. it is not valid after the call.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if levels_export is NULL.
+ *     CHESS_OUT_OF_MEMORY - if an allocation of the export failed.
+ *     CHESS_SAVE_FAILURE - if writing to the file failed.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessWaitPlayersLevelsExport(ChessLevelsExport levels_export);
+
+/** Type of function that chessIngestFile calls for every line of a feed that was not added,
+ * with the number of the line (from 1), the result of the line and the context of the call */
+typedef void (*ChessIngestErrorFunction)(int line_number, ChessResult result, void* context);
+
+/**
+ * chessIngestFile: adds the games of a feed file, as calling chessAddGame for every line in order.
+ * a line holds five integers that are separated by spaces, tabs or commas: tournament id, first player,
+ * second player, winner and play time. the winner is the id of one of the players, or 0 for a draw.
+ * empty lines and lines that start with '#' are skipped.
+ * the file is read and parsed by a separate thread in large batches, and the games of a batch
+ * are added in parallel by shard, so the time is bound by adding the games and not by reading them.
+ *
+ * @param chess - chess system to add the games to.
+ * @param path_file - the path of the feed file.
+ * @param on_error - function that is called for every line that was not added, in the order of the file,
+ *     with the result of chessAddGame for it, or CHESS_INVALID_ID for a line that is not five integers
+ *     or with a winner that is not one of the players. may be NULL.
+ * @param context - a pointer that is passed as is to on_error.
+ * @param num_of_games - a pointer where to put the number of games that were added.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess, path_file or num_of_games is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be opened or read. the games before the failure are added.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed. the ingestion stops after the batch of the failure.
+ *     CHESS_SUCCESS - otherwise, also when some of the lines were not added.
+ */
+ChessResult chessIngestFile(ChessSystem chess, const char* path_file, ChessIngestErrorFunction on_error,
+                            void* context, int* num_of_games);
+
+/**
+ * chessSaveTournamentStatisticsDelta: appends to a file the statistics of the ended tournaments that changed
+ * since the last call - the tournaments that ended, and the ended tournaments that a removed player has played in.
+ * the system keeps the set of these tournaments as they change, so the cost of a call is bound by the
+ * tournaments it writes and not by all the ended tournaments.
+ * every tournament is written as a line with its id, followed by the six lines of its block in
+ * chessSaveTournamentStatistics, in the order of the ids. a tournament may appear again in a later call,
+ * after a player removal; the later block replaces the earlier one. removed tournaments are not reported.
+ * a system that is loaded from a snapshot writes all its ended tournaments in the first call.
+ *
+ * @param chess - chess system that contains the tournaments.
+ * @param path_file - the file to append to, created if it does not exist.
+ * @param num_of_tournaments - a pointer where to put the number of tournaments that were written.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_SAVE_FAILURE - if the file could not be written. the tournaments are written again by the next call.
+ *     CHESS_SUCCESS - otherwise, also when no tournament changed (nothing is appended).
+ */
+ChessResult chessSaveTournamentStatisticsDelta(ChessSystem chess, char* path_file, int* num_of_tournaments);
+
+/**
+ * chessSavePlayersLevelsDelta: prints to a file the players whose level changed since the last call.
+ * every player that a game, a tournament removal or a player removal has changed is marked, so the call
+ * walks the players once and writes only the marked ones, without sorting all of them.
+ * a line is "+ <id> <level> <rank>" for a player that has played, with the level as in
+ * chessSavePlayersLevels and the rank as the line of the player there (from 1), or "- <id>" for a player
+ * that was removed or has no games left. the lines are in the order of the ids.
+ * the ranks of the players that did not change may move too; they are not reported.
+ * a system that is loaded from a snapshot prints all its players in the first call.
+ *
+ * @param chess - chess system that contains the players.
+ * @param file - the file to print to.
+ * @param num_of_players - a pointer where to put the number of lines that were printed.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed. nothing is printed.
+ *     CHESS_SAVE_FAILURE - if the file could not be written. the players are printed again by the next call.
+ *     CHESS_SUCCESS - otherwise, also when no player changed.
+ */
+ChessResult chessSavePlayersLevelsDelta(ChessSystem chess, FILE* file, int* num_of_players);
+
+/** The public functions that are measured by the metrics of the system and recorded by its trace */
+typedef enum ChessApi_t {
+    CHESS_API_ADD_TOURNAMENT,
+    CHESS_API_ADD_GAME,
+    CHESS_API_REMOVE_TOURNAMENT,
+    CHESS_API_END_TOURNAMENT,
+    CHESS_API_END_TOURNAMENTS,
+    CHESS_API_REMOVE_PLAYER,
+    CHESS_API_AVERAGE_PLAY_TIME,
+    CHESS_API_SAVE_PLAYERS_LEVELS,
+    CHESS_API_SAVE_TOURNAMENT_STATISTICS,
+    CHESS_API_SAVE_SNAPSHOT,
+    CHESS_API_INGEST_FILE,
+    CHESS_API_SAVE_TOURNAMENT_STATISTICS_DELTA,
+    CHESS_API_SAVE_PLAYERS_LEVELS_DELTA,
+    CHESS_API_GET_TOURNAMENTS_AT_LOCATION,
+    CHESS_API_GET_LOCATION_STATISTICS,
+    CHESS_API_GET_PLAYER_STATS,
+    CHESS_API_GET_TOURNAMENT_PLAYER_STATS,
+    CHESS_NUM_APIS
+} ChessApi;
+
+/** The number of values of ChessResult */
+#define CHESS_NUM_RESULTS (CHESS_SAVE_FAILURE + 1)
+
+/** The metrics of one function: the number of calls, the number of calls that returned every result
+ * (indexed by ChessResult), and the latency of the calls in nanoseconds. the percentiles are within
+ * about 6% of the exact latency */
+typedef struct ChessApiMetrics_t {
+    long long calls;
+    long long result_counts[CHESS_NUM_RESULTS];
+    long long total_ns;
+    long long max_ns;
+    long long p50_ns;
+    long long p90_ns;
+    long long p99_ns;
+    long long p999_ns;
+} ChessApiMetrics;
+
+/**
+ * chessGetMetrics: returns the metrics of a public function since the system was created.
+ * every call of the function is timed with a monotonic clock and counted by its result, with no lock
+ * on the path of the call. compiling with CHESS_NO_METRICS removes the measurement, and the metrics are 0.
+ *
+ * @param chess - chess system to get the metrics of.
+ * @param api - the function.
+ * @param metrics - a pointer where to put the metrics.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess or metrics is NULL.
+ *     CHESS_INVALID_ID - if api is not one of the functions.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessGetMetrics(ChessSystem chess, ChessApi api, ChessApiMetrics* metrics);
+
+/**
+ * chessDumpMetrics: prints the metrics of every function that was called to a file, a line per function:
+ * the number of calls and errors, the mean, the percentiles and the maximum of the latency in microseconds,
+ * and the number of calls of every result that was returned.
+ *
+ * @param chess - chess system to print the metrics of.
+ * @param file - the file to print to.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if one of the arguments is NULL.
+ *     CHESS_SAVE_FAILURE - if writing to the file failed.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessDumpMetrics(ChessSystem chess, FILE* file);
+
+/**
+ * chessGetApiName: returns the name of a public function of ChessApi.
+ *
+ * @param api - the function.
+ * @return
+ *     NULL - if api is not a value of ChessApi.
+ *     the name of the function - otherwise.
+ */
+const char* chessGetApiName(ChessApi api);
+
+/** The kinds of the events that a system sends to its subscribers */
+typedef enum ChessEventType_t {
+    CHESS_EVENT_GAME_ADDED,
+    CHESS_EVENT_TOURNAMENT_ENDED,
+    CHESS_EVENT_TOURNAMENT_REMOVED,
+    CHESS_EVENT_PLAYER_REMOVED,
+    CHESS_EVENT_PLAYER_STATS
+} ChessEventType;
+
+/** An event of a system. the fields that are not listed for its type are 0:
+ * CHESS_EVENT_GAME_ADDED - the game: tournament_id, player_id (the first player), opponent_id (the second
+ *     player), winner and play_time.
+ * CHESS_EVENT_TOURNAMENT_ENDED - tournament_id, and the id of its winner in player_id.
+ * CHESS_EVENT_TOURNAMENT_REMOVED - tournament_id.
+ * CHESS_EVENT_PLAYER_REMOVED - player_id.
+ * CHESS_EVENT_PLAYER_STATS - a change of the results of player_id: wins, losses, draws and num_of_games are
+ *     added to its totals (negative values take results away). tournament_id is the tournament of the change,
+ *     and opponent_id is the other player of an added game or the removed player whose games became wins
+ *     (with tournament_id 0). */
+typedef struct ChessEvent_t {
+    ChessEventType type;
+    int tournament_id;
+    int player_id;
+    int opponent_id;
+    Winner winner;
+    int play_time;
+    int wins;
+    int losses;
+    int draws;
+    int num_of_games;
+} ChessEvent;
+
+/** Type of function that receives the events of a system, with the context it was subscribed with */
+typedef void (*ChessEventFunction)(const ChessEvent* event, void* context);
+
+/**
+ * chessSubscribe: registers a function that receives an event for every change of the system:
+ * a game added (followed by the changes of the results of its two players), a tournament ended,
+ * a tournament removed (after the changes that take its results away from its players), and a player
+ * removed (after the changes of its opponents, whose games in the tournaments that did not end became wins).
+ * summing the changes of a player gives its results, so a consumer keeps its own view with O(1) per event.
+ * events are sent during the call that made the change, after it succeeded. calls of chessAddGame from
+ * several threads (and chessIngestFile) send their events from those threads, so the function must be safe
+ * to call concurrently, and it must not call functions of the system.
+ *
+ * @param chess - chess system to subscribe to.
+ * @param on_event - the function that receives the events.
+ * @param context - a pointer that is passed as is to on_event.
+ * @param subscription_id - a pointer where to put the id of the subscription, for chessUnsubscribe.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess, on_event or subscription_id is NULL.
+ *     CHESS_OUT_OF_MEMORY - if an allocation failed.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessSubscribe(ChessSystem chess, ChessEventFunction on_event, void* context, int* subscription_id);
+
+/**
+ * chessUnsubscribe: stops sending events to a subscription. an event that is being sent when the call
+ * starts is completed before it returns.
+ *
+ * @param chess - chess system of the subscription.
+ * @param subscription_id - the id that chessSubscribe returned.
+ * @return
+ *     CHESS_NULL_ARGUMENT - if chess is NULL.
+ *     CHESS_INVALID_ID - if there is no subscription with this id.
+ *     CHESS_SUCCESS - otherwise.
+ */
+ChessResult chessUnsubscribe(ChessSystem chess, int subscription_id);
+
+#endif //CHESS_SYSTEM_EXTENDED_H
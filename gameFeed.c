@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L
+#include "gameFeed.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+#define FEED_SLOTS 4
+#define FEED_CHUNK_SIZE (1 << 20)
+#define FEED_FIELDS 5
+#define FEED_COMMENT '#'
+#define DECIMAL_BASE 10
+
+// the parser thread fills the free slots in order, and the reader takes the parsed ones in the same order.
+// the chunk and the position in it belong to the parser thread only
+struct game_feed_t
+{
+    FILE* file;
+    pthread_t parser;
+    pthread_mutex_t lock;
+    pthread_cond_t batch_parsed;
+    pthread_cond_t batch_released;
+    GameFeedRecord* slots[FEED_SLOTS];
+    int slot_sizes[FEED_SLOTS];
+    int first_parsed;
+    int num_parsed;
+    bool reader_holds_batch;
+    bool parsed_all;
+    bool shutdown;
+    bool failed;
+    char* chunk;
+    size_t chunk_length;
+    size_t position;
+    bool end_of_input;
+    bool skipping_line;
+    int line;
+};
+
+/* the loop of the parser thread */
+static void* gameFeedParser(void* game_feed);
+
+/* parse the next lines of the file into a batch. returns the number of records, 0 at the end of the file */
+static int gameFeedFillBatch(GameFeed feed, GameFeedRecord* records);
+
+/* find the next line of the file, reading more of it into the chunk when needed.
+ * a line that does not fit in the chunk is returned as too long, without its content.
+ * false at the end of the file */
+static bool gameFeedNextLine(GameFeed feed, const char** start, const char** end, bool* too_long);
+
+/* read the next part of the file into the chunk, after the part that was not used yet */
+static void gameFeedRead(GameFeed feed);
+
+/* parse the five fields of a line into the record. false if the line is not five integers */
+static bool gameFeedParseLine(const char* start, const char* end, GameFeedRecord* record);
+
+/* parse an integer that ends with a separator or with the end of the line, and move past it.
+ * false if there is no integer or it does not fit in an int */
+static bool gameFeedParseInt(const char** next, const char* end, int* value);
+
+/* move past the separators of the fields */
+static const char* gameFeedSkipSeparators(const char* next, const char* end);
+
+/* check if a character separates fields */
+static bool gameFeedIsSeparator(char character);
+
+GameFeed gameFeedOpen(const char* path)
+{
+    if(path == NULL) {
+        return NULL;
+    }
+    GameFeed feed = malloc(sizeof(*feed));
+    if(feed == NULL) {
+        return NULL;
+    }
+    feed->chunk = malloc(FEED_CHUNK_SIZE);
+    bool allocated = feed->chunk != NULL;
+    for(int i = 0; i < FEED_SLOTS; i++) {
+        feed->slots[i] = malloc(FEED_BATCH_SIZE * sizeof(*feed->slots[i]));
+        allocated = allocated && feed->slots[i] != NULL;
+    }
+    feed->file = allocated ? fopen(path, "rb") : NULL;
+    if(feed->file == NULL) {
+        for(int i = 0; i < FEED_SLOTS; i++) {
+            free(feed->slots[i]);
+        }
+        free(feed->chunk);
+        free(feed);
+        return NULL;
+    }
+    feed->first_parsed = 0;
+    feed->num_parsed = 0;
+    feed->reader_holds_batch = false;
+    feed->parsed_all = false;
+    feed->shutdown = false;
+    feed->failed = false;
+    feed->chunk_length = 0;
+    feed->position = 0;
+    feed->end_of_input = false;
+    feed->skipping_line = false;
+    feed->line = 0;
+    pthread_mutex_init(&feed->lock, NULL);
+    pthread_cond_init(&feed->batch_parsed, NULL);
+    pthread_cond_init(&feed->batch_released, NULL);
+    if(pthread_create(&feed->parser, NULL, gameFeedParser, feed) != 0) {
+        pthread_cond_destroy(&feed->batch_released);
+        pthread_cond_destroy(&feed->batch_parsed);
+        pthread_mutex_destroy(&feed->lock);
+        fclose(feed->file);
+        for(int i = 0; i < FEED_SLOTS; i++) {
+            free(feed->slots[i]);
+        }
+        free(feed->chunk);
+        free(feed);
+        return NULL;
+    }
+    return feed;
+}
+
+const GameFeedRecord* gameFeedNext(GameFeed feed, int* num_of_records)
+{
+    assert(feed != NULL && num_of_records != NULL);
+    pthread_mutex_lock(&feed->lock);
+    if(feed->reader_holds_batch) {
+        feed->first_parsed = (feed->first_parsed + 1) % FEED_SLOTS;
+        feed->num_parsed--;
+        feed->reader_holds_batch = false;
+        pthread_cond_signal(&feed->batch_released);
+    }
+    while(feed->num_parsed == 0 && feed->parsed_all == false) {
+        pthread_cond_wait(&feed->batch_parsed, &feed->lock);
+    }
+    if(feed->num_parsed == 0) {
+        pthread_mutex_unlock(&feed->lock);
+        *num_of_records = 0;
+        return NULL;
+    }
+    feed->reader_holds_batch = true;
+    GameFeedRecord* batch = feed->slots[feed->first_parsed];
+    *num_of_records = feed->slot_sizes[feed->first_parsed];
+    pthread_mutex_unlock(&feed->lock);
+    return batch;
+}
+
+GameFeedResult gameFeedClose(GameFeed feed)
+{
+    if(feed == NULL) {
+        return FEED_SUCCESS;
+    }
+    pthread_mutex_lock(&feed->lock);
+    feed->shutdown = true;
+    pthread_cond_signal(&feed->batch_released);
+    pthread_mutex_unlock(&feed->lock);
+    pthread_join(feed->parser, NULL);
+    bool failed = feed->failed;
+    fclose(feed->file);
+    pthread_cond_destroy(&feed->batch_released);
+    pthread_cond_destroy(&feed->batch_parsed);
+    pthread_mutex_destroy(&feed->lock);
+    for(int i = 0; i < FEED_SLOTS; i++) {
+        free(feed->slots[i]);
+    }
+    free(feed->chunk);
+    free(feed);
+    return failed ? FEED_FILE_ERROR : FEED_SUCCESS;
+}
+
+static void* gameFeedParser(void* game_feed)
+{
+    GameFeed feed = game_feed;
+    pthread_mutex_lock(&feed->lock);
+    while(true)
+    {
+        while(feed->shutdown == false && feed->num_parsed == FEED_SLOTS) {
+            pthread_cond_wait(&feed->batch_released, &feed->lock);
+        }
+        if(feed->shutdown) {
+            break;
+        }
+        // the slot after the parsed ones is free until it is counted, so it is filled without the lock
+        int slot = (feed->first_parsed + feed->num_parsed) % FEED_SLOTS;
+        pthread_mutex_unlock(&feed->lock);
+        int size = gameFeedFillBatch(feed, feed->slots[slot]);
+        pthread_mutex_lock(&feed->lock);
+        if(size == 0) {
+            break;
+        }
+        feed->slot_sizes[slot] = size;
+        feed->num_parsed++;
+        pthread_cond_signal(&feed->batch_parsed);
+    }
+    feed->parsed_all = true;
+    pthread_cond_signal(&feed->batch_parsed);
+    pthread_mutex_unlock(&feed->lock);
+    return NULL;
+}
+
+static int gameFeedFillBatch(GameFeed feed, GameFeedRecord* records)
+{
+    int size = 0;
+    const char* start = NULL;
+    const char* end = NULL;
+    bool too_long = false;
+    while(size < FEED_BATCH_SIZE && gameFeedNextLine(feed, &start, &end, &too_long))
+    {
+        feed->line++;
+        if(too_long == false) {
+            start = gameFeedSkipSeparators(start, end);
+            if(start == end || *start == FEED_COMMENT) {
+                continue;
+            }
+        }
+        GameFeedRecord* record = &records[size++];
+        record->line = feed->line;
+        record->valid = too_long == false && gameFeedParseLine(start, end, record);
+    }
+    return size;
+}
+
+static bool gameFeedNextLine(GameFeed feed, const char** start, const char** end, bool* too_long)
+{
+    *too_long = false;
+    while(true)
+    {
+        char* begin = feed->chunk + feed->position;
+        size_t available = feed->chunk_length - feed->position;
+        char* newline = memchr(begin, '\n', available);
+        if(feed->skipping_line) {
+            if(newline == NULL && feed->end_of_input == false) {
+                feed->position = feed->chunk_length;
+                gameFeedRead(feed);
+                continue;
+            }
+            feed->skipping_line = false;
+            feed->position = newline == NULL ? feed->chunk_length : (size_t)(newline + 1 - feed->chunk);
+            *too_long = true;
+            return true;
+        }
+        if(newline != NULL) {
+            *start = begin;
+            *end = newline;
+            feed->position += newline + 1 - begin;
+            return true;
+        }
+        if(feed->end_of_input) {
+            if(available == 0) {
+                return false;
+            }
+            *start = begin;
+            *end = begin + available;
+            feed->position = feed->chunk_length;
+            return true;
+        }
+        if(available == FEED_CHUNK_SIZE) {
+            feed->skipping_line = true;
+            feed->position = feed->chunk_length;
+        }
+        gameFeedRead(feed);
+    }
+}
+
+static void gameFeedRead(GameFeed feed)
+{
+    size_t available = feed->chunk_length - feed->position;
+    memmove(feed->chunk, feed->chunk + feed->position, available);
+    feed->chunk_length = available;
+    feed->position = 0;
+    size_t read = fread(feed->chunk + available, 1, FEED_CHUNK_SIZE - available, feed->file);
+    feed->chunk_length += read;
+    if(read == 0) {
+        feed->end_of_input = true;
+        if(ferror(feed->file)) {
+            pthread_mutex_lock(&feed->lock);
+            feed->failed = true;
+            pthread_mutex_unlock(&feed->lock);
+        }
+    }
+}
+
+static bool gameFeedParseLine(const char* start, const char* end, GameFeedRecord* record)
+{
+    int* fields[FEED_FIELDS] = {&record->tournament_id, &record->first_player, &record->second_player,
+                                &record->winner, &record->play_time};
+    const char* next = start;
+    for(int i = 0; i < FEED_FIELDS; i++) {
+        next = gameFeedSkipSeparators(next, end);
+        if(gameFeedParseInt(&next, end, fields[i]) == false) {
+            return false;
+        }
+    }
+    return gameFeedSkipSeparators(next, end) == end;
+}
+
+static bool gameFeedParseInt(const char** next, const char* end, int* value)
+{
+    const char* digit = *next;
+    bool negative = digit < end && *digit == '-';
+    if(negative) {
+        digit++;
+    }
+    if(digit == end || *digit < '0' || *digit > '9') {
+        return false;
+    }
+    int result = 0;
+    for(; digit < end && *digit >= '0' && *digit <= '9'; digit++) {
+        int digit_value = *digit - '0';
+        if(result > (INT_MAX - digit_value) / DECIMAL_BASE) {
+            return false;
+        }
+        result = result * DECIMAL_BASE + digit_value;
+    }
+    if(digit < end && gameFeedIsSeparator(*digit) == false) {
+        return false;
+    }
+    *value = negative ? -result : result;
+    *next = digit;
+    return true;
+}
+
+static const char* gameFeedSkipSeparators(const char* next, const char* end)
+{
+    while(next < end && gameFeedIsSeparator(*next)) {
+        next++;
+    }
+    return next;
+}
+
+static bool gameFeedIsSeparator(char character)
+{
+    return character == ' ' || character == '\t' || character == ',' || character == '\r';
+}
@@ -0,0 +1,67 @@
+#ifndef GAME_FEED_H
+#define GAME_FEED_H
+
+#include <stdbool.h>
+
+typedef struct game_feed_t *GameFeed;
+
+/** The maximal number of records of a batch */
+#define FEED_BATCH_SIZE 4096
+
+/** Type used for returning error codes from game feed functions */
+typedef enum GameFeedResult_t {
+    FEED_SUCCESS,
+    FEED_FILE_ERROR
+} GameFeedResult;
+
+/** A line of a feed file: its number (from 1), and the five integers of the game if the line is valid -
+ * tournament id, first player, second player, winner and play time */
+typedef struct GameFeedRecord_t {
+    int line;
+    bool valid;
+    int tournament_id;
+    int first_player;
+    int second_player;
+    int winner;
+    int play_time;
+} GameFeedRecord;
+
+/**
+* gameFeedOpen: open a feed file and start the thread that reads and parses it.
+* a line holds five integers that are separated by spaces, tabs or commas. empty lines
+* and lines that start with '#' are skipped, any other line that is not five integers
+* is returned as a record that is not valid.
+* the parser thread fills batches of records ahead of the reader, so parsing the next batch
+* overlaps with the use of the current one.
+*
+* @param path - the path of the feed file.
+* @return
+* 	NULL - a NULL path was sent, the file could not be opened or allocation failed.
+* 	pointer to the feed - otherwise.
+*/
+GameFeed gameFeedOpen(const char* path);
+
+/**
+* gameFeedNext: returns the next batch of records, in the order of the file, and waits for it if
+* it is not parsed yet. the previous batch is given back to the parser thread, so it is not valid anymore.
+*
+* @param feed - the feed.
+* @param num_of_records - a pointer where to put the number of records of the batch, 0 at the end of the file.
+* @return
+* 	NULL - the end of the file was reached, or reading it failed (reported by gameFeedClose).
+* 	the records of the batch - otherwise.
+*/
+const GameFeedRecord* gameFeedNext(GameFeed feed, int* num_of_records);
+
+/**
+* gameFeedClose: stop the parser thread, close the file and deallocate the feed.
+* may be called before the end of the file.
+*
+* @param feed - the feed to close.
+* @return
+* 	FEED_FILE_ERROR - reading the file failed.
+* 	FEED_SUCCESS - otherwise, or for a NULL feed.
+*/
+GameFeedResult gameFeedClose(GameFeed feed);
+
+#endif //GAME_FEED_H
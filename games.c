@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include "games.h"
+#include "mapExtended.h"
 #include "stdlib.h"
 #include "assert.h"
 #define QUIT (-2)
@@ -7,12 +8,14 @@
 #define ADD 1
 #define DRAW (-1)
 #define EQUAL 0
+#define GAME_RECORD_SIZE 16
 
 
 
 struct Map_Head
 {
     Map head;
+    GameData frozen;
     int longest_game;
     int number_games;
     int number_players;
@@ -25,6 +28,14 @@ struct GameData_t
     int time;
     int winner;
 };
+/* the context of the walks of gameExist and gamePlayedTime */
+typedef struct GameSearch_t
+{
+    int first_id;
+    int second_id;
+    bool found;
+    double time;
+} GameSearch;
 /* copy the game data. pointer if success, NULL if failed. */
 static MapDataElement copyGameData(MapDataElement game_data);
 /* update player both list */
@@ -32,31 +43,46 @@ static void updatePlayerBothData(Map internal_player, Map external_player, Playe
                                  int id, int factor);
 /* update the data and score of a quit player. */
 static void checkAndUpdateScore(GameData data, int check_id, Map internal_player,
-                                Map external_player, int id_quit);
+                                Map external_player, int id_quit, PlayerStatsFunction on_change, void* context);
 /* convert the winner enum to the winner id */
 static int convertWinnerToInt(int first_id, int second_id, Winner winner);
 /* update the game data */
 static void updateGameData(GameData data, int id1, int id2, int winner, int time);
-/* allocate a new data and key. return NULL if failed. */
-static GameResult allocateNew(GameData* data, int** key);
-/* free the game data and key */
-static void freeDataAndKey(int* key, GameData data);
 /* update a data about a new game added */
 static void updateNewGame(MapHead game, int time, bool first, bool second);
 /* compare between 2 pairs of numbers */
 static bool compareNumber(int first, int second, int first2, int second2);
+/* copy the packed games of a frozen game map. NULL if failed. */
+static GameData copyFrozenGames(MapHead game);
+/* write a game record to a snapshot */
+static void saveGameData(SnapshotWriter writer, GameData data);
+/* apply function for gameSave: write the record of a game (the context is the writer) */
+static void saveGameRecord(MapKeyElement game_id, MapDataElement game_data, void* writer);
+/* apply function for gameFreeze: copy the game into the next packed game (the context is a GameData*) */
+static void freezeGameData(MapKeyElement game_id, MapDataElement game_data, void* next_frozen);
+/* apply function for gameExist: mark the search as found when the game is between its players */
+static void findGame(MapKeyElement game_id, MapDataElement game_data, void* search);
+/* apply function for gamePlayedTime: add the time of the game when the player of the search played it */
+static void addPlayedTime(MapKeyElement game_id, MapDataElement game_data, void* search);
 
-MapHead gameCreate()
+MapHead gameCreate(Arena arena)
 {
     MapHead new = malloc(sizeof(*new));
     if(new == NULL) {
         return NULL;
     }
-    new->head = mapCreate(copyGameData, copyIntKey, destroyNode, destroyIntKey, intKeyCompare);
+    if(arena != NULL){
+        new->head = mapCreateInArena(copyGameData, copyIntKey, destroyNode, destroyIntKey, intKeyCompare,
+                                     sizeof(int), sizeof(struct GameData_t), arena);
+    }
+    else{
+        new->head = mapCreate(copyGameData, copyIntKey, destroyNode, destroyIntKey, intKeyCompare);
+    }
     if(new->head == NULL){
         free(new);
         return NULL;
     }
+    new->frozen = NULL;
     new->longest_game = 0;
     new->number_games = 0;
     new->number_players = 0;
@@ -69,8 +95,15 @@ MapHead gameCopy(MapHead game)
     if(new == NULL){
         return NULL;
     }
-    new->head = mapCopy(game->head);
-    if(new->head == NULL){
+    new->head = NULL;
+    new->frozen = NULL;
+    if(game->frozen != NULL){
+        new->frozen = copyFrozenGames(game);
+    }
+    else{
+        new->head = mapCopy(game->head);
+    }
+    if(new->head == NULL && new->frozen == NULL){
         free(new);
         return NULL;
     }
@@ -86,70 +119,90 @@ void gameDestroy(MapHead game)
         return;
     }
     mapDestroy(game->head);
+    free(game->frozen);
     free(game);
 }
 GameResult gameAdd(MapHead game, Map players, int first_id, int second_id, Winner winner_id, int play_time)
 {
     assert(first_id > 0 && second_id > 0 && play_time >= 0 && game != NULL && players != NULL);
-    int* new_id = NULL;
-    GameData new_data = NULL;
-    if(allocateNew(&new_data, &new_id)== GAME_OUT_OF_MEMORY){
-        return GAME_OUT_OF_MEMORY;
-    }
-    *new_id = game->number_games;
+    assert(game->frozen == NULL);
+    // the map copies the key and the data, so they are kept on the stack
+    int new_id = game->number_games;
+    struct GameData_t new_data;
     int winner = convertWinnerToInt(first_id, second_id, winner_id);
-    updateGameData(new_data, first_id, second_id, winner, play_time);
-    if(mapPut(game->head, new_id, new_data) == MAP_OUT_OF_MEMORY)
+    updateGameData(&new_data, first_id, second_id, winner, play_time);
+    if(mapPut(game->head, &new_id, &new_data) == MAP_OUT_OF_MEMORY)
     {
-        freeDataAndKey(new_id, new_data);
         return GAME_OUT_OF_MEMORY;
     }
     bool first_alloc = false, second_alloc = false;
     if(playersAdd(players, first_id, second_id, &first_alloc, &second_alloc) == PLAYER_MEMORY_FAILED)
     {
         mapRemove(game->head, &new_id);
-        freeDataAndKey(new_id, new_data);
         return GAME_OUT_OF_MEMORY;
     }
     updateExternalPlayer(players, winner_id, first_id, second_id);
     updateNewGame(game, play_time, first_alloc, second_alloc);
-    freeDataAndKey(new_id, new_data);
     return GAME_SUCCESS;
 }
-void gameUpdateQuitPlayer(MapHead game, Map internal_player,
-                          Map external_player, int id_quit_player)
+void gameUpdateQuitPlayer(MapHead game, Map internal_player, Map external_player, int id_quit_player,
+                          PlayerStatsFunction on_change, void* context)
 {
     assert(game != NULL && internal_player != NULL && external_player != NULL);
+    assert(game->frozen == NULL);
     MAP_FOREACH(int*, iter, game->head)
     {
         GameData current_data = mapGet(game->head, iter);
         if(current_data->first_id == id_quit_player ) {
             current_data->first_id = QUIT;
             checkAndUpdateScore(current_data, current_data->second_id, internal_player,
-                                external_player, id_quit_player);
+                                external_player, id_quit_player, on_change, context);
         }
         if(current_data->second_id == id_quit_player ) {
             current_data->second_id = QUIT;
             checkAndUpdateScore(current_data, current_data->first_id, internal_player,
-                                external_player, id_quit_player);
+                                external_player, id_quit_player, on_change, context);
         }
         destroyIntKey(iter);
     }
 }
+GameResult gameFreeze(MapHead game)
+{
+    if(game == NULL){
+        return GAME_NULL_ARGUMENT;
+    }
+    if(game->frozen != NULL){
+        return GAME_SUCCESS;
+    }
+    assert(mapGetSize(game->head) == game->number_games);
+    GameData frozen = malloc((game->number_games + 1) * sizeof(*frozen));
+    if(frozen == NULL){
+        return GAME_OUT_OF_MEMORY;
+    }
+    GameData next_frozen = frozen;
+    mapApply(game->head, freezeGameData, &next_frozen);
+    assert(next_frozen - frozen == game->number_games);
+    mapDestroy(game->head);
+    game->head = NULL;
+    game->frozen = frozen;
+    return GAME_SUCCESS;
+}
 bool gameExist(MapHead game, int first_id, int second_id) {
     if (game == NULL) {
         return false;
     }
-    MAP_FOREACH(int*, iter, game->head)
-    {
-        GameData current_data = mapGet(game->head, iter);
-        if(compareNumber(current_data->first_id, current_data->second_id, first_id, second_id)){
-            destroyIntKey(iter);
-            return true;
+    if (game->frozen != NULL) {
+        for (int i = 0; i < game->number_games; i++) {
+            if(compareNumber(game->frozen[i].first_id, game->frozen[i].second_id, first_id, second_id)){
+                return true;
+            }
         }
-        destroyIntKey(iter);
+        return false;
     }
-    return false;
+    // mapApply does not copy the keys, so a rejected game costs no allocation
+    GameSearch search = {first_id, second_id, false, 0};
+    mapApply(game->head, findGame, &search);
+    return search.found;
 }
 double gamePlayedTime(MapHead game, int id)
 {
@@ -157,15 +210,17 @@ double gamePlayedTime(MapHead game, int id)
         return 0;
     }
     double time = 0;
-    MAP_FOREACH(int*, iter, game->head)
-    {
-        GameData current_data = mapGet(game->head, iter);
-        if(current_data->first_id == id || current_data -> second_id == id){
-            time += current_data->time;
+    if(game->frozen != NULL){
+        for (int i = 0; i < game->number_games; i++) {
+            if(game->frozen[i].first_id == id || game->frozen[i].second_id == id){
+                time += game->frozen[i].time;
+            }
         }
-        destroyIntKey(iter);
+        return time;
     }
-    return time;
+    GameSearch search = {id, id, false, 0};
+    mapApply(game->head, addPlayedTime, &search);
+    return search.time;
 }
 double gameAvgTime(MapHead game)
 {
@@ -174,6 +229,11 @@ double gameAvgTime(MapHead game)
     }
     return ((game->total_time)/(game->number_games));
 }
+double gameTotalTime(MapHead game)
+{
+    assert(game != NULL);
+    return game->total_time;
+}
 int gameGetInfo(MapHead game, GameInformation info)
 {
     assert(game != NULL);
@@ -188,6 +248,51 @@ int gameGetInfo(MapHead game, GameInformation info)
     }
     return game->longest_game;
 }
+GameResult gameSave(MapHead game, SnapshotWriter writer)
+{
+    if(game == NULL || writer == NULL){
+        return GAME_NULL_ARGUMENT;
+    }
+    snapshotWriteInt(writer, game->longest_game);
+    snapshotWriteInt(writer, game->number_players);
+    snapshotWriteDouble(writer, game->total_time);
+    snapshotWriteInt(writer, game->number_games);
+    if(game->frozen != NULL){
+        for (int i = 0; i < game->number_games; i++) {
+            saveGameData(writer, &game->frozen[i]);
+        }
+        return GAME_SUCCESS;
+    }
+    mapApply(game->head, saveGameRecord, writer);
+    return GAME_SUCCESS;
+}
+GameResult gameLoad(MapHead game, SnapshotReader reader)
+{
+    if(game == NULL || reader == NULL){
+        return GAME_NULL_ARGUMENT;
+    }
+    assert(game->frozen == NULL && game->number_games == 0);
+    game->longest_game = snapshotReadInt(reader);
+    game->number_players = snapshotReadInt(reader);
+    game->total_time = snapshotReadDouble(reader);
+    int number_games = snapshotReadCount(reader, GAME_RECORD_SIZE);
+    struct GameData_t data;
+    for (int key = 0; key < number_games && snapshotReaderFailed(reader) == false; key++) {
+        data.first_id = snapshotReadInt(reader);
+        data.second_id = snapshotReadInt(reader);
+        data.time = snapshotReadInt(reader);
+        data.winner = snapshotReadInt(reader);
+        if(data.time < 0 || data.time > game->longest_game){
+            snapshotReaderReject(reader);
+            break;
+        }
+        if(mapPut(game->head, &key, &data) == MAP_OUT_OF_MEMORY){
+            return GAME_OUT_OF_MEMORY;
+        }
+        game->number_games++;
+    }
+    return GAME_SUCCESS;
+}
 static MapDataElement copyGameData(MapDataElement game_data)
 {
     if(game_data == NULL){
@@ -214,12 +319,6 @@ static void updateGameData(GameData data, int id1, int id2, int winner, int time
     data->winner = winner;
     data->time = time;
 }
-static void freeDataAndKey(int* key, GameData data)
-{
-    assert(key != NULL && data != NULL);
-    destroyIntKey(key);
-    destroyNode(data);
-}
 static void updateNewGame(MapHead game, int time, bool first, bool second)
 {
     if(game->longest_game < time){
@@ -234,21 +333,9 @@ static void updateNewGame(MapHead game, int time, bool first, bool second)
         game->number_players++;
     }
 }
-static GameResult allocateNew(GameData* data, int** key) {
-
-    *key = malloc(sizeof(int));
-    if (*key == NULL) {
-        return GAME_OUT_OF_MEMORY;
-    }
-    *data = malloc(sizeof(**data));
-    if (*data == NULL) {
-        destroyIntKey(key);
-        return GAME_OUT_OF_MEMORY;
-    }
-    return GAME_SUCCESS;
-}
 static void checkAndUpdateScore(GameData data, int check_id, Map internal_player,
-                                Map external_player, int id_quit_player)
+                                Map external_player, int id_quit_player, PlayerStatsFunction on_change,
+                                void* context)
 {
     assert(data != NULL && internal_player != NULL && external_player != NULL);
     if(check_id != QUIT)
@@ -256,14 +343,21 @@ static void checkAndUpdateScore(GameData data, int check_id, Map internal_player
         if(data->winner == check_id){
             return;
         }
+        // the loss or the draw becomes a win, the number of games stays the same
+        PlayerStats change = {1, 0, 0, 0};
         if(data->winner == id_quit_player){
             updatePlayerBothData(internal_player, external_player, PLAYER_LOSS, check_id, DELETE);
+            change.losses = -1;
         }
         if(data->winner == DRAW){
             updatePlayerBothData(internal_player, external_player, PLAYER_DRAWS, check_id, DELETE);
+            change.draws = -1;
         }
         updatePlayerBothData(internal_player, external_player, PLAYER_WIN, check_id, ADD);
         data->winner = check_id;
+        if(on_change != NULL){
+            on_change(check_id, change, context);
+        }
         return;
     }
     data->winner = QUIT;
@@ -296,3 +390,55 @@ static int convertWinnerToInt(int first_id, int second_id, Winner winner)
     }
     return DRAW;
 }
+static void saveGameData(SnapshotWriter writer, GameData data)
+{
+    assert(writer != NULL && data != NULL);
+    snapshotWriteInt(writer, data->first_id);
+    snapshotWriteInt(writer, data->second_id);
+    snapshotWriteInt(writer, data->time);
+    snapshotWriteInt(writer, data->winner);
+}
+static void saveGameRecord(MapKeyElement game_id, MapDataElement game_data, void* writer)
+{
+    assert(game_id != NULL && game_data != NULL && writer != NULL);
+    saveGameData(writer, game_data);
+}
+static void freezeGameData(MapKeyElement game_id, MapDataElement game_data, void* next_frozen)
+{
+    assert(game_id != NULL && game_data != NULL && next_frozen != NULL);
+    GameData* next = next_frozen;
+    **next = *(GameData)game_data;
+    (*next)++;
+}
+static void findGame(MapKeyElement game_id, MapDataElement game_data, void* search)
+{
+    assert(game_id != NULL && game_data != NULL && search != NULL);
+    GameSearch* game_search = search;
+    GameData data = game_data;
+    // the walk cannot stop, so the games after the found one are skipped here
+    if(!game_search->found){
+        game_search->found = compareNumber(data->first_id, data->second_id,
+                                           game_search->first_id, game_search->second_id);
+    }
+}
+static void addPlayedTime(MapKeyElement game_id, MapDataElement game_data, void* search)
+{
+    assert(game_id != NULL && game_data != NULL && search != NULL);
+    GameSearch* game_search = search;
+    GameData data = game_data;
+    if(data->first_id == game_search->first_id || data->second_id == game_search->first_id){
+        game_search->time += data->time;
+    }
+}
+static GameData copyFrozenGames(MapHead game)
+{
+    assert(game != NULL && game->frozen != NULL);
+    GameData frozen = malloc((game->number_games + 1) * sizeof(*frozen));
+    if(frozen == NULL){
+        return NULL;
+    }
+    for (int i = 0; i < game->number_games; i++) {
+        frozen[i] = game->frozen[i];
+    }
+    return frozen;
+}
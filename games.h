@@ -20,11 +20,12 @@ typedef enum MapGameInformation_t {
 /**
 * gameCreate: Allocates a new game Map.
 *
+* @param arena - the arena that the games are allocated from, NULL to allocate every game on its own.
 * @return
 *   pointer to the map - the allocation succeeded.
 * 	NULL - allocations failed.
 */
-MapHead gameCreate();
+MapHead gameCreate(Arena arena);
 /**
 * gameCopy: copy a game map
 *
@@ -64,12 +65,25 @@ GameResult gameAdd(MapHead game, Map players, int first_id, int second_id, Winne
  * @param internal_player - pointer to the players map.
   * @param external_player - pointer to the  external players map.
  * @param id_quit_player - the id of the quit player.
+ * @param on_change - function that is called with the change of the results of every opponent
+ * whose game became a win, NULL for none.
+ * @param context - a pointer that is passed as is to on_change.
  * assert that all the data are correct.
  * @return
  * nothing.
 */
-void gameUpdateQuitPlayer(MapHead game, Map internal_player,
-                          Map external_player, int id_quit_player);
+void gameUpdateQuitPlayer(MapHead game, Map internal_player, Map external_player, int id_quit_player,
+                          PlayerStatsFunction on_change, void* context);
+/**
+* gameFreeze: compact the games into one packed array of game records and release the map.
+ * after the freeze no game can be added or updated, but all the queries work as before.
+ * if the allocation fails the games stay as they were.
+* @param game - pointer to the game map.
+ * @return
+ * GAME_OUT_OF_MEMORY - allocation failed.
+ * GAME_SUCCESS - compacted successfully (or was already compacted).
+*/
+GameResult gameFreeze(MapHead game);
 /**
 * gameExist: chekc if there is game with this 2 id.
 * @param game - pointer to the game map.
@@ -95,6 +109,13 @@ double gamePlayedTime(MapHead game, int id);
 */
 double gameAvgTime(MapHead game);
 /**
+* gameTotalTime: return the total play time of all the games.
+* @param game - pointer to the map games.
+* @return
+* 	the total time.
+*/
+double gameTotalTime(MapHead game);
+/**
 * gameGetInfo: return a info about the games.
 * @param game - pointer to the map games.
 * @return
@@ -103,4 +124,25 @@ double gameAvgTime(MapHead game);
  * 	GAME_LONGEST - the longest game.
 */
 int gameGetInfo(MapHead game, GameInformation info);
+/**
+* gameSave: write the summary and all the game records to a snapshot, frozen or not.
+* @param game - pointer to the map games.
+* @param writer - the snapshot to write to.
+ * @return
+ * GAME_NULL_ARGUMENT - a NULL was sent.
+ * GAME_SUCCESS - otherwise.
+*/
+GameResult gameSave(MapHead game, SnapshotWriter writer);
+/**
+* gameLoad: read games that were written by gameSave into an empty game map.
+ * the records are added in the order of their keys, so each of them is appended to the map.
+ * a record that is not valid fails the reader.
+* @param game - pointer to an empty map games.
+* @param reader - the snapshot to read from.
+ * @return
+ * GAME_NULL_ARGUMENT - a NULL was sent.
+ * GAME_OUT_OF_MEMORY - allocation failed.
+ * GAME_SUCCESS - otherwise, also when the reader failed.
+*/
+GameResult gameLoad(MapHead game, SnapshotReader reader);
 #endif //MTM_3_2_GAMES_H
@@ -0,0 +1,139 @@
+#include "histogram.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define MAX_VALUE_BITS 48
+#define HISTOGRAM_BUCKETS ((MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+#define PERCENT 100.0
+
+// the counters are updated with atomic operations (gcc builtins), without a lock,
+// so concurrent calls that are measured do not wait for each other
+struct histogram_t
+{
+    long long counts[HISTOGRAM_BUCKETS];
+    long long count;
+    long long total;
+    long long max;
+};
+
+/* the bucket of a value: values below SUB_BUCKETS have a bucket each, and every power of two above
+ * them is split into SUB_BUCKETS buckets. values that are too large go to the last bucket */
+static int histogramBucket(unsigned long long value);
+
+/* the highest value of a bucket */
+static long long histogramBucketTop(int bucket);
+
+/* the position of the highest set bit of a positive value */
+static int histogramHighestBit(unsigned long long value);
+
+Histogram histogramCreate()
+{
+    Histogram histogram = calloc(1, sizeof(*histogram));
+    if(histogram == NULL) {
+        return NULL;
+    }
+    return histogram;
+}
+
+void histogramDestroy(Histogram histogram)
+{
+    free(histogram);
+}
+
+void histogramRecord(Histogram histogram, long long value)
+{
+    assert(histogram != NULL);
+    if(value < 0) {
+        value = 0;
+    }
+    __atomic_fetch_add(&histogram->counts[histogramBucket(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->total, value, __ATOMIC_RELAXED);
+    long long max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    while(value > max &&
+          __atomic_compare_exchange_n(&histogram->max, &max, value, false, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED) == false) {
+    }
+}
+
+long long histogramGetCount(Histogram histogram)
+{
+    assert(histogram != NULL);
+    return __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+}
+
+long long histogramGetTotal(Histogram histogram)
+{
+    assert(histogram != NULL);
+    return __atomic_load_n(&histogram->total, __ATOMIC_RELAXED);
+}
+
+long long histogramGetMax(Histogram histogram)
+{
+    assert(histogram != NULL);
+    return __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+}
+
+long long histogramGetPercentile(Histogram histogram, double percentile)
+{
+    assert(histogram != NULL);
+    long long count = histogramGetCount(histogram);
+    if(count == 0) {
+        return 0;
+    }
+    if(percentile > PERCENT) {
+        percentile = PERCENT;
+    }
+    // the rank of the value, from 1: the smallest value that has at least the percentile below or at it
+    long long rank = (long long)(percentile / PERCENT * count + 0.5);
+    if(rank < 1) {
+        rank = 1;
+    }
+    long long max = histogramGetMax(histogram);
+    long long seen = 0;
+    for(int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        seen += __atomic_load_n(&histogram->counts[bucket], __ATOMIC_RELAXED);
+        if(seen >= rank) {
+            long long top = histogramBucketTop(bucket);
+            return top < max ? top : max;
+        }
+    }
+    return max;
+}
+
+static int histogramBucket(unsigned long long value)
+{
+    if(value < SUB_BUCKETS) {
+        return (int)value;
+    }
+    int bit = histogramHighestBit(value);
+    if(bit >= MAX_VALUE_BITS) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    int sub_bucket = (int)((value >> (bit - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (bit - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+static long long histogramBucketTop(int bucket)
+{
+    if(bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int bit = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    int sub_bucket = bucket % SUB_BUCKETS;
+    long long width = 1LL << (bit - SUB_BUCKET_BITS);
+    return (1LL << bit) + (sub_bucket + 1) * width - 1;
+}
+
+static int histogramHighestBit(unsigned long long value)
+{
+    assert(value > 0);
+    int bit = 0;
+    while(value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
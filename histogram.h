@@ -0,0 +1,57 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+typedef struct histogram_t *Histogram;
+
+/**
+* histogramCreate: create a new empty histogram of non negative values (latencies in nanoseconds).
+* the values are counted in buckets of a fixed relative width (HDR style): every power of two
+* is split into the same number of sub buckets, so a percentile is within about 6% of the exact value
+* for any magnitude, and recording a value costs a few instructions and no allocation.
+*
+* @return
+* 	NULL - allocation failed.
+* 	pointer to the histogram - otherwise.
+*/
+Histogram histogramCreate();
+
+/**
+* histogramDestroy: deallocate the histogram.
+*
+* @param histogram - pointer to the histogram.
+*/
+void histogramDestroy(Histogram histogram);
+
+/**
+* histogramRecord: add a value to the histogram. may be called from several threads at once.
+*
+* @param histogram - pointer to the histogram.
+* @param value - the value, a negative value is counted as 0.
+*/
+void histogramRecord(Histogram histogram, long long value);
+
+/**
+* histogramGetCount / histogramGetTotal / histogramGetMax: the number of recorded values,
+* their sum and the largest of them.
+*
+* @param histogram - pointer to the histogram.
+* @return
+* 	the count, the sum or the largest value. 0 for an empty histogram.
+*/
+long long histogramGetCount(Histogram histogram);
+long long histogramGetTotal(Histogram histogram);
+long long histogramGetMax(Histogram histogram);
+
+/**
+* histogramGetPercentile: return the value that the given percent of the recorded values are not above.
+* the value is the highest value of its bucket (never above the largest value).
+*
+* @param histogram - pointer to the histogram.
+* @param percentile - the percent, between 0 and 100.
+* @return
+* 	0 - the histogram is empty.
+* 	the value of the percentile - otherwise.
+*/
+long long histogramGetPercentile(Histogram histogram, double percentile);
+
+#endif //HISTOGRAM_H
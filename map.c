@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "map.h"
+#include "mapExtended.h"
 #define EQUAL 0
 
 typedef struct node_t{
@@ -17,10 +19,18 @@ typedef struct MapFunctions{
     compareMapKeyElements CompareKeyElement;
 }Functions;
 
+// a map in an arena keeps every node with its key and data in one block of the arena,
+// and the blocks of removed nodes in a list for the next puts
 struct Map_t{
     Functions MapFunc;
     MapNode head;
+    MapNode last;
     MapNode iterator;
+    int size;
+    Arena arena;
+    size_t key_size;
+    size_t data_size;
+    MapNode free_nodes;
 };
 /* add a new key to the map.
  * return MAP_SUCCESS if added, or MAP_OUT_OF_MEMORY if there was allocation error */
@@ -28,10 +38,16 @@ static MapResult addNewKey(Map map, MapKeyElement keyElement, MapDataElement dat
 /* update an exist key with a new data.
  * return MAP_SUCCESS if updated successfully, or MAP_OUT_OF_MEMORY if there was allocation error */
 static MapResult updateMapKey(Map map, MapKeyElement keyElement, MapDataElement dataElement);
+/* allocate a node of a map. in an arena, the key and the data are copied into the node.
+ * NULL if there was allocation error */
+static MapNode allocateMapNode(Map map, MapKeyElement keyElement, MapDataElement dataElement);
 /* update a map node with a data using map copy function */
 static void updateMapNode(Map map, MapNode new, MapNode original);
 /* deallocate the key, data and the node of the map. */
 static void freeMapNode(Map map, MapNode to_delete);
+/* compare the key with the last key of the map: negative if the key is greater than all the keys,
+ * EQUAL if it is the last key, positive otherwise (or for an empty map) */
+static int compareWithLast(Map map, MapKeyElement keyElement);
 /* check if the allocation of a new node failed during a copy map.
  * if yes, remove the map and return true. if no return false */
 static bool checkAllocationFailed(Map copied_map, MapNode new);
@@ -51,7 +67,43 @@ Map mapCreate(copyMapDataElements copyDataElement,
         return NULL;
     }
     new_map->head = NULL;
+    new_map->last = NULL;
     new_map->iterator = NULL;
+    new_map->size = 0;
+    new_map->arena = NULL;
+    new_map->key_size = 0;
+    new_map->data_size = 0;
+    new_map->free_nodes = NULL;
+    new_map->MapFunc.CopyDataElement = copyDataElement;
+    new_map->MapFunc.CopyKeyElement = copyKeyElement;
+    new_map->MapFunc.FreeMapDataElement = freeDataElement;
+    new_map->MapFunc.FreeMapKeyElement = freeKeyElement;
+    new_map->MapFunc.CompareKeyElement = compareKeyElements;
+    return new_map;
+}
+Map mapCreateInArena(copyMapDataElements copyDataElement,
+                     copyMapKeyElements copyKeyElement,
+                     freeMapDataElements freeDataElement,
+                     freeMapKeyElements freeKeyElement,
+                     compareMapKeyElements compareKeyElements,
+                     size_t key_size, size_t data_size, Arena arena)
+{
+    if(copyDataElement == NULL || copyKeyElement == NULL || freeDataElement == NULL||
+       freeKeyElement == NULL || compareKeyElements == NULL || arena == NULL) {
+        return NULL;
+    }
+    Map new_map = arenaAlloc(arena, sizeof(*new_map));
+    if(new_map == NULL) {
+        return NULL;
+    }
+    new_map->head = NULL;
+    new_map->last = NULL;
+    new_map->iterator = NULL;
+    new_map->size = 0;
+    new_map->arena = arena;
+    new_map->key_size = key_size;
+    new_map->data_size = data_size;
+    new_map->free_nodes = NULL;
     new_map->MapFunc.CopyDataElement = copyDataElement;
     new_map->MapFunc.CopyKeyElement = copyKeyElement;
     new_map->MapFunc.FreeMapDataElement = freeDataElement;
@@ -61,9 +113,11 @@ Map mapCreate(copyMapDataElements copyDataElement,
 }
 void mapDestroy(Map map)
 {
-    if(mapClear(map) == MAP_NULL_ARGUMENT) {
+    // the memory of a map in an arena is freed with the arena, not node by node
+    if(map == NULL || map->arena != NULL) {
         return;
     }
+    mapClear(map);
     free(map);
 }
 Map mapCopy(Map map)
@@ -100,6 +154,8 @@ Map mapCopy(Map map)
         tail = copied_new;
         original_head = original_head->next;
     }
+    copied_map->last = tail;
+    copied_map->size = map->size;
     return copied_map;
 }
 int mapGetSize(Map map)
@@ -107,20 +163,17 @@ int mapGetSize(Map map)
     if(map == NULL) {
         return -1;
     }
-    int count = 0;
-    MapNode helper = map->head;
-    while (helper != NULL)
-    {
-        count++;
-        helper = helper->next;
-    }
-    return count;
+    return map->size;
 }
 bool mapContains(Map map, MapKeyElement element)
 {
     if(map == NULL || element == NULL) {
         return false;
     }
+    int compare_last = compareWithLast(map, element);
+    if(compare_last <= EQUAL) {
+        return compare_last == EQUAL;
+    }
     MapNode check = map->head;
     while(check != NULL)
     {
@@ -136,6 +189,10 @@ MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement)
     if(map == NULL || keyElement == NULL || dataElement == NULL) {
         return MAP_NULL_ARGUMENT;
     }
+    // a key that is greater than the last key is new, so sorted puts skip the search
+    if(compareWithLast(map, keyElement) < EQUAL) {
+        return addNewKey(map, keyElement, dataElement);
+    }
     if(mapContains(map, keyElement) == false)
     {
         if(addNewKey(map, keyElement, dataElement) == MAP_OUT_OF_MEMORY) {
@@ -155,6 +212,10 @@ MapDataElement mapGet(Map map, MapKeyElement keyElement)
     if(map == NULL || keyElement == NULL) {
         return NULL;
     }
+    int compare_last = compareWithLast(map, keyElement);
+    if(compare_last <= EQUAL) {
+        return compare_last == EQUAL ? map->last->DataElement : NULL;
+    }
     MapNode check = map->head;
     while(check != NULL)
     {
@@ -178,7 +239,11 @@ MapResult mapRemove(Map map, MapKeyElement keyElement)
     {
         MapNode helper = map->head;
         map->head = map->head->next;
+        if(map->last == helper) {
+            map->last = NULL;
+        }
         freeMapNode(map, helper);
+        map->size--;
         return MAP_SUCCESS;
 
     }
@@ -189,7 +254,11 @@ MapResult mapRemove(Map map, MapKeyElement keyElement)
         if(map->MapFunc.CompareKeyElement(current->keyElement, keyElement) == EQUAL)
         {
             tail->next = current->next;
+            if(map->last == current) {
+                map->last = tail;
+            }
             freeMapNode(map, current);
+            map->size--;
             return MAP_SUCCESS;
         }
         current = current->next;
@@ -231,7 +300,44 @@ MapResult mapClear(Map map)
         freeMapNode(map, to_delete);
     }
     map->head = NULL;
+    map->last = NULL;
     map->iterator = NULL;
+    map->size = 0;
+    return MAP_SUCCESS;
+}
+MapResult mapApply(Map map, applyMapElement apply, void* context)
+{
+    if(map == NULL || apply == NULL) {
+        return MAP_NULL_ARGUMENT;
+    }
+    for(MapNode node = map->head; node != NULL; node = node->next)
+    {
+        apply(node->keyElement, node->DataElement, context);
+    }
+    return MAP_SUCCESS;
+}
+MapResult mapMergeApply(Map first, Map second, mergeMapElements merge, void* context)
+{
+    if(first == NULL || second == NULL || merge == NULL) {
+        return MAP_NULL_ARGUMENT;
+    }
+    MapNode first_node = first->head;
+    MapNode second_node = second->head;
+    while(first_node != NULL && second_node != NULL)
+    {
+        int compare = first->MapFunc.CompareKeyElement(first_node->keyElement, second_node->keyElement);
+        if(compare < EQUAL) {
+            first_node = first_node->next;
+            continue;
+        }
+        if(compare > EQUAL) {
+            second_node = second_node->next;
+            continue;
+        }
+        merge(first_node->keyElement, first_node->DataElement, second_node->DataElement, context);
+        first_node = first_node->next;
+        second_node = second_node->next;
+    }
     return MAP_SUCCESS;
 }
 // static function:
@@ -240,19 +346,19 @@ MapResult mapClear(Map map)
 static MapResult addNewKey(Map map, MapKeyElement keyElement, MapDataElement dataElement)
 {
     assert(map != NULL && keyElement != NULL && dataElement != NULL);
-    MapNode new = (MapNode)malloc(sizeof(*new));
+    MapNode new = allocateMapNode(map, keyElement, dataElement);
     if(new == NULL) {
         return MAP_OUT_OF_MEMORY;
     }
-    new->DataElement = map->MapFunc.CopyDataElement(dataElement);
-    new->keyElement = map->MapFunc.CopyKeyElement(keyElement);
-    new->next = NULL;
-    if(new->DataElement == NULL || new->keyElement == NULL){
-        freeMapNode(map, new);
-        return MAP_OUT_OF_MEMORY;
-    }
+    map->size++;
     if(map->head == NULL){
         map->head = new;
+        map->last = new;
+        return MAP_SUCCESS;
+    }
+    if (map->MapFunc.CompareKeyElement(map->last->keyElement, keyElement) < 0) {
+        map->last->next = new;
+        map->last = new;
         return MAP_SUCCESS;
     }
     if (map->MapFunc.CompareKeyElement(map->head->keyElement, keyElement) > 0) {
@@ -273,7 +379,7 @@ static MapResult addNewKey(Map map, MapKeyElement keyElement, MapDataElement dat
         helper = helper->next;
         tail = tail->next;
     }
-    tail->next = new;
+    assert(helper != NULL); //not get here, a key that is greater than the last one is appended above
     return MAP_SUCCESS;
 }
 static MapResult updateMapKey(Map map, MapKeyElement keyElement, MapDataElement dataElement)
@@ -284,6 +390,10 @@ static MapResult updateMapKey(Map map, MapKeyElement keyElement, MapDataElement
     {
         if(map->MapFunc.CompareKeyElement(check->keyElement, keyElement) == EQUAL)
         {
+            if(map->arena != NULL) {
+                memcpy(check->DataElement, dataElement, map->data_size);
+                return MAP_SUCCESS;
+            }
             MapKeyElement temp = map->MapFunc.CopyDataElement(dataElement);
             if(temp == NULL){
                 return MAP_OUT_OF_MEMORY;
@@ -298,6 +408,14 @@ static MapResult updateMapKey(Map map, MapKeyElement keyElement, MapDataElement
     return MAP_SUCCESS;
 
 }
+static int compareWithLast(Map map, MapKeyElement keyElement)
+{
+    assert(map != NULL && keyElement != NULL);
+    if(map->last == NULL) {
+        return 1;
+    }
+    return map->MapFunc.CompareKeyElement(map->last->keyElement, keyElement);
+}
 static bool checkAllocationFailed(Map copied_map, MapNode new)
 {
     if(new == NULL){
@@ -313,8 +431,48 @@ static void updateMapNode(Map map, MapNode new, MapNode original)
     new->DataElement = map->MapFunc.CopyDataElement(original->DataElement);
     new->next = NULL;
 }
+static MapNode allocateMapNode(Map map, MapKeyElement keyElement, MapDataElement dataElement)
+{
+    if(map->arena != NULL) {
+        size_t key_offset = arenaAlignSize(sizeof(struct node_t));
+        size_t data_offset = key_offset + arenaAlignSize(map->key_size);
+        MapNode new = map->free_nodes;
+        if(new != NULL) {
+            map->free_nodes = new->next;
+        }
+        else {
+            new = arenaAlloc(map->arena, data_offset + map->data_size);
+            if(new == NULL) {
+                return NULL;
+            }
+        }
+        new->keyElement = (char*)new + key_offset;
+        new->DataElement = (char*)new + data_offset;
+        memcpy(new->keyElement, keyElement, map->key_size);
+        memcpy(new->DataElement, dataElement, map->data_size);
+        new->next = NULL;
+        return new;
+    }
+    MapNode new = (MapNode)malloc(sizeof(*new));
+    if(new == NULL) {
+        return NULL;
+    }
+    new->DataElement = map->MapFunc.CopyDataElement(dataElement);
+    new->keyElement = map->MapFunc.CopyKeyElement(keyElement);
+    new->next = NULL;
+    if(new->DataElement == NULL || new->keyElement == NULL){
+        freeMapNode(map, new);
+        return NULL;
+    }
+    return new;
+}
 static void freeMapNode(Map map, MapNode to_delete)
 {
+    if(map->arena != NULL) {
+        to_delete->next = map->free_nodes;
+        map->free_nodes = to_delete;
+        return;
+    }
     if(to_delete->DataElement != NULL) {
         map->MapFunc.FreeMapDataElement(to_delete->DataElement);
     }
@@ -0,0 +1,68 @@
+#ifndef MAP_EXTENDED_H
+#define MAP_EXTENDED_H
+
+#include "map.h"
+#include "arena.h"
+
+/** Type of function that is called for every key that appears in both merged maps */
+typedef void(*mergeMapElements)(MapKeyElement, MapDataElement, MapDataElement, void*);
+
+/** Type of function that is called for every element of a map */
+typedef void(*applyMapElement)(MapKeyElement, MapDataElement, void*);
+
+/**
+* mapCreateInArena: creates an empty map that allocates its nodes, keys and data from an arena.
+* the keys and the data are flat elements of a fixed size that are copied into the map by value,
+* so the copy and free functions are used only for the keys that mapGetFirst and mapGetNext return
+* (and by mapCopy, that returns a map that is not in the arena).
+* a removed element is reused by the next put, and mapDestroy does nothing: all the memory of the map
+* is freed with the arena.
+*
+* @param copyDataElement, copyKeyElement, freeDataElement, freeKeyElement, compareKeyElements -
+*        the functions of the elements, as in mapCreate.
+* @param key_size - the size of a key.
+* @param data_size - the size of a data element.
+* @param arena - the arena to allocate from. it must live longer than the map.
+* @return
+* 	NULL - a NULL argument was sent or allocation failed.
+* 	a new map - otherwise.
+*/
+Map mapCreateInArena(copyMapDataElements copyDataElement,
+                     copyMapKeyElements copyKeyElement,
+                     freeMapDataElements freeDataElement,
+                     freeMapKeyElements freeKeyElement,
+                     compareMapKeyElements compareKeyElements,
+                     size_t key_size, size_t data_size, Arena arena);
+
+/**
+* mapApply: calls the apply function for every element of the map, in the order of the keys.
+* unlike MAP_FOREACH with mapGet, the walk costs O(n) and does not copy the keys.
+* the apply function may change the data elements, but must not add or remove keys.
+*
+* @param map - the map to walk.
+* @param apply - the function that is called with the key, the data and the context.
+* @param context - a pointer that is passed as is to the apply function.
+* @return
+* 	MAP_NULL_ARGUMENT - a NULL map or function was sent.
+* 	MAP_SUCCESS - otherwise.
+*/
+MapResult mapApply(Map map, applyMapElement apply, void* context);
+
+/**
+* mapMergeApply: walks two maps that are sorted by the same key order together, and calls
+* the merge function for every key that appears in both of them.
+* the walk costs O(n + m) compares, instead of a mapGet per key.
+* the merge function may change the data elements, but must not add or remove keys.
+*
+* @param first - the first map. its compare function is used for both maps.
+* @param second - the second map.
+* @param merge - the function that is called with the key, the data of the first map,
+*                the data of the second map and the context.
+* @param context - a pointer that is passed as is to the merge function.
+* @return
+* 	MAP_NULL_ARGUMENT - a NULL map or function was sent.
+* 	MAP_SUCCESS - otherwise.
+*/
+MapResult mapMergeApply(Map first, Map second, mergeMapElements merge, void* context);
+
+#endif //MAP_EXTENDED_H
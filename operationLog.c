@@ -0,0 +1,390 @@
+#define _POSIX_C_SOURCE 200809L
+#include "operationLog.h"
+#include "binaryFile.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define LOG_COMMIT_INTERVAL_NS 2000000L
+#define LOG_COMMIT_BYTES (1 << 16)
+#define LOG_INITIAL_CAPACITY (1 << 12)
+#define NANOSECONDS_IN_SECOND 1000000000L
+#define LOG_FILE_MODE 0644
+#define INT_SIZE 4
+#define RECORD_HEADER_SIZE (2 * INT_SIZE)
+#define RECORD_FIXED_SIZE (3 * INT_SIZE)
+#define BITS_IN_BYTE 8
+#define BYTE_MASK 0xff
+#define NO_LOCATION 0
+
+// the records are added to the pending buffer, and the commit thread swaps it with the committing
+// buffer, writes it and syncs the file, so the callers only wait for the lock and a copy
+struct operation_log_t
+{
+    int file;
+    pthread_t committer;
+    pthread_mutex_t lock;
+    pthread_cond_t records_added;
+    pthread_cond_t records_committed;
+    unsigned char* pending;
+    size_t pending_length;
+    size_t pending_capacity;
+    unsigned char* committing;
+    size_t committing_capacity;
+    unsigned long long appended;
+    unsigned long long committed;
+    bool sync_requested;
+    bool shutdown;
+    bool failed;
+};
+
+/* the loop of the commit thread */
+static void* operationLogCommitter(void* operation_log);
+
+/* write the whole buffer to the file and sync it. false if failed */
+static bool operationLogWriteAll(int file, const unsigned char* buffer, size_t length);
+
+/* wait for more records to join the group, until the interval passes or the group is large enough.
+ * called with the lock held */
+static void operationLogWaitForGroup(OperationLog log);
+
+/* the number of bytes of the encoded record */
+static size_t operationLogRecordSize(const LogRecord* record);
+
+/* encode the record into the buffer, that has operationLogRecordSize bytes */
+static void operationLogEncode(const LogRecord* record, unsigned char* buffer);
+
+/* walk the complete records of the content, and call the replay function (if not NULL) for each of them.
+ * return the length of the part of the content that holds complete records */
+static size_t operationLogParse(const unsigned char* content, size_t length, LogReplayFunction replay,
+                                void* context, int* num_of_records);
+
+/* FNV-1a checksum of a record */
+static uint32_t operationLogChecksum(const unsigned char* bytes, size_t length);
+
+/* encode / decode a 4 bytes value, little endian */
+static void operationLogPutInt(unsigned char* bytes, uint32_t value);
+static uint32_t operationLogGetInt(const unsigned char* bytes);
+
+/* read the whole content of a file. an empty content for a file that does not exist */
+static OperationLogResult operationLogReadFile(const char* path, unsigned char** content, size_t* length);
+
+OperationLog operationLogOpen(const char* path)
+{
+    if(path == NULL) {
+        return NULL;
+    }
+    unsigned char* content = NULL;
+    size_t length = 0;
+    if(operationLogReadFile(path, &content, &length) != LOG_SUCCESS) {
+        return NULL;
+    }
+    size_t valid_length = operationLogParse(content, length, NULL, NULL, NULL);
+    free(content);
+    OperationLog log = malloc(sizeof(*log));
+    if(log == NULL) {
+        return NULL;
+    }
+    log->pending = malloc(LOG_INITIAL_CAPACITY);
+    log->committing = malloc(LOG_INITIAL_CAPACITY);
+    log->file = open(path, O_WRONLY | O_CREAT | O_APPEND, LOG_FILE_MODE);
+    if(log->pending == NULL || log->committing == NULL || log->file < 0 ||
+       (valid_length < length && ftruncate(log->file, (off_t)valid_length) != 0)) {
+        if(log->file >= 0) {
+            close(log->file);
+        }
+        free(log->pending);
+        free(log->committing);
+        free(log);
+        return NULL;
+    }
+    log->pending_length = 0;
+    log->pending_capacity = LOG_INITIAL_CAPACITY;
+    log->committing_capacity = LOG_INITIAL_CAPACITY;
+    log->appended = 0;
+    log->committed = 0;
+    log->sync_requested = false;
+    log->shutdown = false;
+    log->failed = false;
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->records_added, NULL);
+    pthread_cond_init(&log->records_committed, NULL);
+    if(pthread_create(&log->committer, NULL, operationLogCommitter, log) != 0) {
+        pthread_cond_destroy(&log->records_committed);
+        pthread_cond_destroy(&log->records_added);
+        pthread_mutex_destroy(&log->lock);
+        close(log->file);
+        free(log->pending);
+        free(log->committing);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+OperationLogResult operationLogClose(OperationLog log)
+{
+    if(log == NULL) {
+        return LOG_SUCCESS;
+    }
+    pthread_mutex_lock(&log->lock);
+    log->shutdown = true;
+    pthread_cond_signal(&log->records_added);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->committer, NULL);
+    bool failed = log->failed;
+    if(close(log->file) != 0) {
+        failed = true;
+    }
+    pthread_cond_destroy(&log->records_committed);
+    pthread_cond_destroy(&log->records_added);
+    pthread_mutex_destroy(&log->lock);
+    free(log->pending);
+    free(log->committing);
+    free(log);
+    return failed ? LOG_FILE_ERROR : LOG_SUCCESS;
+}
+
+OperationLogResult operationLogAppend(OperationLog log, const LogRecord* record)
+{
+    assert(log != NULL && record != NULL && record->num_of_values <= LOG_MAX_VALUES);
+    size_t size = operationLogRecordSize(record);
+    pthread_mutex_lock(&log->lock);
+    if(log->pending_length + size > log->pending_capacity) {
+        size_t capacity = log->pending_capacity;
+        while(log->pending_length + size > capacity) {
+            capacity *= 2;
+        }
+        unsigned char* pending = realloc(log->pending, capacity);
+        if(pending == NULL) {
+            log->failed = true;
+            pthread_mutex_unlock(&log->lock);
+            return LOG_OUT_OF_MEMORY;
+        }
+        log->pending = pending;
+        log->pending_capacity = capacity;
+    }
+    operationLogEncode(record, log->pending + log->pending_length);
+    bool was_empty = log->pending_length == 0;
+    log->pending_length += size;
+    log->appended++;
+    if(was_empty || log->pending_length >= LOG_COMMIT_BYTES) {
+        pthread_cond_signal(&log->records_added);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return LOG_SUCCESS;
+}
+
+OperationLogResult operationLogSync(OperationLog log)
+{
+    assert(log != NULL);
+    pthread_mutex_lock(&log->lock);
+    unsigned long long target = log->appended;
+    if(log->committed < target) {
+        log->sync_requested = true;
+        pthread_cond_signal(&log->records_added);
+    }
+    while(log->committed < target) {
+        pthread_cond_wait(&log->records_committed, &log->lock);
+    }
+    bool failed = log->failed;
+    pthread_mutex_unlock(&log->lock);
+    return failed ? LOG_FILE_ERROR : LOG_SUCCESS;
+}
+
+OperationLogResult operationLogReplay(const char* path, LogReplayFunction replay, void* context,
+                                      int* num_of_records)
+{
+    if(path == NULL || replay == NULL || num_of_records == NULL) {
+        return LOG_FILE_ERROR;
+    }
+    unsigned char* content = NULL;
+    size_t length = 0;
+    OperationLogResult result = operationLogReadFile(path, &content, &length);
+    if(result != LOG_SUCCESS) {
+        return result;
+    }
+    *num_of_records = 0;
+    operationLogParse(content, length, replay, context, num_of_records);
+    free(content);
+    return LOG_SUCCESS;
+}
+
+static void* operationLogCommitter(void* operation_log)
+{
+    OperationLog log = operation_log;
+    pthread_mutex_lock(&log->lock);
+    while(true)
+    {
+        while(log->shutdown == false && log->pending_length == 0) {
+            pthread_cond_wait(&log->records_added, &log->lock);
+        }
+        if(log->pending_length == 0) {
+            break;
+        }
+        operationLogWaitForGroup(log);
+        unsigned char* group = log->pending;
+        size_t group_length = log->pending_length;
+        size_t group_capacity = log->pending_capacity;
+        unsigned long long group_end = log->appended;
+        log->pending = log->committing;
+        log->pending_capacity = log->committing_capacity;
+        log->pending_length = 0;
+        log->sync_requested = false;
+        pthread_mutex_unlock(&log->lock);
+        bool written = operationLogWriteAll(log->file, group, group_length);
+        pthread_mutex_lock(&log->lock);
+        if(written == false) {
+            log->failed = true;
+        }
+        log->committing = group;
+        log->committing_capacity = group_capacity;
+        log->committed = group_end;
+        pthread_cond_broadcast(&log->records_committed);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+static void operationLogWaitForGroup(OperationLog log)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += LOG_COMMIT_INTERVAL_NS;
+    if(deadline.tv_nsec >= NANOSECONDS_IN_SECOND) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= NANOSECONDS_IN_SECOND;
+    }
+    while(log->shutdown == false && log->sync_requested == false && log->pending_length < LOG_COMMIT_BYTES) {
+        if(pthread_cond_timedwait(&log->records_added, &log->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+}
+
+static bool operationLogWriteAll(int file, const unsigned char* buffer, size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t written = write(file, buffer, length);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+    return fsync(file) == 0;
+}
+
+static size_t operationLogRecordSize(const LogRecord* record)
+{
+    size_t size = RECORD_HEADER_SIZE + RECORD_FIXED_SIZE + record->num_of_values * INT_SIZE;
+    if(record->location != NULL) {
+        size += strlen(record->location) + 1;
+    }
+    return size;
+}
+
+static void operationLogEncode(const LogRecord* record, unsigned char* buffer)
+{
+    unsigned char* payload = buffer + RECORD_HEADER_SIZE;
+    unsigned char* next = payload;
+    operationLogPutInt(next, record->operation);
+    next += INT_SIZE;
+    operationLogPutInt(next, record->num_of_values);
+    next += INT_SIZE;
+    for(int i = 0; i < record->num_of_values; i++) {
+        operationLogPutInt(next, (uint32_t)record->values[i]);
+        next += INT_SIZE;
+    }
+    size_t location_length = record->location == NULL ? NO_LOCATION : strlen(record->location) + 1;
+    operationLogPutInt(next, (uint32_t)location_length);
+    next += INT_SIZE;
+    memcpy(next, record->location == NULL ? "" : record->location, location_length);
+    next += location_length;
+    size_t payload_length = next - payload;
+    operationLogPutInt(buffer, (uint32_t)payload_length);
+    operationLogPutInt(buffer + INT_SIZE, operationLogChecksum(payload, payload_length));
+}
+
+static size_t operationLogParse(const unsigned char* content, size_t length, LogReplayFunction replay,
+                                void* context, int* num_of_records)
+{
+    size_t position = 0;
+    while(length - position >= RECORD_HEADER_SIZE + RECORD_FIXED_SIZE)
+    {
+        size_t payload_length = operationLogGetInt(content + position);
+        const unsigned char* payload = content + position + RECORD_HEADER_SIZE;
+        if(payload_length < RECORD_FIXED_SIZE || payload_length > length - position - RECORD_HEADER_SIZE ||
+           operationLogChecksum(payload, payload_length) != operationLogGetInt(content + position + INT_SIZE)) {
+            break;
+        }
+        uint32_t operation = operationLogGetInt(payload);
+        uint32_t num_of_values = operationLogGetInt(payload + INT_SIZE);
+        if(num_of_values > LOG_MAX_VALUES || operation > LOG_REMOVE_PLAYER ||
+           RECORD_FIXED_SIZE + num_of_values * INT_SIZE > payload_length) {
+            break;
+        }
+        LogRecord record;
+        record.operation = (LogOperation)operation;
+        record.num_of_values = (int)num_of_values;
+        const unsigned char* next = payload + 2 * INT_SIZE;
+        for(int i = 0; i < record.num_of_values; i++) {
+            record.values[i] = (int)operationLogGetInt(next);
+            next += INT_SIZE;
+        }
+        size_t location_length = operationLogGetInt(next);
+        next += INT_SIZE;
+        if(location_length != (size_t)(payload + payload_length - next) ||
+           (location_length != NO_LOCATION && next[location_length - 1] != '\0')) {
+            break;
+        }
+        record.location = location_length == NO_LOCATION ? NULL : (const char*)next;
+        if(replay != NULL) {
+            replay(&record, context);
+            (*num_of_records)++;
+        }
+        position += RECORD_HEADER_SIZE + payload_length;
+    }
+    return position;
+}
+
+static uint32_t operationLogChecksum(const unsigned char* bytes, size_t length)
+{
+    return (uint32_t)binaryFileChecksum(FNV_32_OFFSET_BASIS, FNV_32_PRIME, bytes, length);
+}
+
+static void operationLogPutInt(unsigned char* bytes, uint32_t value)
+{
+    for(int i = 0; i < INT_SIZE; i++) {
+        bytes[i] = (unsigned char)((value >> (i * BITS_IN_BYTE)) & BYTE_MASK);
+    }
+}
+
+static uint32_t operationLogGetInt(const unsigned char* bytes)
+{
+    uint32_t value = 0;
+    for(int i = 0; i < INT_SIZE; i++) {
+        value |= (uint32_t)bytes[i] << (i * BITS_IN_BYTE);
+    }
+    return value;
+}
+
+static OperationLogResult operationLogReadFile(const char* path, unsigned char** content, size_t* length)
+{
+    BinaryFileResult result = binaryFileRead(path, content, length);
+    if(result == BINARY_FILE_OUT_OF_MEMORY) {
+        return LOG_OUT_OF_MEMORY;
+    }
+    return result == BINARY_FILE_SUCCESS || result == BINARY_FILE_NOT_FOUND ? LOG_SUCCESS : LOG_FILE_ERROR;
+}
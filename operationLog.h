@@ -0,0 +1,101 @@
+#ifndef OPERATION_LOG_H
+#define OPERATION_LOG_H
+
+#include <stdbool.h>
+
+typedef struct operation_log_t *OperationLog;
+
+/** Type used for returning error codes from operation log functions */
+typedef enum OperationLogResult_t {
+    LOG_SUCCESS,
+    LOG_OUT_OF_MEMORY,
+    LOG_FILE_ERROR
+} OperationLogResult;
+
+/** The mutating operations that are recorded in the log */
+typedef enum LogOperation_t {
+    LOG_ADD_TOURNAMENT,
+    LOG_ADD_GAME,
+    LOG_END_TOURNAMENT,
+    LOG_REMOVE_TOURNAMENT,
+    LOG_REMOVE_PLAYER
+} LogOperation;
+
+#define LOG_MAX_VALUES 5
+
+/** A record of one operation: its integer arguments in the order of the call, and the location
+ * of an added tournament (NULL for the other operations) */
+typedef struct LogRecord_t {
+    LogOperation operation;
+    int num_of_values;
+    int values[LOG_MAX_VALUES];
+    const char* location;
+} LogRecord;
+
+/** Type of function that replays a record, with the context that was passed to operationLogReplay */
+typedef void (*LogReplayFunction)(const LogRecord* record, void* context);
+
+/**
+* operationLogOpen: open a log file for appending, and start the thread that commits it.
+* a torn record at the end of the file (of a crash during a write) is cut off first,
+* so the new records follow the last complete one.
+*
+* @param path - the path of the log file, created if it does not exist.
+* @return
+* 	NULL - a NULL path was sent, the file could not be opened or allocation failed.
+* 	pointer to the log - otherwise.
+*/
+OperationLog operationLogOpen(const char* path);
+
+/**
+* operationLogClose: commit the records that were appended, stop the commit thread
+* and deallocate the log.
+*
+* @param log - the log to close.
+* @return
+* 	LOG_FILE_ERROR - a write or a sync of the log has failed.
+* 	LOG_SUCCESS - otherwise, or for a NULL log.
+*/
+OperationLogResult operationLogClose(OperationLog log);
+
+/**
+* operationLogAppend: add a record to the log. the record is only copied to memory; the commit thread
+* writes the records that were added together and syncs the file once for all of them (group commit),
+* so the caller never waits for the disk. may be called from several threads at once.
+*
+* @param log - the log.
+* @param record - the record to add.
+* @return
+* 	LOG_OUT_OF_MEMORY - allocation failed, the record is lost and the log is failed.
+* 	LOG_SUCCESS - otherwise.
+*/
+OperationLogResult operationLogAppend(OperationLog log, const LogRecord* record);
+
+/**
+* operationLogSync: wait until all the records that were added before the call are written and synced.
+*
+* @param log - the log.
+* @return
+* 	LOG_OUT_OF_MEMORY / LOG_FILE_ERROR - a record was lost, or a write or a sync has failed.
+* 	LOG_SUCCESS - otherwise.
+*/
+OperationLogResult operationLogSync(OperationLog log);
+
+/**
+* operationLogReplay: call the replay function for every complete record of a log file, in order.
+* the replay stops at the first record that is torn or corrupted, which can only be the tail
+* of a crash.
+*
+* @param path - the path of the log file.
+* @param replay - the function to call.
+* @param context - a pointer that is passed as is to the replay function.
+* @param num_of_records - a pointer where to put the number of records that were replayed.
+* @return
+* 	LOG_FILE_ERROR - a NULL argument was sent or the file could not be read.
+* 	LOG_OUT_OF_MEMORY - allocation failed.
+* 	LOG_SUCCESS - otherwise.
+*/
+OperationLogResult operationLogReplay(const char* path, LogReplayFunction replay, void* context,
+                                      int* num_of_records);
+
+#endif //OPERATION_LOG_H
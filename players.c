@@ -2,9 +2,14 @@
 // Created by aribr on 07/05/2021.
 //
 #include "players.h"
+#include "mapExtended.h"
 #include <stdlib.h>
+#include <string.h>
 #include "assert.h"
 #include "stdbool.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #define WIN_COEFFICIENT 6
 #define LOSS_COEFFICIENT 10
@@ -16,18 +21,103 @@
 #define SECOND_IS_GREATER (-1)
 #define NO_GAMES 0
 #define EQUAL 0
-#define PRINTED 1
-#define UNPRINTED 0
 #define ADD 1
+#define PLAYER_TABLE_COLUMNS 5
+#define LEVEL_LINE_SIZE 32
+#define NO_PARENT 0
+#define PLAYER_RECORD_SIZE (PLAYER_TABLE_COLUMNS * 4)
+#define REMOVALS_INITIAL_CAPACITY 16
+#define REMOVALS_GROWTH_FACTOR 2
 
 struct player_t{
     int winning;
     int loss;
     int draw;
     int num_of_games;
-    bool status;
+    bool changed;
+    // the calls that have reserved the player for a game that is not committed yet, and whether the
+    // player was added by such a reservation and has not played a committed game since
+    int reservations;
+    bool reserved_new;
 };
 
+// the ids of the players that were removed from a players map since the last delta export
+struct player_removals_t{
+    int size;
+    int capacity;
+    int *ids;
+};
+
+// structure-of-arrays copy of a players map. all the columns live in the same allocation
+// as the struct itself, the level column first so it is aligned for the vector loads.
+struct player_table_t{
+    int size;
+    int capacity;
+    double *level;
+    int *id;
+    int *winning;
+    int *loss;
+    int *draw;
+    int *num_of_games;
+};
+
+typedef struct player_rank_t{
+    double level;
+    int id;
+}PlayerRank;
+
+// a position in a players table, for walking it together with a players map
+typedef struct table_cursor_t{
+    PlayerTable table;
+    int position;
+}TableCursor;
+
+// the best player so far while the players of a tournament are walked for its winner
+typedef struct player_winner_t{
+    int id;
+    PlayerData data;
+}PlayerWinner;
+
+// the function of playersForEach and its context, for walking the map with mapApply
+typedef struct player_visit_t{
+    PlayerStatsFunction function;
+    void *context;
+}PlayerVisit;
+
+// a line of a delta export of the levels: a player that has played, with its level and rank, or a removed one
+typedef struct level_change_t{
+    int id;
+    bool removed;
+    double level;
+    int rank;
+}LevelChange;
+
+// the state of a delta export while the players map is walked: the ranks of all the players that have played,
+// the lines in the order of the ids, the changed players (to unmark them after the export),
+// and the removed ids (sorted) that were not reached yet
+typedef struct level_delta_t{
+    PlayerRank *ranks;
+    int num_of_ranks;
+    LevelChange *changes;
+    int num_of_changes;
+    PlayerData *changed;
+    int num_of_changed;
+    const int *removed;
+    int num_of_removed;
+    int next_removed;
+}LevelDelta;
+
+// the shared state of a parallel levels export. part i holds ranks [part_start[i], part_start[i + 1])
+typedef struct level_export_t{
+    PlayerRank *ranks;
+    PlayerRank *merged;
+    int num_of_parts;
+    int *part_start;
+    char **buffers;
+    size_t *lengths;
+    bool *failed;
+}LevelExport;
+
 
 
 // Updates multiple wins or losses or  draws at once
@@ -55,14 +145,10 @@ static int playerComparePoints(PlayerData player1 , PlayerData player2);
 //function for coping a player data
 // returns NULL if allocation error , the playerData copy otherwise
 static MapDataElement copyPlayerData(MapDataElement player_data);
+// releases one reservation of a player, see playersRelease
+static void releasePlayer(Map players , int player_id , bool committed);
 
 
-//function for getting the first UNPRINTED player
-//returns PLAYER_NO_PLAYERS_TO_PRINT if no more players
-// to print or the first player to compare otherwise
-
-static int playerGetFirstToCompare(Map players , PlayerNodeResult *result);
-
 // function for deallocating data while adding new players
 
 static void deallocateData(Map players , PlayerData first_player_data ,
@@ -70,10 +156,99 @@ static void deallocateData(Map players , PlayerData first_player_data ,
                            int second_player , bool const *first_player_was_allocated ,
                            bool const *second_player_was_allocated);
 
+// points the columns of the table to their place in the allocation of the table
+
+static void playerTableSetColumns(PlayerTable table , int capacity);
+
+// Calculates the levels of all the players of the table, a vector of players at a time
+// (SSE2, that every x86-64 build targets, and a scalar loop for the rest and for other targets)
+
+static void playerTableComputeLevels(PlayerTable table);
+
+//compares between 2 ranks: the higher level first, and the lower id first on equal levels
+
+static int playerRankCompare(const void *rank1 , const void *rank2);
+
+// copies the ranks of the players that have played to ranks, and returns their number
+
+static int playerTableCollectRanks(PlayerTable table , PlayerRank *ranks);
+
+// returns the position of a player in a table by a binary search of the ids, EMPTY if it is not in the table
+
+static int playerTableFind(PlayerTable table , int player_id);
+
+// parallel export tasks: sort a part of the ranks / format a part of the merged ranks into its buffer
+
+static void levelExportSortPart(int part , void *level_export);
+static void levelExportFormatPart(int part , void *level_export);
+
+// k-way merge of the sorted parts of the ranks into merged
+
+static void levelExportMergeParts(LevelExport *level_export);
+
+// apply function for playerTableRemoveData: removes the results of the player from the external
+// player, if the player is the next one of the table (the context is a TableCursor)
+
+static void removeTableData(MapKeyElement player_id , MapDataElement external_data , void *table_cursor);
+
+// apply function for playerTableCreate: copies the results of the player into the next row of the
+// table (the context is a TableCursor)
+
+static void fillTableRow(MapKeyElement player_id , MapDataElement player_data , void *table_cursor);
+
+// apply function for playerGetTournamentWinnerID: keeps the player if it has more points than the
+// best one so far (the context is a PlayerWinner)
+
+static void compareWinner(MapKeyElement player_id , MapDataElement player_data , void *player_winner);
+
+// deallocates the buffers of a parallel export
+
+static void levelExportFree(LevelExport *level_export);
+
+// apply function for playersSave: writes the record of a player (the context is the writer)
+
+static void savePlayerRecord(MapKeyElement player_id , MapDataElement player_data , void *writer);
+
+// apply function for playersForEach: calls the function of the visit (the context) with the player's results
 
-Map playersCreateMap(){
-    Map players = mapCreate(copyPlayerData , copyIntKey , destroyNode ,
+static void visitPlayer(MapKeyElement player_id , MapDataElement player_data , void *visit);
+
+// apply function for playerPrintLevelsDelta: adds the player to the ranks, and to the lines if it changed,
+// after the removed players before it (the context is a LevelDelta)
+
+static void collectLevelDelta(MapKeyElement player_id , MapDataElement player_data , void *level_delta);
+
+// adds a line for every removed id up to the given one (all of them if all is true), once per id.
+// an id that is still in the map is skipped, its line is by its state in the map
+
+static void collectRemovedPlayers(LevelDelta *level_delta , int player_id , bool all);
+
+// finds the ranks of the changed players: the number of players before each of them, with a binary search
+// of every player among the changed players (sorted by rank) and a prefix sum
+
+static void levelDeltaRank(LevelDelta *level_delta , PlayerRank *targets , int *counts);
+
+// compare functions for qsort and bsearch: ints, and the lines of a delta export by id
+
+static int intCompare(const void *int1 , const void *int2);
+static int levelChangeCompare(const void *change1 , const void *change2);
+
+// merge function for playerRemoveData: removes the internal player's results from the external player
+
+static void removeInternalData(MapKeyElement player_id , MapDataElement external_data ,
+                               MapDataElement internal_data , void *context);
+
+
+Map playersCreateMap(Arena arena){
+    Map players = NULL;
+    if(arena != NULL){
+        players = mapCreateInArena(copyPlayerData , copyIntKey , destroyNode , destroyIntKey , intKeyCompare ,
+                                   sizeof(int) , sizeof(struct player_t) , arena);
+    }
+    else{
+        players = mapCreate(copyPlayerData , copyIntKey , destroyNode ,
                             destroyIntKey , intKeyCompare);
+    }
     if(players == NULL){
         return NULL;
     }
@@ -102,7 +277,9 @@ PlayerData playerCreatNode(){
     new_player_data->loss = NULL_ARGUMENT;
     new_player_data->draw = NULL_ARGUMENT;
     new_player_data->num_of_games = NULL_ARGUMENT;
-    new_player_data->status = NULL_ARGUMENT;
+    new_player_data->changed = false;
+    new_player_data->reservations = 0;
+    new_player_data->reserved_new = false;
     return new_player_data;
 }
 
@@ -158,20 +335,12 @@ int playerGetTournamentWinnerID(Map players){
     if(players == NULL){
         return EMPTY;
     }
-    MapKeyElement tournament_winner = mapGetFirst(players);
-    if(tournament_winner == NULL){
+    if(mapGetSize(players) == 0){
         return NULL_ARGUMENT;
     }
-    MAP_FOREACH(int*, iterator,players){
-        PlayerFlag compare_type = PLAYER_POINTS_COMPARE;
-        if(playerCompare(players , tournament_winner , iterator , &compare_type) < EQUAL){
-            *(int*) tournament_winner = *(int*) iterator;
-        }
-        destroyIntKey(iterator);
-    }
-    int temp = *(int*)tournament_winner;
-    destroyIntKey(tournament_winner);
-    return temp;
+    PlayerWinner winner = {EMPTY , NULL};
+    mapApply(players , compareWinner , &winner);
+    return winner.id;
 }
 
 int playerGetNumOfGames(Map players, MapKeyElement player_id){
@@ -197,76 +366,11 @@ PlayerNodeResult playerUpdateData(Map players, MapKeyElement player_id,
     return PLAYER_SUCCESS;
 }
 
-int playerGetPlayerByLevels(Map players, double *level , PlayerNodeResult *result){
-    assert(level != NULL && result != NULL);
-    if(players == NULL){
-        *result = PLAYER_NULL_ARGUMENT;
-        return EMPTY;
-    }
-    PlayerNodeResult result1 = PLAYER_SUCCESS;
-    int highest_level_player = playerGetFirstToCompare(players , &result1);
-    if(result1 != PLAYER_SUCCESS){
-        assert(highest_level_player == EMPTY);
-        *result = result1;
-        return EMPTY;
-    }
-    MAP_FOREACH(int*, iterator,players){
-        PlayerFlag compare_type = PLAYER_LEVEL_COMPARE;
-        PlayerData temp = (PlayerData) mapGet(players , iterator);
-        assert(temp != NULL);
-        if(playerCompare(players , &highest_level_player , iterator , &compare_type) < EQUAL){
-            if(temp->status == UNPRINTED){
-                highest_level_player = *(int*) iterator;
-            }
-        }
-        destroyIntKey(iterator);
-    }
-    PlayerData player_data = mapGet(players , &highest_level_player);
-    assert(player_data != NULL);
-    player_data->status = PRINTED;
-    *level = calculateLevel(player_data);
-    *result = PLAYER_SUCCESS;
-    return highest_level_player;
-}
-
-void playerInitiateStatus(Map players){
-    assert(players != NULL);
-    MAP_FOREACH(int*, iterator,players){
-        PlayerData player_data = (PlayerData) mapGet(players , iterator);
-        assert(player_data != NULL);
-        if(player_data->num_of_games == NO_GAMES){
-            player_data->status = PRINTED;
-        }
-        destroyIntKey(iterator);
-    }
-}
-
-void playerResetStatus(Map players){
-    assert(players != NULL);
-    MAP_FOREACH(int*, iterator,players){
-        PlayerData player_data = (PlayerData) mapGet(players , iterator);
-        player_data->status = UNPRINTED;
-        destroyIntKey(iterator);
-    }
-}
-
 PlayerNodeResult playerRemoveData(Map external_list, Map internal_list){
     if(internal_list == NULL || external_list == NULL){
         return PLAYER_NULL_ARGUMENT;
     }
-    MAP_FOREACH(int*, iterator,internal_list){
-        PlayerData internal_player_data = (PlayerData) mapGet(internal_list , iterator);
-        if(internal_player_data == NULL){
-            return PLAYER_NULL_ARGUMENT;
-        }
-        playerUpdateData(external_list , iterator ,PLAYER_WIN,
-                                  -internal_player_data->winning);
-        playerUpdateData(external_list , iterator ,PLAYER_LOSS,
-                                  -internal_player_data->loss);
-        playerUpdateData(external_list , iterator ,PLAYER_DRAWS,
-                                  -internal_player_data->draw);
-        destroyIntKey(iterator);
-    }
+    mapMergeApply(external_list , internal_list , removeInternalData , NULL);
     return PLAYER_SUCCESS;
 }
 
@@ -328,10 +432,379 @@ PlayerNodeResult playersAdd (Map players , int first_player , int second_player
     return PLAYER_SUCCESS;
 }
 
+void playersReserve(Map players , int first_player , int second_player ,
+                    bool first_player_was_allocated , bool second_player_was_allocated){
+    assert(players != NULL);
+    PlayerData first_player_data = mapGet(players , &first_player);
+    PlayerData second_player_data = mapGet(players , &second_player);
+    assert(first_player_data != NULL && second_player_data != NULL);
+    first_player_data->reservations++;
+    second_player_data->reservations++;
+    first_player_data->reserved_new |= first_player_was_allocated;
+    second_player_data->reserved_new |= second_player_was_allocated;
+}
+
+void playersRelease(Map players , int first_player , int second_player , bool committed){
+    assert(players != NULL);
+    releasePlayer(players , first_player , committed);
+    releasePlayer(players , second_player , committed);
+}
+
+PlayerTable playerTableCreate(Map players){
+    if(players == NULL){
+        return NULL;
+    }
+    int size = mapGetSize(players);
+    PlayerTable table = malloc(sizeof(*table) + size * sizeof(double) +
+                               PLAYER_TABLE_COLUMNS * size * sizeof(int));
+    if(table == NULL){
+        return NULL;
+    }
+    table->size = size;
+    playerTableSetColumns(table , size);
+    TableCursor cursor = {table , 0};
+    mapApply(players , fillTableRow , &cursor);
+    assert(cursor.position == size);
+    playerTableComputeLevels(table);
+    return table;
+}
+
+void playerTableDestroy(PlayerTable table){
+    free(table);
+}
+
+int playerTableGetSize(PlayerTable table){
+    if(table == NULL){
+        return EMPTY;
+    }
+    return table->size;
+}
+
+PlayerTable playerTableCopy(PlayerTable table){
+    if(table == NULL){
+        return NULL;
+    }
+    size_t block_size = sizeof(*table) + table->capacity * sizeof(double) +
+                        PLAYER_TABLE_COLUMNS * table->capacity * sizeof(int);
+    PlayerTable copy = malloc(block_size);
+    if(copy == NULL){
+        return NULL;
+    }
+    memcpy(copy , table , block_size);
+    playerTableSetColumns(copy , table->capacity);
+    return copy;
+}
+
+int playerTableGetId(PlayerTable table, int position){
+    assert(table != NULL && position >= 0 && position < table->size);
+    return table->id[position];
+}
+
+bool playerTableContains(PlayerTable table, int player_id){
+    if(table == NULL){
+        return false;
+    }
+    return playerTableFind(table , player_id) != EMPTY;
+}
+
+bool playerTableRemove(PlayerTable table, int player_id){
+    if(table == NULL){
+        return false;
+    }
+    int position = playerTableFind(table , player_id);
+    if(position == EMPTY){
+        return false;
+    }
+    int moved = table->size - position - 1;
+    memmove(table->level + position , table->level + position + 1 , moved * sizeof(double));
+    memmove(table->id + position , table->id + position + 1 , moved * sizeof(int));
+    memmove(table->winning + position , table->winning + position + 1 , moved * sizeof(int));
+    memmove(table->loss + position , table->loss + position + 1 , moved * sizeof(int));
+    memmove(table->draw + position , table->draw + position + 1 , moved * sizeof(int));
+    memmove(table->num_of_games + position , table->num_of_games + position + 1 , moved * sizeof(int));
+    table->size--;
+    return true;
+}
+
+PlayerNodeResult playerTableRemoveData(Map external_list, PlayerTable table){
+    if(external_list == NULL || table == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    TableCursor cursor = {table , 0};
+    mapApply(external_list , removeTableData , &cursor);
+    return PLAYER_SUCCESS;
+}
+
+PlayerNodeResult playersSave(Map players, SnapshotWriter writer){
+    if(players == NULL || writer == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    snapshotWriteInt(writer , mapGetSize(players));
+    mapApply(players , savePlayerRecord , writer);
+    return PLAYER_SUCCESS;
+}
 
+PlayerNodeResult playerTableSave(PlayerTable table, SnapshotWriter writer){
+    if(table == NULL || writer == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    snapshotWriteInt(writer , table->size);
+    for (int i = 0; i < table->size; ++i) {
+        snapshotWriteInt(writer , table->id[i]);
+        snapshotWriteInt(writer , table->winning[i]);
+        snapshotWriteInt(writer , table->loss[i]);
+        snapshotWriteInt(writer , table->draw[i]);
+        snapshotWriteInt(writer , table->num_of_games[i]);
+    }
+    return PLAYER_SUCCESS;
+}
+
+PlayerNodeResult playersLoad(Map players, SnapshotReader reader){
+    if(players == NULL || reader == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    assert(mapGetSize(players) == 0);
+    PlayerData player_data = playerCreatNode();
+    if(player_data == NULL){
+        return PLAYER_MEMORY_FAILED;
+    }
+    // nothing of a loaded map was exported yet
+    player_data->changed = true;
+    int previous_id = NULL_ARGUMENT;
+    int num_of_players = snapshotReadCount(reader , PLAYER_RECORD_SIZE);
+    for (int i = 0; i < num_of_players && snapshotReaderFailed(reader) == false; ++i) {
+        int player_id = snapshotReadInt(reader);
+        player_data->winning = snapshotReadInt(reader);
+        player_data->loss = snapshotReadInt(reader);
+        player_data->draw = snapshotReadInt(reader);
+        player_data->num_of_games = snapshotReadInt(reader);
+        if(player_id <= previous_id || player_data->winning < 0 || player_data->loss < 0 ||
+           player_data->draw < 0 || player_data->num_of_games < 0){
+            snapshotReaderReject(reader);
+            break;
+        }
+        if(mapPut(players , &player_id , player_data) == MAP_OUT_OF_MEMORY){
+            destroyNode(player_data);
+            return PLAYER_MEMORY_FAILED;
+        }
+        previous_id = player_id;
+    }
+    destroyNode(player_data);
+    return PLAYER_SUCCESS;
+}
+
+void playersForEach(Map players, PlayerStatsFunction function, void* context){
+    assert(players != NULL && function != NULL);
+    PlayerVisit visit = {function , context};
+    mapApply(players , visitPlayer , &visit);
+}
+
+void playerTableForEach(PlayerTable table, PlayerStatsFunction function, void* context){
+    assert(table != NULL && function != NULL);
+    for (int i = 0; i < table->size; ++i) {
+        function(table->id[i] , (PlayerStats){table->winning[i] , table->loss[i] , table->draw[i] ,
+                                              table->num_of_games[i]} , context);
+    }
+}
+
+PlayerNodeResult playerGetStats(Map players, int player_id, PlayerStats* stats, double* level){
+    if(players == NULL || stats == NULL || level == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    PlayerData player_data = mapGet(players , &player_id);
+    if(player_data == NULL){
+        return PLAYER_NOT_EXIST;
+    }
+    *stats = (PlayerStats){player_data->winning , player_data->loss , player_data->draw ,
+                           player_data->num_of_games};
+    *level = player_data->num_of_games == NO_GAMES ? NO_GAMES : calculateLevel(player_data);
+    return PLAYER_SUCCESS;
+}
+
+PlayerNodeResult playerTableGetStats(PlayerTable table, int player_id, PlayerStats* stats, double* level){
+    if(table == NULL || stats == NULL || level == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    int position = playerTableFind(table , player_id);
+    if(position == EMPTY){
+        return PLAYER_NOT_EXIST;
+    }
+    *stats = (PlayerStats){table->winning[position] , table->loss[position] , table->draw[position] ,
+                           table->num_of_games[position]};
+    *level = table->level[position];
+    return PLAYER_SUCCESS;
+}
+
+PlayerRemovals playerRemovalsCreate(){
+    PlayerRemovals removals = malloc(sizeof(*removals));
+    if(removals == NULL){
+        return NULL;
+    }
+    removals->size = 0;
+    removals->capacity = 0;
+    removals->ids = NULL;
+    return removals;
+}
+
+void playerRemovalsDestroy(PlayerRemovals removals){
+    if(removals == NULL){
+        return;
+    }
+    free(removals->ids);
+    free(removals);
+}
+
+PlayerNodeResult playerRemove(Map players, PlayerRemovals removals, int player_id){
+    if(players == NULL || removals == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    if(removals->size == removals->capacity){
+        int capacity = removals->capacity == 0 ? REMOVALS_INITIAL_CAPACITY :
+                       removals->capacity * REMOVALS_GROWTH_FACTOR;
+        int *ids = realloc(removals->ids , capacity * sizeof(*ids));
+        if(ids == NULL){
+            return PLAYER_MEMORY_FAILED;
+        }
+        removals->ids = ids;
+        removals->capacity = capacity;
+    }
+    if(mapRemove(players , &player_id) == MAP_ITEM_DOES_NOT_EXIST){
+        return PLAYER_NOT_EXIST;
+    }
+    removals->ids[removals->size++] = player_id;
+    return PLAYER_SUCCESS;
+}
+
+PlayerNodeResult playerPrintLevelsDelta(Map players, PlayerRemovals removals, FILE* file, int* num_of_players){
+    if(players == NULL || removals == NULL || file == NULL || num_of_players == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    *num_of_players = 0;
+    int size = mapGetSize(players);
+    LevelDelta level_delta;
+    level_delta.ranks = malloc((size + 1) * sizeof(*level_delta.ranks));
+    level_delta.changes = malloc((size + removals->size + 1) * sizeof(*level_delta.changes));
+    level_delta.changed = malloc((size + 1) * sizeof(*level_delta.changed));
+    PlayerRank *targets = malloc((size + 1) * sizeof(*targets));
+    int *counts = malloc((size + 1) * sizeof(*counts));
+    if(level_delta.ranks == NULL || level_delta.changes == NULL || level_delta.changed == NULL ||
+       targets == NULL || counts == NULL){
+        free(level_delta.ranks);
+        free(level_delta.changes);
+        free(level_delta.changed);
+        free(targets);
+        free(counts);
+        return PLAYER_MEMORY_FAILED;
+    }
+    if(removals->size > 0){
+        qsort(removals->ids , removals->size , sizeof(*removals->ids) , intCompare);
+    }
+    level_delta.num_of_ranks = 0;
+    level_delta.num_of_changes = 0;
+    level_delta.num_of_changed = 0;
+    level_delta.removed = removals->ids;
+    level_delta.num_of_removed = removals->size;
+    level_delta.next_removed = 0;
+    mapApply(players , collectLevelDelta , &level_delta);
+    collectRemovedPlayers(&level_delta , 0 , true);
+    levelDeltaRank(&level_delta , targets , counts);
+    free(targets);
+    free(counts);
+    PlayerNodeResult result = PLAYER_SUCCESS;
+    for (int i = 0; i < level_delta.num_of_changes && result == PLAYER_SUCCESS; ++i) {
+        LevelChange *change = &level_delta.changes[i];
+        int printed = change->removed ? fprintf(file , "- %d\n" , change->id) :
+                      fprintf(file , "+ %d %.2lf %d\n" , change->id , change->level , change->rank);
+        if(printed < EQUAL){
+            result = PLAYER_SAVE_FAILED;
+        }
+    }
+    if(result == PLAYER_SUCCESS){
+        for (int i = 0; i < level_delta.num_of_changed; ++i) {
+            level_delta.changed[i]->changed = false;
+        }
+        removals->size = 0;
+        *num_of_players = level_delta.num_of_changes;
+    }
+    free(level_delta.ranks);
+    free(level_delta.changes);
+    free(level_delta.changed);
+    return result;
+}
+
+PlayerNodeResult playerTablePrintLevels(PlayerTable table, FILE* file){
+    if(table == NULL || file == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    PlayerRank *ranks = malloc((table->size + 1) * sizeof(*ranks));
+    if(ranks == NULL){
+        return PLAYER_MEMORY_FAILED;
+    }
+    int num_of_ranks = playerTableCollectRanks(table , ranks);
+    qsort(ranks , num_of_ranks , sizeof(*ranks) , playerRankCompare);
+    for (int i = 0; i < num_of_ranks; ++i) {
+        if(fprintf(file , "%d %.2lf\n" , ranks[i].id , ranks[i].level) < EQUAL){
+            free(ranks);
+            return PLAYER_SAVE_FAILED;
+        }
+    }
+    free(ranks);
+    return PLAYER_SUCCESS;
+}
+
+PlayerNodeResult playerTablePrintLevelsParallel(PlayerTable table, FILE* file, ThreadPool pool){
+    if(table == NULL || file == NULL){
+        return PLAYER_NULL_ARGUMENT;
+    }
+    LevelExport level_export;
+    level_export.num_of_parts = threadPoolGetSize(pool);
+    level_export.ranks = malloc((table->size + 1) * sizeof(*level_export.ranks));
+    level_export.merged = malloc((table->size + 1) * sizeof(*level_export.merged));
+    level_export.part_start = malloc((level_export.num_of_parts + 1) * sizeof(int));
+    level_export.buffers = calloc(level_export.num_of_parts , sizeof(char*));
+    level_export.lengths = calloc(level_export.num_of_parts , sizeof(size_t));
+    level_export.failed = calloc(level_export.num_of_parts , sizeof(bool));
+    if(level_export.ranks == NULL || level_export.merged == NULL || level_export.part_start == NULL ||
+       level_export.buffers == NULL || level_export.lengths == NULL || level_export.failed == NULL){
+        levelExportFree(&level_export);
+        return PLAYER_MEMORY_FAILED;
+    }
+    int num_of_ranks = playerTableCollectRanks(table , level_export.ranks);
+    for (int i = 0; i <= level_export.num_of_parts; ++i) {
+        level_export.part_start[i] = (int)((long long)num_of_ranks * i / level_export.num_of_parts);
+    }
+    threadPoolRun(pool , level_export.num_of_parts , levelExportSortPart , &level_export);
+    levelExportMergeParts(&level_export);
+    threadPoolRun(pool , level_export.num_of_parts , levelExportFormatPart , &level_export);
+    PlayerNodeResult result = PLAYER_SUCCESS;
+    for (int i = 0; i < level_export.num_of_parts && result == PLAYER_SUCCESS; ++i) {
+        if(level_export.failed[i] == true){
+            result = PLAYER_MEMORY_FAILED;
+        } else if(fwrite(level_export.buffers[i] , 1 , level_export.lengths[i] , file) !=
+                  level_export.lengths[i]){
+            result = PLAYER_SAVE_FAILED;
+        }
+    }
+    levelExportFree(&level_export);
+    return result;
+}
 
 //static functions:
 
+static void releasePlayer(Map players , int player_id , bool committed){
+    PlayerData player_data = mapGet(players , &player_id);
+    assert(player_data != NULL && player_data->reservations > 0);
+    player_data->reservations--;
+    if(committed){
+        player_data->reserved_new = false;
+        return;
+    }
+    // the last reservation of a player that no game has used removes it
+    if(player_data->reservations == 0 && player_data->reserved_new && player_data->num_of_games == NO_GAMES){
+        mapRemove(players , &player_id);
+    }
+}
+
 static MapDataElement copyPlayerData(MapDataElement player_data){
     PlayerData new_player_data = malloc(sizeof(*new_player_data));
     if(new_player_data == NULL)
@@ -343,7 +816,9 @@ static MapDataElement copyPlayerData(MapDataElement player_data){
     new_player_data->loss = temp_player_data->loss;
     new_player_data->draw = temp_player_data->draw;
     new_player_data->num_of_games = temp_player_data->num_of_games;
-    new_player_data->status = temp_player_data->status;
+    new_player_data->changed = temp_player_data->changed;
+    new_player_data->reservations = temp_player_data->reservations;
+    new_player_data->reserved_new = temp_player_data->reserved_new;
     return new_player_data;
 }
 
@@ -404,25 +879,6 @@ static int playerCompareLevel(PlayerData player1 , PlayerData player2){
     return FIRST_IS_GREATER;
 }
 
-static int playerGetFirstToCompare(Map players , PlayerNodeResult *result){
-    int first_to_compare = EMPTY;
-    MAP_FOREACH(int*, iterator,players){
-        PlayerData player_data = (PlayerData) mapGet(players , iterator);
-        assert(player_data != NULL);
-        if(player_data->status == UNPRINTED){
-            first_to_compare = *(int*) iterator;
-            destroyIntKey(iterator);
-            break;
-        }
-        destroyIntKey(iterator);
-    }
-    if(first_to_compare == EMPTY){
-        *result = PLAYER_NO_PLAYERS_TO_PRINT;
-        return EMPTY;
-    }
-    return first_to_compare;
-}
-
 static void deallocateData(Map players , PlayerData first_player_data ,
                            PlayerData second_player_data , int first_player ,
                            int second_player , bool const *first_player_was_allocated ,
@@ -437,6 +893,368 @@ static void deallocateData(Map players , PlayerData first_player_data ,
     }
 }
 
+static void playerTableSetColumns(PlayerTable table , int capacity){
+    assert(table != NULL);
+    table->capacity = capacity;
+    table->level = (double*)(table + 1);
+    table->id = (int*)(table->level + capacity);
+    table->winning = table->id + capacity;
+    table->loss = table->winning + capacity;
+    table->draw = table->loss + capacity;
+    table->num_of_games = table->draw + capacity;
+}
+
+static void playerTableComputeLevels(PlayerTable table){
+    assert(table != NULL);
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128d win_coefficient = _mm_set1_pd(WIN_COEFFICIENT);
+    const __m128d loss_coefficient = _mm_set1_pd(LOSS_COEFFICIENT);
+    const __m128d draw_coefficient = _mm_set1_pd(DRAW_COEFFICIENT);
+    const __m128d no_games = _mm_setzero_pd();
+    for (; i + 2 <= table->size; i += 2) {
+        __m128d winning = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(table->winning + i)));
+        __m128d loss = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(table->loss + i)));
+        __m128d draw = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(table->draw + i)));
+        __m128d games = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i*)(table->num_of_games + i)));
+        __m128d points = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(win_coefficient , winning) ,
+                                               _mm_mul_pd(loss_coefficient , loss)) ,
+                                    _mm_mul_pd(draw_coefficient , draw));
+        __m128d played = _mm_cmpneq_pd(games , no_games);
+        _mm_storeu_pd(table->level + i , _mm_and_pd(played , _mm_div_pd(points , games)));
+    }
+#endif
+    for (; i < table->size; ++i) {
+        if(table->num_of_games[i] == NO_GAMES){
+            table->level[i] = NO_GAMES;
+            continue;
+        }
+        table->level[i] = (double)((WIN_COEFFICIENT * table->winning[i]) -
+                                   (LOSS_COEFFICIENT * table->loss[i]) +
+                                   (DRAW_COEFFICIENT * table->draw[i])) / (table->num_of_games[i]);
+    }
+}
+
+static int playerTableFind(PlayerTable table , int player_id){
+    assert(table != NULL);
+    int low = 0, high = table->size - 1;
+    while(low <= high){
+        int middle = low + (high - low) / 2;
+        if(table->id[middle] == player_id){
+            return middle;
+        }
+        if(table->id[middle] < player_id){
+            low = middle + 1;
+        } else{
+            high = middle - 1;
+        }
+    }
+    return EMPTY;
+}
+
+static int playerTableCollectRanks(PlayerTable table , PlayerRank *ranks){
+    assert(table != NULL && ranks != NULL);
+    int num_of_ranks = 0;
+    for (int i = 0; i < table->size; ++i) {
+        if(table->num_of_games[i] != NO_GAMES){
+            ranks[num_of_ranks].level = table->level[i];
+            ranks[num_of_ranks].id = table->id[i];
+            num_of_ranks++;
+        }
+    }
+    return num_of_ranks;
+}
+
+static void levelExportSortPart(int part , void *level_export){
+    LevelExport *data = level_export;
+    int start = data->part_start[part];
+    qsort(data->ranks + start , data->part_start[part + 1] - start , sizeof(PlayerRank) ,
+          playerRankCompare);
+}
+
+static void levelExportMergeParts(LevelExport *level_export){
+    // a binary min heap of the parts, ordered by their current (first unmerged) rank
+    int num_of_parts = level_export->num_of_parts;
+    int *next = malloc(num_of_parts * sizeof(int));
+    int *parts = malloc((num_of_parts + 1) * sizeof(int));
+    if(next == NULL || parts == NULL){
+        // fall back to merging by a full sort, the output is the same
+        free(next);
+        free(parts);
+        int num_of_ranks = level_export->part_start[num_of_parts];
+        memcpy(level_export->merged , level_export->ranks , num_of_ranks * sizeof(PlayerRank));
+        qsort(level_export->merged , num_of_ranks , sizeof(PlayerRank) , playerRankCompare);
+        return;
+    }
+    int heap_size = 0;
+    for (int part = 0; part < num_of_parts; ++part) {
+        next[part] = level_export->part_start[part];
+        if(next[part] == level_export->part_start[part + 1]){
+            continue;
+        }
+        int child = ++heap_size;
+        parts[child] = part;
+        while(child / 2 > NO_PARENT && playerRankCompare(&level_export->ranks[next[parts[child]]] ,
+                                        &level_export->ranks[next[parts[child / 2]]]) < EQUAL){
+            int temp = parts[child];
+            parts[child] = parts[child / 2];
+            parts[child / 2] = temp;
+            child /= 2;
+        }
+    }
+    int merged = 0;
+    while(heap_size > 0){
+        int part = parts[1];
+        level_export->merged[merged++] = level_export->ranks[next[part]++];
+        if(next[part] == level_export->part_start[part + 1]){
+            parts[1] = parts[heap_size--];
+        }
+        int parent = 1;
+        while(2 * parent <= heap_size){
+            int child = 2 * parent;
+            if(child + 1 <= heap_size && playerRankCompare(&level_export->ranks[next[parts[child + 1]]] ,
+                                                           &level_export->ranks[next[parts[child]]]) < EQUAL){
+                child++;
+            }
+            if(playerRankCompare(&level_export->ranks[next[parts[parent]]] ,
+                                 &level_export->ranks[next[parts[child]]]) < EQUAL){
+                break;
+            }
+            int temp = parts[child];
+            parts[child] = parts[parent];
+            parts[parent] = temp;
+            parent = child;
+        }
+    }
+    free(next);
+    free(parts);
+}
+
+static void levelExportFormatPart(int part , void *level_export){
+    LevelExport *data = level_export;
+    int start = data->part_start[part], end = data->part_start[part + 1];
+    size_t capacity = (size_t)(end - start) * LEVEL_LINE_SIZE + 1;
+    char *buffer = malloc(capacity);
+    size_t length = 0;
+    bool failed = (buffer == NULL);
+    for (int i = start; i < end && failed == false; ++i) {
+        int written = snprintf(buffer + length , capacity - length , "%d %.2lf\n" ,
+                               data->merged[i].id , data->merged[i].level);
+        if(written < EQUAL){
+            failed = true;
+            break;
+        }
+        if((size_t)written >= capacity - length){
+            // the line did not fit: grow the buffer and format it again
+            capacity = 2 * capacity + written;
+            char *bigger = realloc(buffer , capacity);
+            if(bigger == NULL){
+                failed = true;
+                break;
+            }
+            buffer = bigger;
+            i--;
+            continue;
+        }
+        length += written;
+    }
+    data->buffers[part] = buffer;
+    data->lengths[part] = length;
+    data->failed[part] = failed;
+}
+
+static void removeTableData(MapKeyElement player_id , MapDataElement external_data , void *table_cursor){
+    assert(player_id != NULL && external_data != NULL && table_cursor != NULL);
+    TableCursor *cursor = table_cursor;
+    PlayerTable table = cursor->table;
+    while(cursor->position < table->size && table->id[cursor->position] < *(int*)player_id){
+        cursor->position++;
+    }
+    if(cursor->position == table->size || table->id[cursor->position] != *(int*)player_id){
+        return;
+    }
+    PlayerData external_player_data = (PlayerData)external_data;
+    updatePlayerByFactor(PLAYER_WIN , external_player_data , -table->winning[cursor->position]);
+    updatePlayerByFactor(PLAYER_LOSS , external_player_data , -table->loss[cursor->position]);
+    updatePlayerByFactor(PLAYER_DRAWS , external_player_data , -table->draw[cursor->position]);
+}
+
+static void fillTableRow(MapKeyElement player_id , MapDataElement player_data , void *table_cursor){
+    assert(player_id != NULL && player_data != NULL && table_cursor != NULL);
+    TableCursor *cursor = table_cursor;
+    PlayerTable table = cursor->table;
+    PlayerData data = player_data;
+    int row = cursor->position++;
+    assert(row < table->size);
+    table->id[row] = *(int*)player_id;
+    table->winning[row] = data->winning;
+    table->loss[row] = data->loss;
+    table->draw[row] = data->draw;
+    table->num_of_games[row] = data->num_of_games;
+}
+
+static void compareWinner(MapKeyElement player_id , MapDataElement player_data , void *player_winner){
+    assert(player_id != NULL && player_data != NULL && player_winner != NULL);
+    PlayerWinner *winner = player_winner;
+    // a tie keeps the player that came first
+    if(winner->data == NULL || playerComparePoints(winner->data , player_data) < EQUAL){
+        winner->id = *(int*)player_id;
+        winner->data = player_data;
+    }
+}
+
+static void levelExportFree(LevelExport *level_export){
+    if(level_export->buffers != NULL){
+        for (int i = 0; i < level_export->num_of_parts; ++i) {
+            free(level_export->buffers[i]);
+        }
+    }
+    free(level_export->ranks);
+    free(level_export->merged);
+    free(level_export->part_start);
+    free(level_export->buffers);
+    free(level_export->lengths);
+    free(level_export->failed);
+}
+
+static int playerRankCompare(const void *rank1 , const void *rank2){
+    const PlayerRank *first = rank1;
+    const PlayerRank *second = rank2;
+    if(first->level > second->level){
+        return SECOND_IS_GREATER;
+    }
+    if(first->level < second->level){
+        return FIRST_IS_GREATER;
+    }
+    if(first->id < second->id){
+        return SECOND_IS_GREATER;
+    }
+    if(first->id > second->id){
+        return FIRST_IS_GREATER;
+    }
+    return EQUAL;
+}
+
+static void savePlayerRecord(MapKeyElement player_id , MapDataElement player_data , void *writer){
+    assert(player_id != NULL && player_data != NULL && writer != NULL);
+    PlayerData data = player_data;
+    snapshotWriteInt(writer , *(int*)player_id);
+    snapshotWriteInt(writer , data->winning);
+    snapshotWriteInt(writer , data->loss);
+    snapshotWriteInt(writer , data->draw);
+    snapshotWriteInt(writer , data->num_of_games);
+}
+
+static void visitPlayer(MapKeyElement player_id , MapDataElement player_data , void *visit){
+    assert(player_id != NULL && player_data != NULL && visit != NULL);
+    PlayerData data = player_data;
+    PlayerVisit *player_visit = visit;
+    player_visit->function(*(int*)player_id , (PlayerStats){data->winning , data->loss , data->draw ,
+                                                           data->num_of_games} , player_visit->context);
+}
+
+static void collectLevelDelta(MapKeyElement player_id , MapDataElement player_data , void *level_delta){
+    assert(player_id != NULL && player_data != NULL && level_delta != NULL);
+    LevelDelta *delta = level_delta;
+    PlayerData data = player_data;
+    int id = *(int*)player_id;
+    collectRemovedPlayers(delta , id , false);
+    double level = data->num_of_games == NO_GAMES ? NO_GAMES : calculateLevel(data);
+    if(data->num_of_games != NO_GAMES){
+        delta->ranks[delta->num_of_ranks].level = level;
+        delta->ranks[delta->num_of_ranks].id = id;
+        delta->num_of_ranks++;
+    }
+    if(data->changed){
+        delta->changed[delta->num_of_changed++] = data;
+        LevelChange *change = &delta->changes[delta->num_of_changes++];
+        change->id = id;
+        change->removed = data->num_of_games == NO_GAMES;
+        change->level = level;
+        change->rank = NO_GAMES;
+    }
+}
+
+static void collectRemovedPlayers(LevelDelta *level_delta , int player_id , bool all){
+    while(level_delta->next_removed < level_delta->num_of_removed &&
+          (all || level_delta->removed[level_delta->next_removed] <= player_id)){
+        int removed_id = level_delta->removed[level_delta->next_removed++];
+        bool added = level_delta->num_of_changes > 0 &&
+                     level_delta->changes[level_delta->num_of_changes - 1].id == removed_id;
+        if(added || (all == false && removed_id == player_id)){
+            continue;
+        }
+        LevelChange *change = &level_delta->changes[level_delta->num_of_changes++];
+        change->id = removed_id;
+        change->removed = true;
+        change->level = NO_GAMES;
+        change->rank = NO_GAMES;
+    }
+}
+
+static void levelDeltaRank(LevelDelta *level_delta , PlayerRank *targets , int *counts){
+    assert(level_delta != NULL && targets != NULL && counts != NULL);
+    int num_of_targets = 0;
+    for (int i = 0; i < level_delta->num_of_changes; ++i) {
+        if(level_delta->changes[i].removed == false){
+            targets[num_of_targets].level = level_delta->changes[i].level;
+            targets[num_of_targets].id = level_delta->changes[i].id;
+            num_of_targets++;
+        }
+    }
+    qsort(targets , num_of_targets , sizeof(*targets) , playerRankCompare);
+    for (int i = 0; i <= num_of_targets; ++i) {
+        counts[i] = 0;
+    }
+    // a player is before the changed players from the first one that it is before, so it is counted there
+    for (int i = 0; i < level_delta->num_of_ranks; ++i) {
+        int low = 0;
+        int high = num_of_targets;
+        while(low < high){
+            int middle = low + (high - low) / 2;
+            if(playerRankCompare(&level_delta->ranks[i] , &targets[middle]) < EQUAL){
+                high = middle;
+            }
+            else{
+                low = middle + 1;
+            }
+        }
+        counts[low]++;
+    }
+    int num_before = 0;
+    for (int i = 0; i < num_of_targets; ++i) {
+        num_before += counts[i];
+        LevelChange key = {targets[i].id , false , NO_GAMES , NO_GAMES};
+        LevelChange *change = bsearch(&key , level_delta->changes , level_delta->num_of_changes ,
+                                      sizeof(*level_delta->changes) , levelChangeCompare);
+        assert(change != NULL);
+        change->rank = num_before + 1;
+    }
+}
+
+static int intCompare(const void *int1 , const void *int2){
+    int first = *(const int*)int1;
+    int second = *(const int*)int2;
+    return (first > second) - (first < second);
+}
+
+static int levelChangeCompare(const void *change1 , const void *change2){
+    const LevelChange *first = change1;
+    const LevelChange *second = change2;
+    return (first->id > second->id) - (first->id < second->id);
+}
+
+static void removeInternalData(MapKeyElement player_id , MapDataElement external_data ,
+                               MapDataElement internal_data , void *context){
+    assert(player_id != NULL && external_data != NULL && internal_data != NULL);
+    (void)context;
+    PlayerData external_player_data = (PlayerData)external_data;
+    PlayerData internal_player_data = (PlayerData)internal_data;
+    updatePlayerByFactor(PLAYER_WIN , external_player_data , -internal_player_data->winning);
+    updatePlayerByFactor(PLAYER_LOSS , external_player_data , -internal_player_data->loss);
+    updatePlayerByFactor(PLAYER_DRAWS , external_player_data , -internal_player_data->draw);
+}
+
 static double calculateLevel(PlayerData player_data){
     assert(player_data != NULL);
     assert(player_data->num_of_games != EQUAL);
@@ -458,5 +1276,6 @@ static void updatePlayerByFactor(PlayerFlag result,
         player->draw += factor;
     }
     player->num_of_games += factor;
+    player->changed = true;
     assert(player->num_of_games>=0);
-}
\ No newline at end of file
+}
@@ -6,10 +6,29 @@
 #define MTM_CHESS_PLAYERS_H
 
 #include "map.h"
+#include "arena.h"
 #include <stdbool.h>
+#include <stdio.h>
 #include "chessSystem.h"
+#include "threadPool.h"
+#include "snapshot.h"
 
 typedef struct player_t *PlayerData;
+typedef struct player_table_t *PlayerTable;
+typedef struct player_removals_t *PlayerRemovals;
+
+/** The results of a player, or a change of them */
+
+typedef struct PlayerStats_t{
+    int wins;
+    int losses;
+    int draws;
+    int num_of_games;
+}PlayerStats;
+
+/** Type of function that is called with the id of a player and its results (or their change) */
+
+typedef void (*PlayerStatsFunction)(int player_id, PlayerStats stats, void* context);
 
 /** Type used for returning error codes from playerData functions */
 
@@ -17,7 +36,8 @@ typedef enum PlayerNodeResult_t{
     PLAYER_SUCCESS,
     PLAYER_MEMORY_FAILED,
     PLAYER_NULL_ARGUMENT,
-    PLAYER_NO_PLAYERS_TO_PRINT
+    PLAYER_SAVE_FAILED,
+    PLAYER_NOT_EXIST
 }PlayerNodeResult;
 
 /** Type used for sending different flags to playerData functions */
@@ -41,11 +61,12 @@ PlayerData playerCreatNode();
 
 /**
  * function for creating a player map
+ * @param arena - the arena that the players are allocated from, NULL to allocate every player on its own
  * @return
  * NULL - if memory failed
  * players map - otherwise
  */
-Map playersCreateMap();
+Map playersCreateMap(Arena arena);
 
 /**compares between 2 players who has a greater level or points:
  * @param player_list - the list in which the players are
@@ -102,26 +123,6 @@ int playerGetNumOfGames(Map players, MapKeyElement player_id);
 
 PlayerNodeResult playerUpdateData(Map players, MapKeyElement player_id,
                                   PlayerFlag result, int factor);
-/**
- * playerGetPlayerByLevels: getting the id of the player with the highest level and non printed status
- * @param players - list that contains the players
- * @param level - a pointer where to put the level of the above player
- * @param result - a pointer where to put the result - PLAYER_NULL_ARGUMENT if a null was sent,
- * PLAYER_SUCCESS otherwise
- * @return
- * -1 - if player list is NULL or no more player level to print
-*  player id - the id of the player with the highest level and non printed status
- */
-
-int playerGetPlayerByLevels(Map players, double *level , PlayerNodeResult *result);
-
-/**
- * playerResetStatus - resets all player's status to UNPRINTED
- * @param player_list - the list of players to reset
- */
-
-void playerResetStatus(Map players);
-
 /**
  * playerRemoveData: removes all the data of the external list according to the internal list
  * @param external_list - the system's player list
@@ -159,6 +160,31 @@ PlayerNodeResult playersAdd (Map players , int first_player , int second_player
 
 void updateExternalPlayer(Map players , Winner winner ,
                                       int first_player,int second_player);
+
+/**
+ * playersReserve: pins two players of the map for a game that is committed later, so a failed game of
+ * another call does not remove them meanwhile. every reservation is released by playersRelease.
+ * @param players - map of players that contains both players, as playersAdd has left it
+ * @param first_player - first player of the game
+ * @param second_player - second player of the game
+ * @param first_player_was_allocated - if playersAdd has added the first player for this game
+ * @param second_player_was_allocated - if playersAdd has added the second player for this game
+ */
+
+void playersReserve(Map players , int first_player , int second_player ,
+                    bool first_player_was_allocated , bool second_player_was_allocated);
+
+/**
+ * playersRelease: releases the reservation of two players. when the game was not committed, a player
+ * that a reservation has added is removed by its last reservation, if no game has used it.
+ * makes no allocations.
+ * @param players - map of players
+ * @param first_player - first player of the game
+ * @param second_player - second player of the game
+ * @param committed - if the game of the reservation was committed
+ */
+
+void playersRelease(Map players , int first_player , int second_player , bool committed);
 /**
  * function for coping a key element
  * @param player_id - the key which to copy
@@ -182,9 +208,225 @@ void destroyIntKey(MapKeyElement key);
 void destroyNode(MapDataElement Node);
 
 /**
- * function for initiating all players' status with 0 number of games to PRINTED
- * @param players - players to status initiate
+ * playerTableCreate: copies a players map into a columnar table - the ids, wins, losses, draws
+ * and number of games of all the players are kept in contiguous arrays (one allocation), sorted by id.
+ * the levels of all the players are computed in one vectorized pass.
+ * the table is a snapshot: later changes of the map are not seen by the table.
+ * @param players - the map of players to copy
+ * @return
+ * NULL - if allocation error or a NULL map was sent
+ * the table - otherwise
+ */
+PlayerTable playerTableCreate(Map players);
+
+/**
+ * playerTableDestroy: deallocates a players table
+ * @param table - the table to free
+ */
+void playerTableDestroy(PlayerTable table);
+
+/**
+ * playerTableGetSize: returns the number of players in the table
+ * @param table - the table of players
+ * @return -1 for NULL, the number of players otherwise
  */
+int playerTableGetSize(PlayerTable table);
 
-void playerInitiateStatus(Map players);
+/**
+ * playerTableCopy: copies a players table
+ * @param table - the table to copy
+ * @return
+ * NULL - if allocation error or a NULL table was sent
+ * the copy - otherwise
+ */
+PlayerTable playerTableCopy(PlayerTable table);
+
+/**
+ * playerTableGetId: returns the id of the player in the given position of the table (sorted by id)
+ * @param table - the table of players
+ * @param position - the position, between 0 and the size of the table
+ * @return the id of the player
+ */
+int playerTableGetId(PlayerTable table, int position);
+
+/**
+ * playerTableContains: checks if a player is in the table, by a binary search
+ * @param table - the table of players
+ * @param player_id - the id of the player
+ * @return true if the player is in the table, false otherwise or for NULL
+ */
+bool playerTableContains(PlayerTable table, int player_id);
+
+/**
+ * playerTableRemove: removes a player from the table
+ * @param table - the table of players
+ * @param player_id - the id of the player to remove
+ * @return true if the player was removed, false if it was not in the table or for NULL
+ */
+bool playerTableRemove(PlayerTable table, int player_id);
+
+/**
+ * playerTableRemoveData: removes the data of the players of the table from the external list,
+ * like playerRemoveData does for an internal list, in one walk of the external list
+ * @param external_list - the system's player list
+ * @param table - the tournament's players table
+ * @return
+ * PLAYER_NULL_ARGUMENT - if external_list or table are NULL
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerTableRemoveData(Map external_list, PlayerTable table);
+
+/**
+ * playerTablePrintLevels: prints the id and the level of every player that has played,
+ * from the highest level to the lowest (the lower id first on equal levels), a player per line.
+ * @param table - the table of players
+ * @param file - the file to print to
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL was sent
+ * PLAYER_MEMORY_FAILED - if allocation error
+ * PLAYER_SAVE_FAILED - if printing to the file failed
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerTablePrintLevels(PlayerTable table, FILE* file);
+
+/**
+ * playerTablePrintLevelsParallel: prints the same output as playerTablePrintLevels, using the threads
+ * of the pool: the players are split into a part per thread, the parts are sorted at the same time
+ * and merged, and the lines of every part are formatted at the same time into a buffer per part,
+ * that are written to the file in order.
+ * @param table - the table of players
+ * @param file - the file to print to
+ * @param pool - the threads to use. NULL runs everything on the calling thread
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL table or file was sent
+ * PLAYER_MEMORY_FAILED - if allocation error
+ * PLAYER_SAVE_FAILED - if printing to the file failed
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerTablePrintLevelsParallel(PlayerTable table, FILE* file, ThreadPool pool);
+
+/**
+ * playersSave: writes the number of players and the record of every player to a snapshot,
+ * in the order of the ids
+ * @param players - map of players
+ * @param writer - the snapshot to write to
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL was sent
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playersSave(Map players, SnapshotWriter writer);
+
+/**
+ * playerTableSave: writes the players of the table to a snapshot, in the same format as playersSave
+ * @param table - the table of players
+ * @param writer - the snapshot to write to
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL was sent
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerTableSave(PlayerTable table, SnapshotWriter writer);
+
+/**
+ * playersLoad: reads players that were written by playersSave or playerTableSave into a map.
+ * the records are in the order of the ids, so every player is appended to the end of the map.
+ * a record that is not valid fails the reader
+ * @param players - an empty map of players
+ * @param reader - the snapshot to read from
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL was sent
+ * PLAYER_MEMORY_FAILED - if allocation error
+ * PLAYER_SUCCESS - otherwise, also when the reader failed
+ */
+PlayerNodeResult playersLoad(Map players, SnapshotReader reader);
+
+/**
+ * playersForEach: calls a function with the id and the results of every player of a map, in the order of the ids
+ * @param players - map of players
+ * @param function - the function to call
+ * @param context - a pointer that is passed as is to the function
+ */
+void playersForEach(Map players, PlayerStatsFunction function, void* context);
+
+/**
+ * playerTableForEach: calls a function with the id and the results of every player of a table,
+ * in the order of the ids
+ * @param table - the table of players
+ * @param function - the function to call
+ * @param context - a pointer that is passed as is to the function
+ */
+void playerTableForEach(PlayerTable table, PlayerStatsFunction function, void* context);
+
+/**
+ * playerGetStats: gets the results and the level of one player of a map, with a single lookup
+ * @param players - map of players
+ * @param player_id - the id of the player
+ * @param stats - where to put the results of the player
+ * @param level - where to put the level of the player, 0 if it has no games
+ * @return
+ * PLAYER_NULL_ARGUMENT - if one of the arguments is NULL
+ * PLAYER_NOT_EXIST - if the player is not in the map
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerGetStats(Map players, int player_id, PlayerStats* stats, double* level);
+
+/**
+ * playerTableGetStats: gets the results and the level of one player of a table, with a binary search of the ids
+ * @param table - the table of players
+ * @param player_id - the id of the player
+ * @param stats - where to put the results of the player
+ * @param level - where to put the level of the player, 0 if it has no games
+ * @return
+ * PLAYER_NULL_ARGUMENT - if one of the arguments is NULL
+ * PLAYER_NOT_EXIST - if the player is not in the table
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerTableGetStats(PlayerTable table, int player_id, PlayerStats* stats, double* level);
+
+/**
+ * playerRemovalsCreate: creates an empty list of the players that were removed from a players map
+ * since the last delta export of its levels
+ * @return
+ * NULL - if allocation error
+ * the list - otherwise
+ */
+PlayerRemovals playerRemovalsCreate();
+
+/**
+ * playerRemovalsDestroy: deallocates a list of removed players
+ * @param removals - the list to free
+ */
+void playerRemovalsDestroy(PlayerRemovals removals);
+
+/**
+ * playerRemove: removes a player from a players map and records it in the list of removed players.
+ * the place in the list is allocated first, so the player is removed only if it is recorded
+ * @param players - map of players
+ * @param removals - the list of the players that were removed from the map
+ * @param player_id - the id of the player to remove
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL was sent
+ * PLAYER_NOT_EXIST - if the player is not in the map
+ * PLAYER_MEMORY_FAILED - if allocation error, the player is not removed
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerRemove(Map players, PlayerRemovals removals, int player_id);
+
+/**
+ * playerPrintLevelsDelta: prints the players whose levels changed since the last delta export, a line per
+ * player in the order of the ids. the results of a player are marked as changed whenever they are updated.
+ * a player that has played is printed as "+ <id> <level> <rank>", with the level as in playerTablePrintLevels
+ * and its rank in the full export (1 for the first line). a player that was removed, or that has no games
+ * anymore, is printed as "- <id>". the ranks are found in one walk of the players, without sorting them all.
+ * after a successful export, no player is changed and the list of removed players is empty.
+ * @param players - map of players
+ * @param removals - the list of the players that were removed from the map
+ * @param file - the file to print to
+ * @param num_of_players - a pointer where to put the number of lines that were printed
+ * @return
+ * PLAYER_NULL_ARGUMENT - if a NULL was sent
+ * PLAYER_MEMORY_FAILED - if allocation error, nothing is printed
+ * PLAYER_SAVE_FAILED - if printing to the file failed, the players stay changed
+ * PLAYER_SUCCESS - otherwise
+ */
+PlayerNodeResult playerPrintLevelsDelta(Map players, PlayerRemovals removals, FILE* file, int* num_of_players);
 #endif //MTM_CHESS_PLAYERS_H
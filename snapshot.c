@@ -0,0 +1,271 @@
+#include "snapshot.h"
+#include "binaryFile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define SNAPSHOT_MAGIC 0x4e534843u /* "CHSN" */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 8
+#define SNAPSHOT_CHECKSUM_SIZE 8
+#define SNAPSHOT_BUFFER_SIZE (1 << 16)
+#define INT_SIZE 4
+#define DOUBLE_SIZE 8
+#define BITS_IN_BYTE 8
+#define BYTE_MASK 0xff
+
+struct snapshot_writer_t
+{
+    FILE* file;
+    uint64_t checksum;
+    size_t length;
+    bool failed;
+    unsigned char buffer[SNAPSHOT_BUFFER_SIZE];
+};
+
+struct snapshot_reader_t
+{
+    unsigned char* content;
+    size_t length;
+    size_t position;
+    bool failed;
+};
+
+/* write the buffer of the writer to its file */
+static void snapshotFlush(SnapshotWriter writer);
+
+/* append bytes to the writer, through its buffer */
+static void snapshotWriteBytes(SnapshotWriter writer, const unsigned char* bytes, size_t length);
+
+/* append an unsigned value of the given number of bytes, little endian */
+static void snapshotWriteUnsigned(SnapshotWriter writer, uint64_t value, int size);
+
+/* read an unsigned value of the given number of bytes from a position of a buffer, little endian */
+static uint64_t snapshotDecodeUnsigned(const unsigned char* bytes, int size);
+
+/* take the next bytes of the reader. NULL if there are not enough bytes (the reader is failed) */
+static const unsigned char* snapshotTake(SnapshotReader reader, size_t length);
+
+SnapshotWriter snapshotWriterCreate(const char* path)
+{
+    if(path == NULL) {
+        return NULL;
+    }
+    SnapshotWriter writer = malloc(sizeof(*writer));
+    if(writer == NULL) {
+        return NULL;
+    }
+    writer->file = fopen(path, "wb");
+    if(writer->file == NULL) {
+        free(writer);
+        return NULL;
+    }
+    writer->checksum = FNV_64_OFFSET_BASIS;
+    writer->length = 0;
+    writer->failed = false;
+    snapshotWriteUnsigned(writer, SNAPSHOT_MAGIC, INT_SIZE);
+    snapshotWriteUnsigned(writer, SNAPSHOT_VERSION, INT_SIZE);
+    return writer;
+}
+
+SnapshotResult snapshotWriterClose(SnapshotWriter writer)
+{
+    assert(writer != NULL);
+    snapshotFlush(writer);
+    // the checksum is the last value, so it is not part of itself
+    snapshotWriteUnsigned(writer, writer->checksum, SNAPSHOT_CHECKSUM_SIZE);
+    snapshotFlush(writer);
+    bool failed = writer->failed;
+    if(fclose(writer->file) == EOF) {
+        failed = true;
+    }
+    free(writer);
+    return failed ? SNAPSHOT_FILE_ERROR : SNAPSHOT_SUCCESS;
+}
+
+void snapshotWriteInt(SnapshotWriter writer, int value)
+{
+    snapshotWriteUnsigned(writer, (uint32_t)value, INT_SIZE);
+}
+
+void snapshotWriteDouble(SnapshotWriter writer, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    snapshotWriteUnsigned(writer, bits, DOUBLE_SIZE);
+}
+
+void snapshotWriteString(SnapshotWriter writer, const char* value)
+{
+    assert(value != NULL);
+    size_t length = strlen(value);
+    snapshotWriteInt(writer, (int)length);
+    snapshotWriteBytes(writer, (const unsigned char*)value, length + 1);
+}
+
+SnapshotResult snapshotReaderCreate(const char* path, SnapshotReader* reader)
+{
+    if(path == NULL || reader == NULL) {
+        return SNAPSHOT_FILE_ERROR;
+    }
+    unsigned char* content = NULL;
+    size_t length = 0;
+    BinaryFileResult result = binaryFileRead(path, &content, &length);
+    if(result != BINARY_FILE_SUCCESS) {
+        return result == BINARY_FILE_OUT_OF_MEMORY ? SNAPSHOT_OUT_OF_MEMORY : SNAPSHOT_FILE_ERROR;
+    }
+    if(length < SNAPSHOT_HEADER_SIZE + SNAPSHOT_CHECKSUM_SIZE ||
+       snapshotDecodeUnsigned(content, INT_SIZE) != SNAPSHOT_MAGIC ||
+       snapshotDecodeUnsigned(content + INT_SIZE, INT_SIZE) != SNAPSHOT_VERSION) {
+        free(content);
+        return SNAPSHOT_BAD_FORMAT;
+    }
+    size_t body_length = length - SNAPSHOT_CHECKSUM_SIZE;
+    if(binaryFileChecksum(FNV_64_OFFSET_BASIS, FNV_64_PRIME, content, body_length) !=
+       snapshotDecodeUnsigned(content + body_length, SNAPSHOT_CHECKSUM_SIZE)) {
+        free(content);
+        return SNAPSHOT_BAD_FORMAT;
+    }
+    SnapshotReader new_reader = malloc(sizeof(*new_reader));
+    if(new_reader == NULL) {
+        free(content);
+        return SNAPSHOT_OUT_OF_MEMORY;
+    }
+    new_reader->content = content;
+    new_reader->length = body_length;
+    new_reader->position = SNAPSHOT_HEADER_SIZE;
+    new_reader->failed = false;
+    *reader = new_reader;
+    return SNAPSHOT_SUCCESS;
+}
+
+void snapshotReaderDestroy(SnapshotReader reader)
+{
+    if(reader == NULL) {
+        return;
+    }
+    free(reader->content);
+    free(reader);
+}
+
+int snapshotReadInt(SnapshotReader reader)
+{
+    const unsigned char* bytes = snapshotTake(reader, INT_SIZE);
+    if(bytes == NULL) {
+        return 0;
+    }
+    return (int)(uint32_t)snapshotDecodeUnsigned(bytes, INT_SIZE);
+}
+
+double snapshotReadDouble(SnapshotReader reader)
+{
+    const unsigned char* bytes = snapshotTake(reader, DOUBLE_SIZE);
+    if(bytes == NULL) {
+        return 0;
+    }
+    uint64_t bits = snapshotDecodeUnsigned(bytes, DOUBLE_SIZE);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+const char* snapshotReadString(SnapshotReader reader)
+{
+    int length = snapshotReadInt(reader);
+    if(length < 0) {
+        snapshotReaderReject(reader);
+        return NULL;
+    }
+    const unsigned char* bytes = snapshotTake(reader, (size_t)length + 1);
+    if(bytes == NULL || bytes[length] != '\0') {
+        snapshotReaderReject(reader);
+        return NULL;
+    }
+    return (const char*)bytes;
+}
+
+int snapshotReadCount(SnapshotReader reader, int record_size)
+{
+    assert(reader != NULL && record_size > 0);
+    int count = snapshotReadInt(reader);
+    if(count < 0 || (size_t)count > (reader->length - reader->position) / record_size) {
+        snapshotReaderReject(reader);
+        return 0;
+    }
+    return count;
+}
+
+void snapshotReaderReject(SnapshotReader reader)
+{
+    assert(reader != NULL);
+    reader->failed = true;
+}
+
+bool snapshotReaderFailed(SnapshotReader reader)
+{
+    assert(reader != NULL);
+    return reader->failed;
+}
+
+static void snapshotFlush(SnapshotWriter writer)
+{
+    if(writer->length == 0) {
+        return;
+    }
+    if(fwrite(writer->buffer, 1, writer->length, writer->file) != writer->length) {
+        writer->failed = true;
+    }
+    writer->length = 0;
+}
+
+static void snapshotWriteBytes(SnapshotWriter writer, const unsigned char* bytes, size_t length)
+{
+    assert(writer != NULL);
+    writer->checksum = binaryFileChecksum(writer->checksum, FNV_64_PRIME, bytes, length);
+    while(length > 0)
+    {
+        if(writer->length == SNAPSHOT_BUFFER_SIZE) {
+            snapshotFlush(writer);
+        }
+        size_t part = SNAPSHOT_BUFFER_SIZE - writer->length;
+        if(part > length) {
+            part = length;
+        }
+        memcpy(writer->buffer + writer->length, bytes, part);
+        writer->length += part;
+        bytes += part;
+        length -= part;
+    }
+}
+
+static void snapshotWriteUnsigned(SnapshotWriter writer, uint64_t value, int size)
+{
+    unsigned char bytes[DOUBLE_SIZE];
+    for(int i = 0; i < size; i++) {
+        bytes[i] = (unsigned char)((value >> (i * BITS_IN_BYTE)) & BYTE_MASK);
+    }
+    snapshotWriteBytes(writer, bytes, size);
+}
+
+static uint64_t snapshotDecodeUnsigned(const unsigned char* bytes, int size)
+{
+    uint64_t value = 0;
+    for(int i = 0; i < size; i++) {
+        value |= (uint64_t)bytes[i] << (i * BITS_IN_BYTE);
+    }
+    return value;
+}
+
+static const unsigned char* snapshotTake(SnapshotReader reader, size_t length)
+{
+    assert(reader != NULL);
+    if(reader->failed || length > reader->length - reader->position) {
+        reader->failed = true;
+        return NULL;
+    }
+    const unsigned char* bytes = reader->content + reader->position;
+    reader->position += length;
+    return bytes;
+}
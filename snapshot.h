@@ -0,0 +1,114 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+
+typedef struct snapshot_writer_t *SnapshotWriter;
+typedef struct snapshot_reader_t *SnapshotReader;
+
+/** Type used for returning error codes from snapshot functions */
+typedef enum SnapshotResult_t {
+    SNAPSHOT_SUCCESS,
+    SNAPSHOT_OUT_OF_MEMORY,
+    SNAPSHOT_FILE_ERROR,
+    SNAPSHOT_BAD_FORMAT
+} SnapshotResult;
+
+/**
+* snapshotWriterCreate: open a snapshot file for writing and write its header.
+* the values are stored little endian with a fixed size, so the file does not depend on the machine,
+* and a checksum of the whole file is added when the writer is closed.
+*
+* @param path - the path of the file, it is truncated if it exists.
+* @return
+* 	NULL - a NULL path was sent, the file could not be opened or allocation failed.
+* 	pointer to the writer - otherwise.
+*/
+SnapshotWriter snapshotWriterCreate(const char* path);
+
+/**
+* snapshotWriterClose: write the checksum, close the file and deallocate the writer.
+*
+* @param writer - the writer to close.
+* @return
+* 	SNAPSHOT_FILE_ERROR - one of the writes (or the close) failed, the file is not a valid snapshot.
+* 	SNAPSHOT_SUCCESS - otherwise.
+*/
+SnapshotResult snapshotWriterClose(SnapshotWriter writer);
+
+/**
+* snapshotWriteInt / snapshotWriteDouble / snapshotWriteString: append a value to the snapshot.
+* a failure is remembered by the writer and reported by snapshotWriterClose.
+*
+* @param writer - the writer.
+* @param value - the value to append. a string is stored with its length.
+*/
+void snapshotWriteInt(SnapshotWriter writer, int value);
+void snapshotWriteDouble(SnapshotWriter writer, double value);
+void snapshotWriteString(SnapshotWriter writer, const char* value);
+
+/**
+* snapshotReaderCreate: read a whole snapshot file into memory and check its header and checksum,
+* so the values are read only from a file that is known to be complete.
+*
+* @param path - the path of the file.
+* @param reader - a pointer where to put the new reader.
+* @return
+* 	SNAPSHOT_FILE_ERROR - a NULL argument was sent or the file could not be read.
+* 	SNAPSHOT_BAD_FORMAT - the file is not a snapshot of this version, or its checksum is wrong.
+* 	SNAPSHOT_OUT_OF_MEMORY - allocation failed.
+* 	SNAPSHOT_SUCCESS - otherwise.
+*/
+SnapshotResult snapshotReaderCreate(const char* path, SnapshotReader* reader);
+
+/**
+* snapshotReaderDestroy: deallocate the reader and the content of the file.
+* the strings that were read are not valid after it is destroyed.
+*
+* @param reader - the reader to destroy.
+*/
+void snapshotReaderDestroy(SnapshotReader reader);
+
+/**
+* snapshotReadInt / snapshotReadDouble / snapshotReadString: read the next value of the snapshot.
+* reading past the end fails the reader and returns 0 (or NULL), so a loop over the values
+* does not need to check every read.
+*
+* @param reader - the reader.
+* @return
+* 	the value. a string points into the reader and is valid until it is destroyed.
+*/
+int snapshotReadInt(SnapshotReader reader);
+double snapshotReadDouble(SnapshotReader reader);
+const char* snapshotReadString(SnapshotReader reader);
+
+/**
+* snapshotReadCount: read the number of records that follow, and check that the rest of
+* the snapshot is long enough for them.
+*
+* @param reader - the reader.
+* @param record_size - the minimal number of bytes of a record.
+* @return
+* 	0 - the count is negative or too large, the reader is failed.
+* 	the count - otherwise.
+*/
+int snapshotReadCount(SnapshotReader reader, int record_size);
+
+/**
+* snapshotReaderReject: fail the reader, for a value that was read but is not valid.
+*
+* @param reader - the reader.
+*/
+void snapshotReaderReject(SnapshotReader reader);
+
+/**
+* snapshotReaderFailed: check if one of the reads has failed or was rejected.
+*
+* @param reader - the reader.
+* @return
+* 	true - a read failed.
+* 	false - all the reads succeeded.
+*/
+bool snapshotReaderFailed(SnapshotReader reader);
+
+#endif //SNAPSHOT_H
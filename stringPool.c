@@ -0,0 +1,155 @@
+#include "stringPool.h"
+#include "map.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define NO_REFERENCES 0
+
+struct string_pool_t
+{
+    Map strings;
+};
+
+/* the data of a string in the pool: the string itself, and the number of its handles */
+typedef struct interned_t
+{
+    int references;
+    char string[];
+} *Interned;
+
+/* copy and free a string key of the pool */
+static MapKeyElement copyStringKey(MapKeyElement key);
+static void freeStringKey(MapKeyElement key);
+
+/* compare 2 string keys */
+static int compareStringKey(MapKeyElement key1, MapKeyElement key2);
+
+/* create a data of the pool for the string, with no references */
+static Interned createInterned(const char* string);
+
+/* copy and free a data of the pool */
+static MapDataElement copyInterned(MapDataElement interned);
+static void freeInterned(MapDataElement interned);
+
+StringPool stringPoolCreate()
+{
+    StringPool pool = malloc(sizeof(*pool));
+    if(pool == NULL) {
+        return NULL;
+    }
+    pool->strings = mapCreate(copyInterned, copyStringKey, freeInterned, freeStringKey, compareStringKey);
+    if(pool->strings == NULL) {
+        free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void stringPoolDestroy(StringPool pool)
+{
+    if(pool == NULL) {
+        return;
+    }
+    mapDestroy(pool->strings);
+    free(pool);
+}
+
+InternedString stringPoolIntern(StringPool pool, const char* string)
+{
+    if(pool == NULL || string == NULL) {
+        return NULL;
+    }
+    Interned interned = mapGet(pool->strings, (MapKeyElement)string);
+    if(interned == NULL)
+    {
+        Interned new_interned = createInterned(string);
+        if(new_interned == NULL) {
+            return NULL;
+        }
+        MapResult result = mapPut(pool->strings, (MapKeyElement)string, new_interned);
+        freeInterned(new_interned);
+        if(result != MAP_SUCCESS) {
+            return NULL;
+        }
+        interned = mapGet(pool->strings, (MapKeyElement)string);
+        assert(interned != NULL);
+    }
+    interned->references++;
+    return interned->string;
+}
+
+void stringPoolRelease(StringPool pool, InternedString string)
+{
+    if(pool == NULL || string == NULL) {
+        return;
+    }
+    Interned interned = mapGet(pool->strings, (MapKeyElement)string);
+    assert(interned != NULL && interned->string == string);
+    interned->references--;
+    if(interned->references == NO_REFERENCES) {
+        mapRemove(pool->strings, (MapKeyElement)string);
+    }
+}
+
+int stringPoolGetSize(StringPool pool)
+{
+    if(pool == NULL) {
+        return -1;
+    }
+    return mapGetSize(pool->strings);
+}
+
+static MapKeyElement copyStringKey(MapKeyElement key)
+{
+    if(key == NULL) {
+        return NULL;
+    }
+    char* copy = malloc(strlen(key) + 1);
+    if(copy == NULL) {
+        return NULL;
+    }
+    strcpy(copy, key);
+    return copy;
+}
+
+static void freeStringKey(MapKeyElement key)
+{
+    free(key);
+}
+
+static int compareStringKey(MapKeyElement key1, MapKeyElement key2)
+{
+    assert(key1 != NULL && key2 != NULL);
+    return strcmp(key1, key2);
+}
+
+static Interned createInterned(const char* string)
+{
+    assert(string != NULL);
+    Interned interned = malloc(sizeof(*interned) + strlen(string) + 1);
+    if(interned == NULL) {
+        return NULL;
+    }
+    interned->references = NO_REFERENCES;
+    strcpy(interned->string, string);
+    return interned;
+}
+
+static MapDataElement copyInterned(MapDataElement interned)
+{
+    if(interned == NULL) {
+        return NULL;
+    }
+    Interned copy = createInterned(((Interned)interned)->string);
+    if(copy == NULL) {
+        return NULL;
+    }
+    copy->references = ((Interned)interned)->references;
+    return copy;
+}
+
+static void freeInterned(MapDataElement interned)
+{
+    free(interned);
+}
@@ -0,0 +1,60 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <stdbool.h>
+
+typedef struct string_pool_t *StringPool;
+
+/** A string that is stored once in a pool. two handles of the same pool are equal
+ * (as pointers) if and only if their strings are equal */
+typedef const char* InternedString;
+
+/**
+* stringPoolCreate: create a new empty pool of strings.
+*
+* @return
+* 	NULL - allocation failed.
+* 	pointer to the pool - otherwise.
+*/
+StringPool stringPoolCreate();
+
+/**
+* stringPoolDestroy: deallocate the pool and all its strings.
+* the handles of the pool are not valid after it is destroyed.
+*
+* @param pool - pointer to the pool.
+*/
+void stringPoolDestroy(StringPool pool);
+
+/**
+* stringPoolIntern: get the handle of a string, and store the string if it is not in the pool yet.
+* every intern of a string must be matched by a release of its handle.
+*
+* @param pool - pointer to the pool.
+* @param string - the string to intern.
+* @return
+* 	NULL - a NULL argument was sent or allocation failed.
+* 	the handle of the string - otherwise.
+*/
+InternedString stringPoolIntern(StringPool pool, const char* string);
+
+/**
+* stringPoolRelease: release a handle that was returned by stringPoolIntern.
+* the string is deallocated when its last handle is released.
+*
+* @param pool - pointer to the pool.
+* @param string - the handle to release.
+*/
+void stringPoolRelease(StringPool pool, InternedString string);
+
+/**
+* stringPoolGetSize: return the number of different strings in the pool.
+*
+* @param pool - pointer to the pool.
+* @return
+* 	-1 - a NULL pool was sent.
+* 	the number of strings - otherwise.
+*/
+int stringPoolGetSize(StringPool pool);
+
+#endif //STRING_POOL_H
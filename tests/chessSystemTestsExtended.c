@@ -0,0 +1,1097 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "../chessSystem.h"
+#include "../chessSystemExtended.h"
+
+#define ASSERT_TEST(expr)                                                         \
+     do {                                                                          \
+         if (!(expr)) {                                                            \
+             printf("\nAssertion failed at %s:%d %s ", __FILE__, __LINE__, #expr); \
+             return false;                                                         \
+         }                                                                         \
+     } while (0)
+
+#define RUN_TEST(test, name)                  \
+    do {                                      \
+        if (test()) {                         \
+            printf("[OK] %s\n", name);        \
+        } else {                              \
+            printf("[Failed] %s\n", name);    \
+            failed_tests++;                   \
+        }                                     \
+    } while (0)
+
+/*The number of tests*/
+#define NUMBER_TESTS 17
+
+#define SNAPSHOT_PATH "chessTestsSnapshot.bin"
+#define LOG_PATH "chessTestsLog.bin"
+#define TORN_LOG_PATH "chessTestsTornLog.bin"
+#define SAMPLE_LOG_RECORDS 12
+#define FEED_PATH "chessTestsFeed.txt"
+#define MAX_INGEST_ERRORS 16
+#define LARGE_FEED_LINES 10000
+#define LARGE_FEED_TOURNAMENTS 8
+#define LARGE_FEED_REPEAT 7
+#define DELTA_PATH "chessTestsDelta.txt"
+#define STATISTICS_BLOCK_LINES 6
+#define MAX_DELTA_TOURNAMENTS 8
+#define MAX_LEVEL_LINE 64
+#define CONCURRENT_THREADS 8
+#define CONCURRENT_TOURNAMENTS 32
+#define CONCURRENT_PLAYERS 24
+#define LARGE_END_BATCH 150
+#define ASYNC_LEVELS_PATH "chessTestsAsyncLevels.txt"
+#define TRACE_PATH "chessTestsTrace.bin"
+#define MISSING_FEED_PATH "chessTestsMissingFeed.txt"
+#define REPLAY_REPORT_PATH "chessTestsReplay.txt"
+#define REPLAY_COMMAND "./chessReplay -o chessTestsReplay.out " TRACE_PATH " > " REPLAY_REPORT_PATH
+#define EVENT_VIEW_PLAYERS 8
+#define STATISTICS_PATH "chessTestsStatistics.txt"
+#define OTHER_STATISTICS_PATH "chessTestsOtherStatistics.txt"
+
+/* read a whole file into a new string, NULL if it could not be read. the caller frees it */
+static char* readFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t capacity = 256, length = 0;
+    char* content = malloc(capacity);
+    while (content != NULL) {
+        length += fread(content + length, 1, capacity - length - 1, file);
+        if (length < capacity - 1) {
+            break;
+        }
+        char* larger = realloc(content, capacity * 2);
+        if (larger == NULL) {
+            free(content);
+        }
+        content = larger;
+        capacity *= 2;
+    }
+    fclose(file);
+    if (content != NULL) {
+        content[length] = '\0';
+    }
+    return content;
+}
+
+/* the output of chessSavePlayersLevels as a new string */
+static char* levelsOf(ChessSystem chess)
+{
+    FILE* file = fopen(STATISTICS_PATH, "w");
+    if (file == NULL) {
+        return NULL;
+    }
+    ChessResult result = chessSavePlayersLevels(chess, file);
+    fclose(file);
+    return result == CHESS_SUCCESS ? readFile(STATISTICS_PATH) : NULL;
+}
+
+/* the output of chessSaveTournamentStatistics as a new string, empty if no tournament ended */
+static char* statisticsOf(ChessSystem chess, const char* path)
+{
+    ChessResult result = chessSaveTournamentStatistics(chess, (char*)path);
+    if (result == CHESS_NO_TOURNAMENTS_ENDED) {
+        char* empty = malloc(1);
+        if (empty != NULL) {
+            empty[0] = '\0';
+        }
+        return empty;
+    }
+    return result == CHESS_SUCCESS ? readFile(path) : NULL;
+}
+
+/* check that two systems print the same levels and statistics */
+static bool sameOutputs(ChessSystem chess1, ChessSystem chess2)
+{
+    char* levels1 = levelsOf(chess1);
+    char* levels2 = levelsOf(chess2);
+    char* statistics1 = statisticsOf(chess1, STATISTICS_PATH);
+    char* statistics2 = statisticsOf(chess2, OTHER_STATISTICS_PATH);
+    bool same = levels1 != NULL && levels2 != NULL && statistics1 != NULL && statistics2 != NULL &&
+                strcmp(levels1, levels2) == 0 && strcmp(statistics1, statistics2) == 0;
+    free(levels1);
+    free(levels2);
+    free(statistics1);
+    free(statistics2);
+    remove(STATISTICS_PATH);
+    remove(OTHER_STATISTICS_PATH);
+    return same;
+}
+
+/* apply the calls of the sample system: an ended tournament, an open one, a removed tournament
+ * and, if with_player_removal is true, a removed player at the end */
+static void addSampleCalls(ChessSystem chess, bool with_player_removal)
+{
+    chessAddTournament(chess, 1, 4, "London");
+    chessAddTournament(chess, 2, 5, "Tel aviv");
+    chessAddTournament(chess, 3, 2, "London");
+    chessAddGame(chess, 1, 1, 2, FIRST_PLAYER, 2000);
+    chessAddGame(chess, 1, 1, 3, DRAW, 1500);
+    chessAddGame(chess, 1, 2, 4, SECOND_PLAYER, 700);
+    chessAddGame(chess, 2, 1, 5, SECOND_PLAYER, 3000);
+    chessAddGame(chess, 2, 3, 6, DRAW, 1200);
+    chessAddGame(chess, 3, 7, 8, FIRST_PLAYER, 100);
+    chessEndTournament(chess, 1);
+    chessRemoveTournament(chess, 3);
+    if (with_player_removal) {
+        chessRemovePlayer(chess, 6);
+    }
+}
+
+/* a new system with all the calls of the sample */
+static ChessSystem createSampleSystem()
+{
+    ChessSystem chess = chessCreate();
+    if (chess != NULL) {
+        addSampleCalls(chess, true);
+    }
+    return chess;
+}
+
+bool testChessSnapshotRoundTrip() {
+    ChessSystem chess = createSampleSystem();
+    ASSERT_TEST(chess != NULL);
+    ASSERT_TEST(chessSaveSnapshot(chess, SNAPSHOT_PATH) == CHESS_SUCCESS);
+    ChessResult result = CHESS_OUT_OF_MEMORY;
+    ChessSystem loaded = chessLoadSnapshot(SNAPSHOT_PATH, &result);
+    ASSERT_TEST(result == CHESS_SUCCESS && loaded != NULL);
+    ASSERT_TEST(sameOutputs(chess, loaded));
+    ChessResult average_result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(loaded, 1, &average_result) ==
+                chessCalculateAveragePlayTime(chess, 1, &average_result));
+    // the loaded system keeps the flags of its tournaments and the games that exist
+    ASSERT_TEST(chessAddGame(loaded, 1, 2, 3, DRAW, 10) == CHESS_TOURNAMENT_ENDED);
+    ASSERT_TEST(chessAddGame(loaded, 2, 1, 5, DRAW, 10) == CHESS_GAME_ALREADY_EXISTS);
+    ASSERT_TEST(chessAddTournament(loaded, 3, 2, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 3, 2, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(loaded, 2, 1, 3, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 1, 3, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(loaded, 2) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(chess, 2) == CHESS_SUCCESS);
+    ASSERT_TEST(sameOutputs(chess, loaded));
+    chessDestroy(loaded);
+    chessDestroy(chess);
+    remove(SNAPSHOT_PATH);
+    return true;
+}
+
+bool testChessSnapshotCorrupted() {
+    ChessSystem chess = createSampleSystem();
+    ASSERT_TEST(chess != NULL);
+    ASSERT_TEST(chessSaveSnapshot(chess, SNAPSHOT_PATH) == CHESS_SUCCESS);
+    chessDestroy(chess);
+    FILE* file = fopen(SNAPSHOT_PATH, "r+b");
+    ASSERT_TEST(file != NULL);
+    ASSERT_TEST(fseek(file, -5, SEEK_END) == 0);
+    int byte = fgetc(file);
+    ASSERT_TEST(byte != EOF && fseek(file, -5, SEEK_END) == 0);
+    fputc(byte ^ 0x40, file);
+    fclose(file);
+    ChessResult result = CHESS_SUCCESS;
+    ASSERT_TEST(chessLoadSnapshot(SNAPSHOT_PATH, &result) == NULL);
+    ASSERT_TEST(result == CHESS_SAVE_FAILURE);
+    remove(SNAPSHOT_PATH);
+    ASSERT_TEST(chessLoadSnapshot(SNAPSHOT_PATH, &result) == NULL);
+    ASSERT_TEST(result == CHESS_SAVE_FAILURE);
+    return true;
+}
+
+/* write the sample calls to a new log, and return the system that logged them */
+static ChessSystem createLoggedSampleSystem()
+{
+    remove(LOG_PATH);
+    ChessSystem chess = chessCreate();
+    if (chess == NULL) {
+        return NULL;
+    }
+    if (chessEnableLog(chess, LOG_PATH) != CHESS_SUCCESS) {
+        chessDestroy(chess);
+        return NULL;
+    }
+    addSampleCalls(chess, true);
+    // failed calls are not logged
+    chessAddGame(chess, 1, 1, 2, DRAW, 10);
+    chessRemovePlayer(chess, 99);
+    if (chessSyncLog(chess) != CHESS_SUCCESS) {
+        chessDestroy(chess);
+        return NULL;
+    }
+    return chess;
+}
+
+bool testChessLogReplay() {
+    ChessSystem chess = createLoggedSampleSystem();
+    ASSERT_TEST(chess != NULL);
+    ChessSystem replayed = chessCreate();
+    int num_of_records = 0;
+    ASSERT_TEST(chessReplayLog(replayed, LOG_PATH, &num_of_records) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_records == SAMPLE_LOG_RECORDS);
+    ASSERT_TEST(sameOutputs(chess, replayed));
+    chessDestroy(replayed);
+    chessDestroy(chess);
+    remove(LOG_PATH);
+    // a log that was never written is empty
+    replayed = chessCreate();
+    ASSERT_TEST(chessReplayLog(replayed, LOG_PATH, &num_of_records) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_records == 0);
+    chessDestroy(replayed);
+    return true;
+}
+
+bool testChessLogReplayTornTail() {
+    ChessSystem chess = createLoggedSampleSystem();
+    ASSERT_TEST(chess != NULL);
+    chessDestroy(chess);
+    // a crash in the middle of the last record leaves a part of it at the end of the file
+    FILE* log = fopen(LOG_PATH, "rb");
+    FILE* torn_log = fopen(TORN_LOG_PATH, "wb");
+    ASSERT_TEST(log != NULL && torn_log != NULL);
+    ASSERT_TEST(fseek(log, 0, SEEK_END) == 0);
+    long length = ftell(log);
+    rewind(log);
+    for (long i = 0; i < length - 1; i++) {
+        fputc(fgetc(log), torn_log);
+    }
+    fclose(log);
+    fclose(torn_log);
+    ChessSystem replayed = chessCreate();
+    int num_of_records = 0;
+    ASSERT_TEST(chessReplayLog(replayed, TORN_LOG_PATH, &num_of_records) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_records == SAMPLE_LOG_RECORDS - 1);
+    ChessSystem expected = chessCreate();
+    addSampleCalls(expected, false);
+    ASSERT_TEST(sameOutputs(expected, replayed));
+    chessDestroy(expected);
+    // the recovered system logs on after the last complete record
+    ASSERT_TEST(chessEnableLog(replayed, TORN_LOG_PATH) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(replayed, 6) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSyncLog(replayed) == CHESS_SUCCESS);
+    ChessSystem recovered = chessCreate();
+    ASSERT_TEST(chessReplayLog(recovered, TORN_LOG_PATH, &num_of_records) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_records == SAMPLE_LOG_RECORDS);
+    ASSERT_TEST(sameOutputs(recovered, replayed));
+    chessDestroy(recovered);
+    chessDestroy(replayed);
+    remove(LOG_PATH);
+    remove(TORN_LOG_PATH);
+    return true;
+}
+
+/* the lines that chessIngestFile did not add, in the order it reported them */
+typedef struct ingest_errors_t {
+    int num_of_errors;
+    int line_numbers[MAX_INGEST_ERRORS];
+    ChessResult results[MAX_INGEST_ERRORS];
+} IngestErrors;
+
+static void collectIngestError(int line_number, ChessResult result, void* context)
+{
+    IngestErrors* errors = context;
+    if (errors->num_of_errors < MAX_INGEST_ERRORS) {
+        errors->line_numbers[errors->num_of_errors] = line_number;
+        errors->results[errors->num_of_errors] = result;
+    }
+    errors->num_of_errors++;
+}
+
+bool testChessIngestFile() {
+    FILE* feed = fopen(FEED_PATH, "w");
+    ASSERT_TEST(feed != NULL);
+    fputs("# tournament first second winner time\n"
+          "1 1 2 1 100\n"
+          "\n"
+          "1,1,3,0,50\n"
+          "1 1 2 2 10\n"
+          "9 1 2 1 10\n"
+          "1 4 5 6 10\n"
+          "1 4 5 4\n"
+          "1 4 5 4 -3\n"
+          "1 a 5 4 3\n"
+          "1\t4\t5\t5\t30\n"
+          "2 1 4 4 20\n"
+          "2 2 3 0 0", feed);
+    fclose(feed);
+    const int expected_lines[] = {5, 6, 7, 8, 9, 10};
+    const ChessResult expected_results[] = {CHESS_GAME_ALREADY_EXISTS, CHESS_TOURNAMENT_NOT_EXIST, CHESS_INVALID_ID,
+                                            CHESS_INVALID_ID, CHESS_INVALID_PLAY_TIME, CHESS_INVALID_ID};
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chessAddTournament(chess, 1, 4, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 2, 4, "Paris") == CHESS_SUCCESS);
+    IngestErrors errors = {0};
+    int num_of_games = 0;
+    ASSERT_TEST(chessIngestFile(chess, FEED_PATH, collectIngestError, &errors, &num_of_games) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_games == 5);
+    ASSERT_TEST(errors.num_of_errors == 6);
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TEST(errors.line_numbers[i] == expected_lines[i] && errors.results[i] == expected_results[i]);
+    }
+    ChessSystem expected = chessCreate();
+    chessAddTournament(expected, 1, 4, "London");
+    chessAddTournament(expected, 2, 4, "Paris");
+    chessAddGame(expected, 1, 1, 2, FIRST_PLAYER, 100);
+    chessAddGame(expected, 1, 1, 3, DRAW, 50);
+    chessAddGame(expected, 1, 4, 5, SECOND_PLAYER, 30);
+    chessAddGame(expected, 2, 1, 4, SECOND_PLAYER, 20);
+    chessAddGame(expected, 2, 2, 3, DRAW, 0);
+    ASSERT_TEST(chessEndTournament(chess, 1) == CHESS_SUCCESS && chessEndTournament(expected, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(sameOutputs(chess, expected));
+    remove(FEED_PATH);
+    ASSERT_TEST(chessIngestFile(chess, FEED_PATH, NULL, NULL, &num_of_games) == CHESS_SAVE_FAILURE);
+    chessDestroy(expected);
+    chessDestroy(chess);
+    return true;
+}
+
+/* checks that every repeated line is reported, in the order of the file (the context is the last line) */
+static void checkIngestOrder(int line_number, ChessResult result, void* context)
+{
+    int* previous_line = context;
+    if (result != CHESS_GAME_ALREADY_EXISTS || line_number != *previous_line + LARGE_FEED_REPEAT) {
+        *previous_line = LARGE_FEED_LINES + 1;
+        return;
+    }
+    *previous_line = line_number;
+}
+
+bool testChessIngestFileBatches() {
+    FILE* feed = fopen(FEED_PATH, "w");
+    ASSERT_TEST(feed != NULL);
+    ChessSystem expected = chessCreate();
+    ChessSystem chess = chessCreate();
+    for (int tournament = 1; tournament <= LARGE_FEED_TOURNAMENTS; tournament++) {
+        chessAddTournament(expected, tournament, LARGE_FEED_LINES, "London");
+        chessAddTournament(chess, tournament, LARGE_FEED_LINES, "London");
+    }
+    // every few lines repeat the game of the line before, which is not added again
+    int num_of_added = 0, game = 0;
+    for (int line = 1; line <= LARGE_FEED_LINES; line++) {
+        if (line % LARGE_FEED_REPEAT != 0) {
+            game++;
+            num_of_added++;
+        }
+        int tournament = game % LARGE_FEED_TOURNAMENTS + 1;
+        int first = game % 100 + 1, second = game / 100 + 101;
+        fprintf(feed, "%d %d %d %d %d\n", tournament, first, second, game % 3 == 0 ? 0 : first, game % 50);
+        chessAddGame(expected, tournament, first, second, game % 3 == 0 ? DRAW : FIRST_PLAYER, game % 50);
+    }
+    fclose(feed);
+    int previous_line = 0, num_of_games = 0;
+    ASSERT_TEST(chessIngestFile(chess, FEED_PATH, checkIngestOrder, &previous_line, &num_of_games) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_games == num_of_added);
+    ASSERT_TEST(previous_line == LARGE_FEED_LINES / LARGE_FEED_REPEAT * LARGE_FEED_REPEAT);
+    for (int tournament = 1; tournament <= LARGE_FEED_TOURNAMENTS; tournament += 2) {
+        ASSERT_TEST(chessEndTournament(chess, tournament) == CHESS_SUCCESS);
+        ASSERT_TEST(chessEndTournament(expected, tournament) == CHESS_SUCCESS);
+    }
+    ASSERT_TEST(sameOutputs(chess, expected));
+    chessDestroy(expected);
+    chessDestroy(chess);
+    remove(FEED_PATH);
+    return true;
+}
+
+/* split a statistics delta into the ids of its tournaments and their blocks (as a new string, in the format
+ * of chessSaveTournamentStatistics). returns the number of tournaments, -1 if the file could not be read */
+static int splitStatisticsDelta(const char* path, int* ids, char** blocks)
+{
+    char* content = readFile(path);
+    if (content == NULL) {
+        *blocks = NULL;
+        return -1;
+    }
+    *blocks = malloc(strlen(content) + 1);
+    if (*blocks == NULL) {
+        free(content);
+        return -1;
+    }
+    char* next_block = *blocks;
+    int num_of_tournaments = 0, line = 0;
+    for (char* start = content; *start != '\0'; line++) {
+        char* end = strchr(start, '\n');
+        size_t length = end == NULL ? strlen(start) : (size_t)(end - start + 1);
+        if (line % (STATISTICS_BLOCK_LINES + 1) == 0) {
+            if (num_of_tournaments < MAX_DELTA_TOURNAMENTS) {
+                ids[num_of_tournaments] = atoi(start);
+            }
+            num_of_tournaments++;
+        } else {
+            memcpy(next_block, start, length);
+            next_block += length;
+        }
+        start += length;
+    }
+    *next_block = '\0';
+    free(content);
+    return num_of_tournaments;
+}
+
+bool testChessTournamentStatisticsDelta() {
+    remove(DELTA_PATH);
+    ChessSystem chess = createSampleSystem();
+    int num_of_tournaments = -1, ids[MAX_DELTA_TOURNAMENTS];
+    char* blocks = NULL;
+    ASSERT_TEST(chessAddTournament(chess, 3, 2, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 3, 7, 8, DRAW, 60) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSaveTournamentStatisticsDelta(chess, DELTA_PATH, &num_of_tournaments) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_tournaments == 1);
+    ASSERT_TEST(splitStatisticsDelta(DELTA_PATH, ids, &blocks) == 1 && ids[0] == 1);
+    char* statistics = statisticsOf(chess, STATISTICS_PATH);
+    ASSERT_TEST(statistics != NULL && strcmp(blocks, statistics) == 0);
+    free(blocks);
+    free(statistics);
+    // nothing changed, so nothing is appended
+    ASSERT_TEST(chessSaveTournamentStatisticsDelta(chess, DELTA_PATH, &num_of_tournaments) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_tournaments == 0);
+    ASSERT_TEST(splitStatisticsDelta(DELTA_PATH, ids, &blocks) == 1);
+    free(blocks);
+    // the tournaments that end are appended, and together they hold the blocks of the full export
+    ChessResult results[2];
+    ASSERT_TEST(chessEndTournaments(chess, (int[]){3, 2}, 2, results) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSaveTournamentStatisticsDelta(chess, DELTA_PATH, &num_of_tournaments) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_tournaments == 2);
+    ASSERT_TEST(splitStatisticsDelta(DELTA_PATH, ids, &blocks) == 3 && ids[1] == 2 && ids[2] == 3);
+    statistics = statisticsOf(chess, STATISTICS_PATH);
+    ASSERT_TEST(statistics != NULL && strcmp(blocks, statistics) == 0);
+    free(blocks);
+    free(statistics);
+    // a removed player changes the ended tournaments it played in, a removed tournament is not reported
+    remove(DELTA_PATH);
+    ASSERT_TEST(chessRemovePlayer(chess, 2) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemoveTournament(chess, 3) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSaveTournamentStatisticsDelta(chess, DELTA_PATH, &num_of_tournaments) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_tournaments == 1);
+    ASSERT_TEST(splitStatisticsDelta(DELTA_PATH, ids, &blocks) == 1 && ids[0] == 1);
+    ChessSystem loaded = NULL;
+    ChessResult result;
+    ASSERT_TEST(chessSaveSnapshot(chess, SNAPSHOT_PATH) == CHESS_SUCCESS);
+    ASSERT_TEST((loaded = chessLoadSnapshot(SNAPSHOT_PATH, &result)) != NULL);
+    statistics = statisticsOf(chess, STATISTICS_PATH);
+    ASSERT_TEST(statistics != NULL && strncmp(blocks, statistics, strlen(blocks)) == 0);
+    free(blocks);
+    free(statistics);
+    // a loaded system writes all its ended tournaments first
+    remove(DELTA_PATH);
+    ASSERT_TEST(chessSaveTournamentStatisticsDelta(loaded, DELTA_PATH, &num_of_tournaments) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_tournaments == 2);
+    ASSERT_TEST(splitStatisticsDelta(DELTA_PATH, ids, &blocks) == 2 && ids[0] == 1 && ids[1] == 2);
+    statistics = statisticsOf(chess, STATISTICS_PATH);
+    ASSERT_TEST(statistics != NULL && strcmp(blocks, statistics) == 0);
+    free(blocks);
+    free(statistics);
+    chessDestroy(loaded);
+    chessDestroy(chess);
+    remove(SNAPSHOT_PATH);
+    remove(DELTA_PATH);
+    remove(STATISTICS_PATH);
+    return true;
+}
+
+/* the output of chessSavePlayersLevelsDelta as a new string */
+static char* levelsDeltaOf(ChessSystem chess, int* num_of_players)
+{
+    FILE* file = fopen(DELTA_PATH, "w");
+    if (file == NULL) {
+        return NULL;
+    }
+    ChessResult result = chessSavePlayersLevelsDelta(chess, file, num_of_players);
+    fclose(file);
+    return result == CHESS_SUCCESS ? readFile(DELTA_PATH) : NULL;
+}
+
+/* checks a levels delta against the full levels export: the ids are increasing, every "+" line holds the
+ * line of its rank there and every "-" id is not there. returns the number of "+" lines, -1 on a mismatch */
+static int checkLevelsDelta(const char* delta, const char* levels, int* num_of_removed)
+{
+    int num_of_added = 0, last_id = 0;
+    *num_of_removed = 0;
+    for (const char* start = delta; *start != '\0'; start = strchr(start, '\n') + 1) {
+        char sign;
+        int id, rank, offset;
+        if (sscanf(start, "%c %d%n", &sign, &id, &offset) != 2 || id <= last_id) {
+            return -1;
+        }
+        last_id = id;
+        char line[MAX_LEVEL_LINE];
+        if (sign == '-') {
+            sprintf(line, "%d ", id);
+            for (const char* row = levels; *row != '\0'; row = strchr(row, '\n') + 1) {
+                if (strncmp(row, line, strlen(line)) == 0) {
+                    return -1;
+                }
+            }
+            (*num_of_removed)++;
+            continue;
+        }
+        double level;
+        if (sign != '+' || sscanf(start + offset, "%lf %d", &level, &rank) != 2 || rank < 1) {
+            return -1;
+        }
+        const char* row = levels;
+        for (int i = 1; i < rank && *row != '\0'; i++) {
+            row = strchr(row, '\n') + 1;
+        }
+        sprintf(line, "%d %.2lf\n", id, level);
+        if (strncmp(row, line, strlen(line)) != 0) {
+            return -1;
+        }
+        num_of_added++;
+    }
+    return num_of_added;
+}
+
+static int countLines(const char* content)
+{
+    int lines = 0;
+    for (; *content != '\0'; content++) {
+        lines += *content == '\n';
+    }
+    return lines;
+}
+
+bool testChessPlayersLevelsDelta() {
+    ChessSystem chess = createSampleSystem();
+    int num_of_players = -1, num_of_removed = -1;
+    char* delta = levelsDeltaOf(chess, &num_of_players);
+    char* levels = levelsOf(chess);
+    ASSERT_TEST(delta != NULL && levels != NULL);
+    // every player of the new system changed
+    ASSERT_TEST(checkLevelsDelta(delta, levels, &num_of_removed) == countLines(levels));
+    ASSERT_TEST(num_of_players == countLines(delta) && num_of_players == countLines(levels) + num_of_removed);
+    free(delta);
+    delta = levelsDeltaOf(chess, &num_of_players);
+    ASSERT_TEST(delta != NULL && num_of_players == 0 && delta[0] == '\0');
+    free(delta);
+    free(levels);
+    // a game reports its players with their new ranks
+    ASSERT_TEST(chessAddGame(chess, 2, 4, 9, FIRST_PLAYER, 400) == CHESS_SUCCESS);
+    delta = levelsDeltaOf(chess, &num_of_players);
+    levels = levelsOf(chess);
+    ASSERT_TEST(delta != NULL && levels != NULL);
+    ASSERT_TEST(checkLevelsDelta(delta, levels, &num_of_removed) >= 2 && num_of_removed == 0);
+    ASSERT_TEST(strstr(delta, "+ 4 ") != NULL && strstr(delta, "+ 9 ") != NULL);
+    ASSERT_TEST(num_of_players == countLines(delta));
+    free(delta);
+    free(levels);
+    // a removed player is reported once
+    ASSERT_TEST(chessRemovePlayer(chess, 9) == CHESS_SUCCESS);
+    delta = levelsDeltaOf(chess, &num_of_players);
+    levels = levelsOf(chess);
+    ASSERT_TEST(delta != NULL && levels != NULL);
+    ASSERT_TEST(checkLevelsDelta(delta, levels, &num_of_removed) >= 0 && num_of_removed == 1);
+    ASSERT_TEST(strstr(delta, "- 9\n") != NULL && num_of_players == countLines(delta));
+    free(delta);
+    delta = levelsDeltaOf(chess, &num_of_players);
+    ASSERT_TEST(delta != NULL && num_of_players == 0);
+    free(delta);
+    // a loaded system prints all its players first, those without games as removed
+    ChessResult result;
+    ASSERT_TEST(chessSaveSnapshot(chess, SNAPSHOT_PATH) == CHESS_SUCCESS);
+    ChessSystem loaded = chessLoadSnapshot(SNAPSHOT_PATH, &result);
+    ASSERT_TEST(loaded != NULL);
+    delta = levelsDeltaOf(loaded, &num_of_players);
+    ASSERT_TEST(delta != NULL);
+    ASSERT_TEST(checkLevelsDelta(delta, levels, &num_of_removed) == countLines(levels));
+    ASSERT_TEST(num_of_players == countLines(levels) + num_of_removed && num_of_players == countLines(delta));
+    free(delta);
+    free(levels);
+    chessDestroy(loaded);
+    chessDestroy(chess);
+    remove(SNAPSHOT_PATH);
+    remove(DELTA_PATH);
+    remove(STATISTICS_PATH);
+    return true;
+}
+
+/* the games of one tournament of the concurrent test: most pairs of the shared players, so the tournaments
+ * of different threads keep adding games of the same players. returns the number of games that failed */
+static int addTournamentGames(ChessSystem chess, int tournament_id)
+{
+    int failures = 0;
+    for (int first = 1; first <= CONCURRENT_PLAYERS; first++) {
+        for (int second = first + 1; second <= CONCURRENT_PLAYERS; second++) {
+            if ((first + second + tournament_id) % 3 == 0) {
+                continue;
+            }
+            Winner winner = (Winner) ((first * second + tournament_id) % 3);
+            failures += chessAddGame(chess, tournament_id, first, second, winner,
+                                     (first + second) * tournament_id) != CHESS_SUCCESS;
+        }
+    }
+    return failures;
+}
+
+typedef struct ConcurrentGames_t {
+    ChessSystem chess;
+    int first_tournament;
+    int failures;
+} ConcurrentGames;
+
+static void* addConcurrentGames(void* games)
+{
+    ConcurrentGames* thread_games = games;
+    for (int id = thread_games->first_tournament; id <= CONCURRENT_TOURNAMENTS; id += CONCURRENT_THREADS) {
+        thread_games->failures += addTournamentGames(thread_games->chess, id);
+    }
+    return NULL;
+}
+
+static ChessSystem createConcurrentTournaments()
+{
+    ChessSystem chess = chessCreate();
+    for (int id = 1; chess != NULL && id <= CONCURRENT_TOURNAMENTS; id++) {
+        chessAddTournament(chess, id, CONCURRENT_PLAYERS, id % 2 == 0 ? "London" : "Paris");
+    }
+    return chess;
+}
+
+bool testChessAddGameConcurrent() {
+    ChessSystem concurrent = createConcurrentTournaments();
+    ChessSystem sequential = createConcurrentTournaments();
+    ASSERT_TEST(concurrent != NULL && sequential != NULL);
+    pthread_t threads[CONCURRENT_THREADS];
+    ConcurrentGames games[CONCURRENT_THREADS];
+    for (int i = 0; i < CONCURRENT_THREADS; i++) {
+        games[i] = (ConcurrentGames) {concurrent, i + 1, 0};
+        ASSERT_TEST(pthread_create(&threads[i], NULL, addConcurrentGames, &games[i]) == 0);
+    }
+    int failures = 0;
+    for (int i = 0; i < CONCURRENT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        failures += games[i].failures;
+    }
+    for (int id = 1; id <= CONCURRENT_TOURNAMENTS; id++) {
+        failures += addTournamentGames(sequential, id);
+    }
+    ASSERT_TEST(failures == 0);
+    // the order of the games does not change the results, so the outputs are the same as the sequential run
+    ASSERT_TEST(sameOutputs(concurrent, sequential));
+    for (int id = 1; id <= CONCURRENT_TOURNAMENTS; id++) {
+        ASSERT_TEST(chessEndTournament(concurrent, id) == CHESS_SUCCESS);
+        ASSERT_TEST(chessEndTournament(sequential, id) == CHESS_SUCCESS);
+    }
+    ASSERT_TEST(sameOutputs(concurrent, sequential));
+    ChessResult concurrent_result, sequential_result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(concurrent, 1, &concurrent_result) ==
+                chessCalculateAveragePlayTime(sequential, 1, &sequential_result));
+    ASSERT_TEST(concurrent_result == CHESS_SUCCESS && sequential_result == CHESS_SUCCESS);
+    chessDestroy(concurrent);
+    chessDestroy(sequential);
+    return true;
+}
+
+/* tournaments 1 to num_of_tournaments with games of overlapping players, except: every seventh has no games,
+ * every fifth has already ended and every eleventh was removed */
+static ChessSystem createEndTournamentsSystem(int num_of_tournaments)
+{
+    ChessSystem chess = chessCreate();
+    for (int id = 1; chess != NULL && id <= num_of_tournaments; id++) {
+        chessAddTournament(chess, id, 3, id % 3 == 0 ? "London" : "Tel aviv");
+        if (id % 7 == 0) {
+            continue;
+        }
+        chessAddGame(chess, id, id, id + 1, FIRST_PLAYER, id);
+        chessAddGame(chess, id, id + 1, id + 2, (Winner) (id % 3), 2 * id);
+        chessAddGame(chess, id, id, id + 2, (Winner) ((id + 1) % 3), 3 * id);
+        if (id % 5 == 0) {
+            chessEndTournament(chess, id);
+        }
+        if (id % 11 == 0) {
+            chessRemoveTournament(chess, id);
+        }
+    }
+    return chess;
+}
+
+/* ends a batch on one system and the same ids one by one on another, and checks that both agree */
+static bool sameAsEndingOneByOne(int num_of_tournaments, const int* ids, int num_of_ids)
+{
+    ChessSystem batch = createEndTournamentsSystem(num_of_tournaments);
+    ChessSystem one_by_one = createEndTournamentsSystem(num_of_tournaments);
+    ChessResult* results = malloc(num_of_ids * sizeof(*results));
+    bool same = batch != NULL && one_by_one != NULL && results != NULL &&
+                chessEndTournaments(batch, ids, num_of_ids, results) == CHESS_SUCCESS;
+    for (int i = 0; same && i < num_of_ids; i++) {
+        same = results[i] == chessEndTournament(one_by_one, ids[i]);
+    }
+    same = same && sameOutputs(batch, one_by_one);
+    free(results);
+    chessDestroy(batch);
+    chessDestroy(one_by_one);
+    return same;
+}
+
+bool testChessEndTournamentsBatch() {
+    // ended, no games, removed, missing and invalid ids, and ids that appear more than once
+    int ids[] = {2, 5, 7, 2, 11, 0, -4, 40, 3, 1, 3, 2};
+    ASSERT_TEST(sameAsEndingOneByOne(12, ids, sizeof(ids) / sizeof(*ids)));
+    ChessSystem chess = createEndTournamentsSystem(12);
+    ASSERT_TEST(chessEndTournaments(chess, NULL, 0, NULL) == CHESS_SUCCESS);
+    ChessResult result;
+    ASSERT_TEST(chessEndTournaments(chess, NULL, 1, &result) == CHESS_NULL_ARGUMENT);
+    ASSERT_TEST(chessEndTournaments(NULL, ids, 1, &result) == CHESS_NULL_ARGUMENT);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessEndTournamentsParallel() {
+    // above PARALLEL_END_MIN_TOURNAMENTS ids, so the winners are computed on the thread pool
+    int ids[LARGE_END_BATCH];
+    for (int i = 0; i < LARGE_END_BATCH; i++) {
+        ids[i] = i % 10 == 9 ? ids[i / 2] : LARGE_END_BATCH - i;
+    }
+    ids[LARGE_END_BATCH - 1] = -1;
+    ASSERT_TEST(sameAsEndingOneByOne(LARGE_END_BATCH - 8, ids, LARGE_END_BATCH));
+    return true;
+}
+
+bool testChessSavePlayersLevelsAsync() {
+    ChessSystem chess = createConcurrentTournaments();
+    ASSERT_TEST(chess != NULL && addTournamentGames(chess, 1) == 0);
+    char* levels = levelsOf(chess);
+    FILE* file = fopen(ASYNC_LEVELS_PATH, "w");
+    ASSERT_TEST(levels != NULL && file != NULL);
+    ChessLevelsExport levels_export = NULL;
+    ASSERT_TEST(chessSavePlayersLevelsAsync(chess, file, &levels_export) == CHESS_SUCCESS);
+    // the games that are added while the export is written are not in it
+    int failures = 0;
+    for (int id = 2; id <= CONCURRENT_TOURNAMENTS; id++) {
+        failures += addTournamentGames(chess, id);
+    }
+    ASSERT_TEST(failures == 0);
+    ASSERT_TEST(chessWaitPlayersLevelsExport(levels_export) == CHESS_SUCCESS);
+    fclose(file);
+    char* exported = readFile(ASYNC_LEVELS_PATH);
+    char* new_levels = levelsOf(chess);
+    ASSERT_TEST(exported != NULL && new_levels != NULL);
+    ASSERT_TEST(strcmp(exported, levels) == 0 && strcmp(new_levels, levels) != 0);
+    free(exported);
+    free(new_levels);
+    free(levels);
+    // the wait returns the result of the writer, here of a file that cannot be written
+    file = fopen(ASYNC_LEVELS_PATH, "r");
+    ASSERT_TEST(file != NULL);
+    ASSERT_TEST(chessSavePlayersLevelsAsync(chess, file, &levels_export) == CHESS_SUCCESS);
+    ASSERT_TEST(chessWaitPlayersLevelsExport(levels_export) == CHESS_SAVE_FAILURE);
+    fclose(file);
+    ASSERT_TEST(chessIsPlayersLevelsExportDone(NULL));
+    ASSERT_TEST(chessWaitPlayersLevelsExport(NULL) == CHESS_NULL_ARGUMENT);
+    chessDestroy(chess);
+    remove(ASYNC_LEVELS_PATH);
+    remove(STATISTICS_PATH);
+    return true;
+}
+
+bool testChessTraceReplay() {
+    FILE* feed = fopen(FEED_PATH, "w");
+    ASSERT_TEST(feed != NULL);
+    fputs("2 1 4 0 20\n"
+          "2 4 9 9 30\n"
+          "2 4 9 4 30\n"
+          "2 x 9 2 30\n"
+          "9 1 2 0 10\n", feed);
+    fclose(feed);
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chessEnableTrace(chess, TRACE_PATH) == CHESS_SUCCESS);
+    addSampleCalls(chess, true);
+    int num_of_games = 0, num_of_players = 0, num_of_tournaments = 0;
+    ASSERT_TEST(chessIngestFile(chess, FEED_PATH, NULL, NULL, &num_of_games) == CHESS_SUCCESS);
+    ASSERT_TEST(num_of_games == 2);
+    remove(MISSING_FEED_PATH);
+    ASSERT_TEST(chessIngestFile(chess, MISSING_FEED_PATH, NULL, NULL, &num_of_games) == CHESS_SAVE_FAILURE);
+    ChessResult results[3];
+    ASSERT_TEST(chessEndTournaments(chess, (int[]){2, 1, 2}, 3, results) == CHESS_SUCCESS);
+    // player 9 has played only in the feed, so these results depend on its records
+    ChessPlayerStatistics player_statistics;
+    ASSERT_TEST(chessGetPlayerStats(chess, 9, &player_statistics) == CHESS_SUCCESS);
+    int* tournament_ids = NULL;
+    ASSERT_TEST(chessGetTournamentsAtLocation(chess, "London", &tournament_ids, &num_of_tournaments) ==
+                CHESS_SUCCESS);
+    free(tournament_ids);
+    char* levels = levelsOf(chess);
+    char* statistics = statisticsOf(chess, STATISTICS_PATH);
+    ASSERT_TEST(levels != NULL && statistics != NULL);
+    free(levels);
+    free(statistics);
+    FILE* delta = fopen(DELTA_PATH, "w");
+    ASSERT_TEST(delta != NULL);
+    ASSERT_TEST(chessSavePlayersLevelsDelta(chess, delta, &num_of_players) == CHESS_SUCCESS);
+    fclose(delta);
+    ASSERT_TEST(chessRemovePlayer(chess, 9) == CHESS_SUCCESS);
+    ASSERT_TEST(chessDisableTrace(chess) == CHESS_SUCCESS);
+    chessDestroy(chess);
+    // the feed is rotated, so the replay holds only if it ingests the records of the trace
+    feed = fopen(FEED_PATH, "w");
+    ASSERT_TEST(feed != NULL);
+    fputs("1 5 6 0 10\n", feed);
+    fclose(feed);
+    ASSERT_TEST(system(REPLAY_COMMAND) == 0);
+    char* report = readFile(REPLAY_REPORT_PATH);
+    ASSERT_TEST(report != NULL && strstr(report, "total calls=") != NULL && strstr(report, " mismatches=0 ") != NULL);
+    free(report);
+    remove(FEED_PATH);
+    remove(TRACE_PATH);
+    remove(REPLAY_REPORT_PATH);
+    remove(DELTA_PATH);
+    remove(STATISTICS_PATH);
+    return true;
+}
+
+/* the view of a subscriber: the number of events of every type, the last ended tournament and removed player,
+ * and the results of every player as the sum of the changes it was sent */
+typedef struct EventView_t {
+    int num_of_events[CHESS_EVENT_PLAYER_STATS + 1];
+    int ended_tournament;
+    int tournament_winner;
+    int removed_player;
+    ChessPlayerStatistics players[EVENT_VIEW_PLAYERS + 1];
+} EventView;
+
+static void collectEvent(const ChessEvent* event, void* context)
+{
+    EventView* view = context;
+    view->num_of_events[event->type]++;
+    if (event->type == CHESS_EVENT_TOURNAMENT_ENDED) {
+        view->ended_tournament = event->tournament_id;
+        view->tournament_winner = event->player_id;
+    }
+    if (event->type == CHESS_EVENT_PLAYER_REMOVED) {
+        view->removed_player = event->player_id;
+        view->players[event->player_id] = (ChessPlayerStatistics) {0};
+    }
+    if (event->type == CHESS_EVENT_PLAYER_STATS && event->player_id <= EVENT_VIEW_PLAYERS) {
+        ChessPlayerStatistics* player = &view->players[event->player_id];
+        player->wins += event->wins;
+        player->losses += event->losses;
+        player->draws += event->draws;
+        player->num_of_games += event->num_of_games;
+    }
+}
+
+static bool sameResults(ChessPlayerStatistics first, ChessPlayerStatistics second)
+{
+    return first.wins == second.wins && first.losses == second.losses && first.draws == second.draws &&
+           first.num_of_games == second.num_of_games;
+}
+
+/* checks that the view of every player is its results in the system, or empty if it is not there */
+static bool sameAsView(ChessSystem chess, const EventView* view)
+{
+    for (int id = 1; id <= EVENT_VIEW_PLAYERS; id++) {
+        ChessPlayerStatistics statistics = {0};
+        ChessResult result = chessGetPlayerStats(chess, id, &statistics);
+        if ((result != CHESS_SUCCESS && result != CHESS_PLAYER_NOT_EXIST) ||
+            sameResults(statistics, view->players[id]) == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool testChessSubscribe() {
+    ChessSystem chess = chessCreate();
+    EventView view = {{0}};
+    int subscription_id = 0;
+    ASSERT_TEST(chessSubscribe(chess, NULL, &view, &subscription_id) == CHESS_NULL_ARGUMENT);
+    ASSERT_TEST(chessSubscribe(chess, collectEvent, &view, &subscription_id) == CHESS_SUCCESS);
+    addSampleCalls(chess, false);
+    ASSERT_TEST(view.num_of_events[CHESS_EVENT_GAME_ADDED] == 6);
+    ASSERT_TEST(view.num_of_events[CHESS_EVENT_TOURNAMENT_ENDED] == 1 && view.ended_tournament == 1);
+    ASSERT_TEST(view.tournament_winner == 1);
+    ASSERT_TEST(view.num_of_events[CHESS_EVENT_TOURNAMENT_REMOVED] == 1);
+    ASSERT_TEST(sameAsView(chess, &view));
+    // the changes that the removal sends to the opponent are the change of its results in the system
+    ChessPlayerStatistics before, after;
+    ASSERT_TEST(chessGetPlayerStats(chess, 3, &before) == CHESS_SUCCESS);
+    ChessPlayerStatistics view_before = view.players[3];
+    ASSERT_TEST(chessRemovePlayer(chess, 6) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetPlayerStats(chess, 3, &after) == CHESS_SUCCESS);
+    ASSERT_TEST(view.num_of_events[CHESS_EVENT_PLAYER_REMOVED] == 1 && view.removed_player == 6);
+    ASSERT_TEST(after.wins - before.wins == view.players[3].wins - view_before.wins && after.wins > before.wins);
+    ASSERT_TEST(after.draws - before.draws == view.players[3].draws - view_before.draws);
+    ASSERT_TEST(sameAsView(chess, &view));
+    // a rejected game sends nothing, and an unsubscribed function is not called
+    int num_of_games = view.num_of_events[CHESS_EVENT_GAME_ADDED];
+    ASSERT_TEST(chessAddGame(chess, 2, 1, 5, DRAW, 10) == CHESS_GAME_ALREADY_EXISTS);
+    ASSERT_TEST(view.num_of_events[CHESS_EVENT_GAME_ADDED] == num_of_games);
+    ASSERT_TEST(chessUnsubscribe(chess, subscription_id) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 2, 5, DRAW, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(view.num_of_events[CHESS_EVENT_GAME_ADDED] == num_of_games);
+    ASSERT_TEST(chessUnsubscribe(chess, subscription_id) == CHESS_INVALID_ID);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessGetPlayerStats() {
+    ChessSystem chess = createSampleSystem();
+    ChessPlayerStatistics statistics;
+    ASSERT_TEST(chessGetPlayerStats(chess, 1, &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.wins == 1 && statistics.losses == 1 && statistics.draws == 1);
+    ASSERT_TEST(statistics.num_of_games == 3);
+    // every line of the levels export is the level of its player
+    char* levels = levelsOf(chess);
+    ASSERT_TEST(levels != NULL);
+    int num_of_lines = 0;
+    for (const char* line = levels; *line != '\0'; line = strchr(line, '\n') + 1, num_of_lines++) {
+        int id;
+        ASSERT_TEST(sscanf(line, "%d", &id) == 1);
+        ASSERT_TEST(chessGetPlayerStats(chess, id, &statistics) == CHESS_SUCCESS);
+        char expected[MAX_LEVEL_LINE];
+        sprintf(expected, "%d %.2lf\n", id, statistics.level);
+        ASSERT_TEST(strncmp(line, expected, strlen(expected)) == 0);
+    }
+    ASSERT_TEST(num_of_lines == 5);
+    free(levels);
+    remove(STATISTICS_PATH);
+    // the player of a removed tournament stays without games, a removed player is not there
+    ASSERT_TEST(chessGetPlayerStats(chess, 7, &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.num_of_games == 0 && statistics.level == 0);
+    ASSERT_TEST(chessGetPlayerStats(chess, 6, &statistics) == CHESS_PLAYER_NOT_EXIST);
+    ASSERT_TEST(chessGetPlayerStats(chess, 0, &statistics) == CHESS_INVALID_ID);
+    ASSERT_TEST(chessGetPlayerStats(chess, 1, NULL) == CHESS_NULL_ARGUMENT);
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessGetTournamentPlayerStats() {
+    ChessSystem chess = createSampleSystem();
+    ChessPlayerStatistics total, in_ended, in_open;
+    // the results of a player in its tournaments, ended or not, add up to its results in the system
+    ASSERT_TEST(chessGetPlayerStats(chess, 1, &total) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 1, 1, &in_ended) == CHESS_SUCCESS);
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 2, 1, &in_open) == CHESS_SUCCESS);
+    ASSERT_TEST(in_ended.wins == 1 && in_ended.draws == 1 && in_ended.losses == 0 && in_ended.num_of_games == 2);
+    ASSERT_TEST(in_open.wins == 0 && in_open.losses == 1 && in_open.num_of_games == 1);
+    ASSERT_TEST(in_ended.wins + in_open.wins == total.wins && in_ended.losses + in_open.losses == total.losses);
+    ASSERT_TEST(in_ended.draws + in_open.draws == total.draws);
+    ASSERT_TEST(in_ended.num_of_games + in_open.num_of_games == total.num_of_games);
+    // the game of the removed player 6 became a win of player 3 in the open tournament
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 2, 3, &in_open) == CHESS_SUCCESS);
+    ASSERT_TEST(in_open.wins == 1 && in_open.draws == 0 && in_open.num_of_games == 1);
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 1, 5, &in_open) == CHESS_PLAYER_NOT_EXIST);
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 3, 7, &in_open) == CHESS_TOURNAMENT_NOT_EXIST);
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 1, -1, &in_open) == CHESS_INVALID_ID);
+    ASSERT_TEST(chessGetTournamentPlayerStats(chess, 1, 1, NULL) == CHESS_NULL_ARGUMENT);
+    chessDestroy(chess);
+    return true;
+}
+
+/* checks the ids that chessGetTournamentsAtLocation returns for a location */
+static bool sameTournamentsAt(ChessSystem chess, const char* location, const int* expected, int num_expected)
+{
+    int* tournament_ids = NULL;
+    int num_of_tournaments = -1;
+    bool same = chessGetTournamentsAtLocation(chess, location, &tournament_ids, &num_of_tournaments) ==
+                CHESS_SUCCESS && num_of_tournaments == num_expected && (num_expected > 0) == (tournament_ids != NULL);
+    for (int i = 0; same && i < num_expected; i++) {
+        same = tournament_ids[i] == expected[i];
+    }
+    free(tournament_ids);
+    return same;
+}
+
+bool testChessLocationQueries() {
+    ChessSystem chess = createSampleSystem();
+    ASSERT_TEST(chessAddTournament(chess, 10, 3, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 4, 3, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 5, 3, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 10, 11, 12, SECOND_PLAYER, 2500) == CHESS_SUCCESS);
+    // the removed tournament 3 was in London too
+    ASSERT_TEST(sameTournamentsAt(chess, "London", (int[]){1, 4, 10}, 3));
+    ASSERT_TEST(sameTournamentsAt(chess, "Tel aviv", (int[]){2}, 1));
+    ASSERT_TEST(sameTournamentsAt(chess, "Nowhere", NULL, 0));
+    ChessLocationStatistics statistics;
+    ASSERT_TEST(chessGetLocationStatistics(chess, "London", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.num_tournaments == 3 && statistics.num_ended_tournaments == 1);
+    ASSERT_TEST(statistics.num_games == 4 && statistics.longest_game == 2500);
+    ASSERT_TEST(statistics.total_play_time == 6700 && statistics.average_play_time == 1675);
+    ASSERT_TEST(chessGetLocationStatistics(chess, "Paris", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.num_tournaments == 1 && statistics.num_games == 0 && statistics.average_play_time == 0);
+    ASSERT_TEST(chessGetLocationStatistics(chess, "Nowhere", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.num_tournaments == 0 && statistics.num_games == 0);
+    // the index follows the removals and the ends
+    ASSERT_TEST(chessRemoveTournament(chess, 4) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(chess, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(sameTournamentsAt(chess, "London", (int[]){1, 10}, 2));
+    ASSERT_TEST(chessGetLocationStatistics(chess, "London", &statistics) == CHESS_SUCCESS);
+    ASSERT_TEST(statistics.num_tournaments == 2 && statistics.num_ended_tournaments == 2);
+    int* tournament_ids = NULL;
+    int num_of_tournaments = 0;
+    ASSERT_TEST(chessGetTournamentsAtLocation(chess, "london", &tournament_ids, &num_of_tournaments) ==
+                CHESS_INVALID_LOCATION);
+    ASSERT_TEST(chessGetLocationStatistics(chess, "london", &statistics) == CHESS_INVALID_LOCATION);
+    ASSERT_TEST(chessGetTournamentsAtLocation(chess, NULL, &tournament_ids, &num_of_tournaments) ==
+                CHESS_NULL_ARGUMENT);
+    ASSERT_TEST(chessGetLocationStatistics(chess, "London", NULL) == CHESS_NULL_ARGUMENT);
+    chessDestroy(chess);
+    return true;
+}
+
+/*The functions for the tests should be added here*/
+bool (*tests[]) (void) = {
+        testChessSnapshotRoundTrip,
+        testChessSnapshotCorrupted,
+        testChessLogReplay,
+        testChessLogReplayTornTail,
+        testChessIngestFile,
+        testChessIngestFileBatches,
+        testChessTournamentStatisticsDelta,
+        testChessPlayersLevelsDelta,
+        testChessAddGameConcurrent,
+        testChessEndTournamentsBatch,
+        testChessEndTournamentsParallel,
+        testChessSavePlayersLevelsAsync,
+        testChessTraceReplay,
+        testChessSubscribe,
+        testChessGetPlayerStats,
+        testChessGetTournamentPlayerStats,
+        testChessLocationQueries
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testChessSnapshotRoundTrip",
+        "testChessSnapshotCorrupted",
+        "testChessLogReplay",
+        "testChessLogReplayTornTail",
+        "testChessIngestFile",
+        "testChessIngestFileBatches",
+        "testChessTournamentStatisticsDelta",
+        "testChessPlayersLevelsDelta",
+        "testChessAddGameConcurrent",
+        "testChessEndTournamentsBatch",
+        "testChessEndTournamentsParallel",
+        "testChessSavePlayersLevelsAsync",
+        "testChessTraceReplay",
+        "testChessSubscribe",
+        "testChessGetPlayerStats",
+        "testChessGetTournamentPlayerStats",
+        "testChessLocationQueries"
+};
+
+int main(int argc, char *argv[]) {
+    int failed_tests = 0;
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return failed_tests == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: chessSystemTestsExtended <test index>\n");
+        return EXIT_FAILURE;
+    }
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return EXIT_FAILURE;
+    }
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return failed_tests == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
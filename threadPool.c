@@ -0,0 +1,233 @@
+#define _POSIX_C_SOURCE 200809L
+#include "threadPool.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define MIN_THREADS 1
+#define CALLING_THREAD 1
+#define NO_TASK (-1)
+
+/* the tasks [next, end) that belong to one thread of the run. the owner takes tasks from the front,
+ * a thread that has run out of tasks steals the back half */
+typedef struct task_range_t
+{
+    pthread_mutex_t lock;
+    int next;
+    int end;
+} TaskRange;
+
+struct thread_pool_t
+{
+    int num_workers;
+    int started_workers;
+    pthread_t* workers;
+    TaskRange* ranges;
+    pthread_mutex_t lock;
+    pthread_cond_t run_posted;
+    pthread_cond_t run_finished;
+    ThreadTask task;
+    void* context;
+    int finished_workers;
+    unsigned long generation;
+    bool shutdown;
+};
+
+/* the loop of a worker thread: waits for a run and takes part in it */
+static void* threadPoolWorker(void* thread_pool);
+
+/* runs tasks of the current run, first of the range of the thread and then stolen from the others,
+ * until no task is left. called without the lock of the pool */
+static void threadPoolRunTasks(ThreadPool pool, int thread_index);
+
+/* takes the next task of the range, NO_TASK if the range is empty */
+static int threadPoolTakeTask(TaskRange* range);
+
+/* moves the back half of the range of another thread into the range of the thread.
+ * return false if all the ranges are empty */
+static bool threadPoolSteal(ThreadPool pool, int thread_index);
+
+ThreadPool threadPoolCreate(int num_threads)
+{
+    if(num_threads < MIN_THREADS) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online < MIN_THREADS ? MIN_THREADS : (int)online;
+    }
+    ThreadPool pool = malloc(sizeof(*pool));
+    if(pool == NULL) {
+        return NULL;
+    }
+    pool->workers = malloc(num_threads * sizeof(*pool->workers));
+    pool->ranges = malloc(num_threads * sizeof(*pool->ranges));
+    if(pool->workers == NULL || pool->ranges == NULL) {
+        free(pool->workers);
+        free(pool->ranges);
+        free(pool);
+        return NULL;
+    }
+    for(int i = 0; i < num_threads; i++) {
+        pthread_mutex_init(&pool->ranges[i].lock, NULL);
+        pool->ranges[i].next = 0;
+        pool->ranges[i].end = 0;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->run_posted, NULL);
+    pthread_cond_init(&pool->run_finished, NULL);
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->finished_workers = 0;
+    pool->generation = 0;
+    pool->shutdown = false;
+    pool->num_workers = 0;
+    pool->started_workers = 0;
+    pthread_mutex_lock(&pool->lock);
+    for(int i = 0; i < num_threads - CALLING_THREAD; i++) {
+        if(pthread_create(&pool->workers[i], NULL, threadPoolWorker, pool) != 0) {
+            break;
+        }
+        pool->num_workers++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return pool;
+}
+
+void threadPoolDestroy(ThreadPool pool)
+{
+    if(pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->run_posted);
+    pthread_mutex_unlock(&pool->lock);
+    for(int i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    for(int i = 0; i < pool->num_workers + CALLING_THREAD; i++) {
+        pthread_mutex_destroy(&pool->ranges[i].lock);
+    }
+    pthread_cond_destroy(&pool->run_finished);
+    pthread_cond_destroy(&pool->run_posted);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->ranges);
+    free(pool->workers);
+    free(pool);
+}
+
+int threadPoolGetSize(ThreadPool pool)
+{
+    if(pool == NULL) {
+        return CALLING_THREAD;
+    }
+    return pool->num_workers + CALLING_THREAD;
+}
+
+void threadPoolRun(ThreadPool pool, int num_tasks, ThreadTask task, void* context)
+{
+    assert(task != NULL);
+    if(pool == NULL || pool->num_workers == 0) {
+        for(int i = 0; i < num_tasks; i++) {
+            task(i, context);
+        }
+        return;
+    }
+    int num_threads = pool->num_workers + CALLING_THREAD;
+    pthread_mutex_lock(&pool->lock);
+    for(int i = 0; i < num_threads; i++) {
+        pthread_mutex_lock(&pool->ranges[i].lock);
+        pool->ranges[i].next = (int)((long long)num_tasks * i / num_threads);
+        pool->ranges[i].end = (int)((long long)num_tasks * (i + 1) / num_threads);
+        pthread_mutex_unlock(&pool->ranges[i].lock);
+    }
+    pool->task = task;
+    pool->context = context;
+    pool->finished_workers = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->run_posted);
+    pthread_mutex_unlock(&pool->lock);
+    // the calling thread owns the last range
+    threadPoolRunTasks(pool, pool->num_workers);
+    // every worker leaves the run before the next one is posted
+    pthread_mutex_lock(&pool->lock);
+    while(pool->finished_workers < pool->num_workers) {
+        pthread_cond_wait(&pool->run_finished, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void* threadPoolWorker(void* thread_pool)
+{
+    ThreadPool pool = thread_pool;
+    unsigned long seen_generation = 0;
+    pthread_mutex_lock(&pool->lock);
+    int thread_index = pool->started_workers++;
+    while(true)
+    {
+        while(pool->shutdown == false && pool->generation == seen_generation) {
+            pthread_cond_wait(&pool->run_posted, &pool->lock);
+        }
+        if(pool->shutdown == true) {
+            break;
+        }
+        seen_generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        threadPoolRunTasks(pool, thread_index);
+        pthread_mutex_lock(&pool->lock);
+        pool->finished_workers++;
+        if(pool->finished_workers == pool->num_workers) {
+            pthread_cond_broadcast(&pool->run_finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void threadPoolRunTasks(ThreadPool pool, int thread_index)
+{
+    TaskRange* own = &pool->ranges[thread_index];
+    do {
+        int task_index;
+        while((task_index = threadPoolTakeTask(own)) != NO_TASK) {
+            pool->task(task_index, pool->context);
+        }
+    } while(threadPoolSteal(pool, thread_index));
+}
+
+static int threadPoolTakeTask(TaskRange* range)
+{
+    int task_index = NO_TASK;
+    pthread_mutex_lock(&range->lock);
+    if(range->next < range->end) {
+        task_index = range->next++;
+    }
+    pthread_mutex_unlock(&range->lock);
+    return task_index;
+}
+
+static bool threadPoolSteal(ThreadPool pool, int thread_index)
+{
+    int num_threads = pool->num_workers + CALLING_THREAD;
+    for(int i = 1; i < num_threads; i++)
+    {
+        TaskRange* victim = &pool->ranges[(thread_index + i) % num_threads];
+        pthread_mutex_lock(&victim->lock);
+        int left = victim->end - victim->next;
+        if(left <= 0) {
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+        int stolen_end = victim->end;
+        victim->end -= (left + 1) / 2;
+        int stolen_next = victim->end;
+        pthread_mutex_unlock(&victim->lock);
+        TaskRange* own = &pool->ranges[thread_index];
+        pthread_mutex_lock(&own->lock);
+        own->next = stolen_next;
+        own->end = stolen_end;
+        pthread_mutex_unlock(&own->lock);
+        return true;
+    }
+    return false;
+}
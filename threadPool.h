@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+typedef struct thread_pool_t *ThreadPool;
+
+/** Type of a task that the pool runs: called once for every index in [0, num_tasks) */
+typedef void (*ThreadTask)(int task_index, void* context);
+
+/**
+* threadPoolCreate: creates a pool of threads that run tasks together with the calling thread.
+*
+* @param num_threads - the number of threads that run the tasks, the calling thread included.
+*                      a non positive number means a thread per online processor.
+* @return
+* 	NULL - allocation failed.
+* 	pointer to the pool - otherwise. if some of the threads could not be started,
+* 	the pool works with less threads.
+*/
+ThreadPool threadPoolCreate(int num_threads);
+
+/**
+* threadPoolDestroy: stops the threads of the pool and deallocates it.
+*
+* @param pool - the pool to destroy.
+*/
+void threadPoolDestroy(ThreadPool pool);
+
+/**
+* threadPoolGetSize: returns the number of threads that run the tasks, the calling thread included.
+*
+* @param pool - the pool.
+* @return
+* 	1 - for a NULL pool.
+* 	the number of threads - otherwise.
+*/
+int threadPoolGetSize(ThreadPool pool);
+
+/**
+* threadPoolRun: runs the task for every index in [0, num_tasks) on the threads of the pool
+* and on the calling thread, and returns after all of them are done.
+* every thread starts with an equal range of the indexes, and a thread that has finished
+* its range steals the back half of the range of another thread, so uneven tasks are balanced.
+* tasks of the same run may be called in any order and at the same time,
+* so they must not write to shared data without their own synchronization.
+* a NULL pool runs all the tasks on the calling thread.
+*
+* @param pool - the pool.
+* @param num_tasks - the number of tasks.
+* @param task - the function to run.
+* @param context - a pointer that is passed as is to the task.
+*/
+void threadPoolRun(ThreadPool pool, int num_tasks, ThreadTask task, void* context);
+
+#endif //THREAD_POOL_H
@@ -1,32 +1,196 @@
+#define _POSIX_C_SOURCE 200809L
 #include "tournament.h"
 #include "games.h"
+#include "mapExtended.h"
 #include "stdlib.h"
 #include "assert.h"
 #include "string.h"
 #include "stdio.h"
 #include "stdbool.h"
+#include <pthread.h>
 #define TOUR_NOT_OVER (-1)
 #define DUMMY_LIMB_ID (-1)
 #define EMPTY (-1)
 #define EQUAL 0
+#define STATISTICS_FORMAT "%d\n%d\n%.2lf\n%s\n%d\n%d\n"
+#define STATISTICS_ID_FORMAT "%d\n"
+#define STATISTICS_WRITE_BUFFER (1 << 16)
 
 
 
+// the games and the players of a tournament that has not ended are allocated from its arena,
+// so removing the tournament frees a few blocks instead of every game and player.
+// every tournament data (and every copy of one) holds its own reference to its location in the pool
 struct tour_data
 {
-    char* tournament_location;
+    StringPool locations;
+    InternedString tournament_location;
     int max_game_player;
+    Arena arena;
     MapHead games;
     Map Players;
+    PlayerTable frozen_players;
     int tournament_winner;
     bool tour_ended;
+    char* statistics;
+    size_t statistics_length;
 };
-/* free tha tournament data */
+
+// the lock guards the players index, the only part of the index that chessAddGame calls
+// of different tournaments may update together.
+// the pending tournaments are the ended tournaments whose statistics changed since the last delta export
+// (they ended, or a player was removed from them). if one of them could not be added to the set,
+// the next delta export writes all the ended tournaments instead
+struct tour_index_t
+{
+    pthread_mutex_t lock;
+    Map player_tournaments;
+    Map ended_tournaments;
+    Map pending_statistics;
+    bool pending_statistics_lost;
+    StringPool locations;
+    Map location_tournaments;
+};
+/* create the data of a new tournament in the tournament map, without indexing it.
+ * return the data that is stored in the map, NULL if allocation failed */
+static TourData tournamentCreateData(Map tournament, TourIndex index, int tournament_id,
+                                     const char* location, int max_games);
+
+/* free tha tournament data. the location belongs to the locations pool of the index */
 static void tournamentFreeData(MapDataElement tournament_data);
 
 /* copy the tournament data */
 static MapDataElement tournamentDataCopy(MapDataElement tournament_data);
 
+/* format the statistics block of an ended tournament into its statistics buffer */
+static TournamentResult tournamentFormatStatistics(TourData tour_data);
+
+/* format the statistics of the tournament of the task (the context is an array of tournaments) */
+static void tournamentFormatStatisticsTask(int task_index, void* tournaments);
+
+/* write the statistics blocks of the tournaments of a set to a file that is opened with the mode, in the order
+ * of the ids, each after a line of its id if with_ids is true. the blocks that are not formatted yet are
+ * formatted in parallel on the pool first */
+static TournamentResult tournamentWriteStatistics(Map tournament_set, const char* path_file, const char* mode,
+                                                  bool with_ids, ThreadPool pool);
+
+/* add an ended tournament to the tournaments whose statistics are exported by the next delta export */
+static void tournamentMarkPending(TourIndex index, int tournament_id, TourData tour_data);
+
+/* free the statistics buffer of the tournament, so it is formatted again on the next export */
+static void tournamentInvalidateStatistics(TourData tour_data);
+
+/* compact an ended tournament: pack the games and replace the players map with a players table.
+ * if an allocation fails, the tournament (or the part of it) stays as it was */
+static void tournamentFreeze(TourData tour_data);
+
+/* an id of a batch of tournaments to close: its position in the batch and its data */
+typedef struct tour_end_entry_t
+{
+    int id;
+    int position;
+    TourData data;
+} TourEndEntry;
+
+/* check if the tournament can be closed: TOUR_ENDED, TOUR_N0_GAMES or TOUR_SUCCESS */
+static TournamentResult tournamentCheckEnd(TourData tour_data);
+
+/* close a tournament that is already in the ended tournaments: find the winner, format the
+ * statistics and compact it. tournaments of different entries may be closed at the same time */
+static void tournamentComplete(TourData tour_data);
+static void tournamentCompleteTask(int task_index, void* entries);
+
+/* order the entries of a batch by id and then by position */
+static int tournamentEndEntryCompare(const void* entry1, const void* entry2);
+
+/* compare an id with the id of an entry, for searching the entries of a batch */
+static int tournamentEndEntryIdCompare(const void* id, const void* entry);
+
+/* a tournament that a player has played in, for building the players index in one pass */
+typedef struct tour_player_entry_t
+{
+    int player_id;
+    int tournament_id;
+    TourData data;
+} TourPlayerEntry;
+
+/* apply functions for tournamentRebuildIndex: collect the tournaments of a map as entries,
+ * and the players of a tournament map as player entries (the context is the next place in the array) */
+static void tournamentCollectEntry(MapKeyElement tournament_id, MapDataElement tour_data, void* next_entry);
+static void tournamentCollectPlayer(MapKeyElement player_id, MapDataElement player_data, void* next_entry);
+
+/* order the player entries by player and then by tournament */
+static int tournamentPlayerEntryCompare(const void* entry1, const void* entry2);
+
+/* add the tournaments of every player to the players index, from player entries that are sorted */
+static TournamentResult tournamentIndexPlayerEntries(TourIndex index, TourPlayerEntry* entries,
+                                                     int num_of_entries);
+
+/* apply function for tournamentSave: write a tournament (the context is the writer) */
+static void tournamentSaveData(MapKeyElement tournament_id, MapDataElement tour_data, void* writer);
+
+/* check if the player is one of the players of the tournament, frozen or not */
+static bool tournamentHasPlayer(TourData tour_data, int player_id);
+
+/* create a set of tournaments (tournament id -> the tournament data, not owned by the set) */
+static Map tournamentCreateSet();
+
+/* the tournaments set does not own its data, so copy and free only pass the pointer */
+static MapDataElement tournamentPointerCopy(MapDataElement tournament_data);
+static void tournamentPointerFree(MapDataElement tournament_data);
+
+/* copy and free a tournaments set that is stored as a data of the index */
+static MapDataElement tournamentSetCopy(MapDataElement tournament_set);
+static void tournamentSetFree(MapDataElement tournament_set);
+
+/* the keys of the locations index are the interned locations, which belong to the pool.
+ * the compare works on any string, so the index can be searched by a location that is not interned */
+static MapKeyElement tournamentLocationCopy(MapKeyElement location);
+static void tournamentLocationFree(MapKeyElement location);
+static int tournamentLocationCompare(MapKeyElement location1, MapKeyElement location2);
+
+/* add the tournament to the set of the tournaments that are held in its location */
+static TournamentResult tournamentIndexLocation(TourIndex index, int tournament_id, TourData tour_data);
+
+/* remove the tournament from the set of the tournaments that are held in its location */
+static void tournamentUnindexLocation(TourIndex index, int tournament_id, TourData tour_data);
+
+/* apply functions for the location queries (the context is the array of ids / the statistics) */
+static void tournamentCollectId(MapKeyElement tournament_id, MapDataElement tour_data, void* ids);
+static void tournamentAddStatistic(MapKeyElement tournament_id, MapDataElement tour_data, void* statistics);
+
+/* add the tournament to the set of the tournaments that the player has played in */
+static TournamentResult tournamentIndexPlayer(TourIndex index, int player_id,
+                                              int tournament_id, TourData tour_data);
+
+/* undo tournamentIndexPlayer for a player that has no games in the tournament, after adding
+ * its game failed. called with the lock of the index held */
+static void tournamentUnindexNewPlayer(TourIndex index, TourData tour_data, int player_id, int tournament_id);
+
+/* a tournament that is being removed from the players index: the position in the players table of
+ * a frozen one, and the players whose set became empty, that are removed from the index after the walk */
+typedef struct tour_unindex_t
+{
+    PlayerTable players;
+    int position;
+    int tournament_id;
+    int* emptied;
+    int num_of_emptied;
+} TourUnindex;
+
+/* merge function for tournamentDestroy: remove the tournament from the set of the tournaments
+ * that the player has played in (the context is a TourUnindex) */
+static void tournamentUnindexPlayer(MapKeyElement player_id, MapDataElement player_data,
+                                    MapDataElement player_tournaments, void* tour_unindex);
+
+/* apply function for tournamentDestroy of a frozen tournament: like tournamentUnindexPlayer,
+ * for the players of the table (the context is a TourUnindex) */
+static void tournamentUnindexFrozenPlayer(MapKeyElement player_id, MapDataElement player_tournaments,
+                                          void* tour_unindex);
+
+/* remove the tournament from the set of one player, and remember the player if its set became empty */
+static void tournamentUnindexFromSet(TourUnindex* unindex, int player_id, Map player_tournaments);
+
 
 Map tournamentCreateNew()
 {
@@ -37,43 +201,66 @@ Map tournamentCreateNew()
     }
     return new_tournament_map;
 }
-TournamentResult tournamentAdd(Map tournament, int tournament_id,
+TourIndex tournamentCreateIndex()
+{
+    TourIndex index = malloc(sizeof(*index));
+    if(index == NULL){
+        return NULL;
+    }
+    pthread_mutex_init(&index->lock, NULL);
+    index->player_tournaments = mapCreate(tournamentSetCopy, copyIntKey, tournamentSetFree,
+                                          destroyIntKey, intKeyCompare);
+    index->ended_tournaments = tournamentCreateSet();
+    index->pending_statistics = tournamentCreateSet();
+    index->pending_statistics_lost = false;
+    index->locations = stringPoolCreate();
+    index->location_tournaments = mapCreate(tournamentSetCopy, tournamentLocationCopy, tournamentSetFree,
+                                            tournamentLocationFree, tournamentLocationCompare);
+    if(index->player_tournaments == NULL || index->ended_tournaments == NULL ||
+       index->pending_statistics == NULL || index->locations == NULL || index->location_tournaments == NULL){
+        tournamentDestroyIndex(index);
+        return NULL;
+    }
+    return index;
+}
+
+void tournamentDestroyIndex(TourIndex index)
+{
+    if(index == NULL){
+        return;
+    }
+    mapDestroy(index->player_tournaments);
+    mapDestroy(index->ended_tournaments);
+    mapDestroy(index->pending_statistics);
+    mapDestroy(index->location_tournaments);
+    stringPoolDestroy(index->locations);
+    pthread_mutex_destroy(&index->lock);
+    free(index);
+}
+
+TournamentResult tournamentAdd(Map tournament, TourIndex index, int tournament_id,
                                const char* location, int max_games)
 {
-    assert(tournament != NULL && location != NULL);
-    TourData tour_data = malloc(sizeof(*tour_data));
+    assert(tournament != NULL && index != NULL && location != NULL);
+    TourData tour_data = tournamentCreateData(tournament, index, tournament_id, location, max_games);
     if(tour_data == NULL){
         return TOUR_MEMORY_PROBLEM;
     }
-    tour_data->tournament_location = malloc(strlen(location) + 1);
-    if(tour_data->tournament_location == NULL)
-    {
-        free(tour_data);
+    if(tournamentIndexLocation(index, tournament_id, tour_data) == TOUR_MEMORY_PROBLEM){
+        mapRemove(tournament, &tournament_id);
         return TOUR_MEMORY_PROBLEM;
     }
-    strcpy(tour_data->tournament_location, location);
-    tour_data->tournament_winner = TOUR_NOT_OVER;
-    tour_data->tour_ended = false;
-    tour_data->max_game_player = max_games;
-    tour_data->games = gameCreate();
-    tour_data->Players = playersCreateMap();
-    if(tour_data->games == NULL || tour_data->Players == NULL ||
-       mapPut(tournament, &tournament_id, tour_data) == MAP_OUT_OF_MEMORY){
-        tournamentFreeData(tour_data);
-        return TOUR_MEMORY_PROBLEM;
-    }
-    tournamentFreeData(tour_data);
     return TOUR_SUCCESS;
 }
 
-TournamentResult tournamentAddGame(Map tournament, int tournament_id, int id1, int id2,
-                                   Winner winner, int game_time)
+TournamentResult tournamentCheckGame(Map tournament, int tournament_id, int id1, int id2, int game_time,
+                                     TourData* tour_data_out)
 {
-    assert(id1 > 0 && id2 > 0 && tournament != NULL);
-    if(mapContains(tournament, &tournament_id) == false){
+    assert(id1 > 0 && id2 > 0 && tournament != NULL && tour_data_out != NULL);
+    TourData tour_data = mapGet(tournament, &tournament_id);
+    if(tour_data == NULL){
         return TOUR_NOT_EXIST;
     }
-    TourData tour_data = mapGet(tournament, &tournament_id);
     if(tour_data->tour_ended == true){
         return TOUR_ENDED;
     }
@@ -87,96 +274,211 @@ TournamentResult tournamentAddGame(Map tournament, int tournament_id, int id1, i
         playerGetNumOfGames(tour_data->Players, &id2) >= tour_data->max_game_player){
         return TOUR_EXCEEDED_GAMES;
     }
+    *tour_data_out = tour_data;
+    return TOUR_SUCCESS;
+}
+
+TournamentResult tournamentCommitGame(TourData tour_data, TourIndex index, int tournament_id, int id1, int id2,
+                                      Winner winner, int game_time)
+{
+    assert(tour_data != NULL && index != NULL && tour_data->tour_ended == false);
+    // a player of the tournament is indexed under it exactly when it is in its players, so when
+    // the game is not added the players that are new to the tournament are unindexed again
+    pthread_mutex_lock(&index->lock);
+    if(tournamentIndexPlayer(index, id1, tournament_id, tour_data) == TOUR_MEMORY_PROBLEM ||
+       tournamentIndexPlayer(index, id2, tournament_id, tour_data) == TOUR_MEMORY_PROBLEM){
+        tournamentUnindexNewPlayer(index, tour_data, id1, tournament_id);
+        tournamentUnindexNewPlayer(index, tour_data, id2, tournament_id);
+        pthread_mutex_unlock(&index->lock);
+        return TOUR_MEMORY_PROBLEM;
+    }
+    pthread_mutex_unlock(&index->lock);
     if(gameAdd(tour_data->games, tour_data->Players, id1, id2, winner, game_time) == GAME_OUT_OF_MEMORY) {
+        pthread_mutex_lock(&index->lock);
+        tournamentUnindexNewPlayer(index, tour_data, id1, tournament_id);
+        tournamentUnindexNewPlayer(index, tour_data, id2, tournament_id);
+        pthread_mutex_unlock(&index->lock);
         return TOUR_MEMORY_PROBLEM;
     }
     return TOUR_SUCCESS;
 }
-TournamentResult tournamentStatistic(char* path_file, Map tournament)
+TournamentResult tournamentStatistic(char* path_file, TourIndex index, ThreadPool pool)
 {
-    FILE* file = fopen(path_file,"w");
-    if(file == NULL){
+    assert(index != NULL);
+    return tournamentWriteStatistics(index->ended_tournaments, path_file, "w", false, pool);
+}
+
+TournamentResult tournamentStatisticDelta(char* path_file, TourIndex index, ThreadPool pool,
+                                          int* num_of_tournaments)
+{
+    assert(index != NULL && num_of_tournaments != NULL);
+    Map pending = index->pending_statistics_lost ? index->ended_tournaments : index->pending_statistics;
+    int num_pending = mapGetSize(pending);
+    if(tournamentWriteStatistics(pending, path_file, "a", true, pool) == TOUR_MEMORY_PROBLEM){
+        // the pending tournaments are kept, so a failed export is written again by the next one
         return TOUR_MEMORY_PROBLEM;
     }
-    MAP_FOREACH(int*, iter, tournament)
-    {
-        TourData tour_data = mapGet(tournament, iter);
-        if(tour_data->tour_ended == true) {
-            if (fprintf(file, "%d\n", tour_data->tournament_winner) < 0) {
-                return TOUR_MEMORY_PROBLEM;
-            }
-            if (fprintf(file, "%d\n", gameGetInfo(tour_data->games, GAME_LONGEST)) < 0) {
-                return TOUR_MEMORY_PROBLEM;
-            }
-            if (fprintf(file, "%.2lf\n", gameAvgTime(tour_data->games)) < 0) {
-                return TOUR_MEMORY_PROBLEM;
-            }
-            if (fprintf(file, "%s\n", tour_data->tournament_location) < 0) {
-                return TOUR_MEMORY_PROBLEM;
-            }
-            if (fprintf(file, "%d\n", gameGetInfo(tour_data->games, GAME_NUM_GAMES)) < 0) {
-                return TOUR_MEMORY_PROBLEM;
-            }
-            if (fprintf(file, "%d\n", gameGetInfo(tour_data->games, GAME_NUM_PLAYERS)) < 0) {
-                return TOUR_MEMORY_PROBLEM;
-            }
-        }
-        free(iter);
-    }
-    fclose(file);
+    mapClear(index->pending_statistics);
+    index->pending_statistics_lost = false;
+    *num_of_tournaments = num_pending;
     return TOUR_SUCCESS;
 }
-void tournamentDestroy(Map tournament, Map external_player, int id)
+
+int tournamentGetNumPending(TourIndex index)
+{
+    assert(index != NULL);
+    return index->pending_statistics_lost ? mapGetSize(index->ended_tournaments) :
+           mapGetSize(index->pending_statistics);
+}
+
+void tournamentDestroy(Map tournament, Map external_player, TourIndex index, int id)
 {
-    assert(tournament!= NULL && external_player != NULL);
+    assert(tournament!= NULL && external_player != NULL && index != NULL);
     TourData data = mapGet(tournament, &id);
-    playerRemoveData(external_player, data->Players);
+    int num_of_players = data->frozen_players != NULL ? playerTableGetSize(data->frozen_players) :
+                         mapGetSize(data->Players);
+    // without memory for the emptied players their empty sets are kept, which only costs space
+    TourUnindex unindex = {data->frozen_players, 0, id, malloc((num_of_players + 1) * sizeof(int)), 0};
+    if(data->frozen_players != NULL){
+        mapApply(index->player_tournaments, tournamentUnindexFrozenPlayer, &unindex);
+        playerTableRemoveData(external_player, data->frozen_players);
+    }
+    else{
+        mapMergeApply(data->Players, index->player_tournaments, tournamentUnindexPlayer, &unindex);
+        playerRemoveData(external_player, data->Players);
+    }
+    for (int i = 0; i < unindex.num_of_emptied; ++i) {
+        mapRemove(index->player_tournaments, &unindex.emptied[i]);
+    }
+    free(unindex.emptied);
+    mapRemove(index->ended_tournaments, &id);
+    mapRemove(index->pending_statistics, &id);
+    tournamentUnindexLocation(index, id, data);
     mapRemove(tournament, &id);
 }
 
-void tournamentRemovePlayer(Map tournament, Map external_player, int player_id)
+void tournamentRemovePlayer(TourIndex index, Map external_player, int player_id,
+                            PlayerStatsFunction on_change, void* context)
 {
-    assert(tournament != NULL && external_player != NULL);
-    MAP_FOREACH(int*, iter, tournament) {
-        TourData tour_data = mapGet(tournament, iter);
-        if(mapContains(tour_data->Players, &player_id)) {
+    assert(index != NULL && external_player != NULL);
+    Map player_tournaments = mapGet(index->player_tournaments, &player_id);
+    if(player_tournaments == NULL){
+        return;
+    }
+    MAP_FOREACH(int*, iter, player_tournaments) {
+        TourData tour_data = mapGet(player_tournaments, iter);
+        if(tournamentHasPlayer(tour_data, player_id)) {
             if(tour_data->tour_ended == false) {
-                gameUpdateQuitPlayer(tour_data->games, tour_data->Players, external_player, player_id);
+                gameUpdateQuitPlayer(tour_data->games, tour_data->Players, external_player, player_id,
+                                     on_change, context);
                 mapRemove(tour_data->Players, &player_id);
             }
             else {
-                mapRemove(tour_data->Players, &player_id);
+                if(tour_data->frozen_players != NULL) {
+                    playerTableRemove(tour_data->frozen_players, player_id);
+                }
+                else {
+                    mapRemove(tour_data->Players, &player_id);
+                }
+                tournamentInvalidateStatistics(tour_data);
+                tournamentMarkPending(index, *iter, tour_data);
             }
         }
         free(iter);
     }
+    mapRemove(index->player_tournaments, &player_id);
 }
-TournamentResult tournamentEnd(Map tournament, int tour_id)
+TournamentResult tournamentEnd(Map tournament, TourIndex index, int tour_id)
 {
-    assert(tournament != NULL);
+    assert(tournament != NULL && index != NULL);
     TourData data = mapGet(tournament, &tour_id);
     assert(data != NULL);
-    if(data->tour_ended == true){
-        return TOUR_ENDED;
+    TournamentResult result = tournamentCheckEnd(data);
+    if(result != TOUR_SUCCESS){
+        return result;
     }
-    if(data->games == NULL || gameGetInfo(data->games, GAME_NUM_GAMES) == 0){
-        return TOUR_N0_GAMES;
+    if(mapPut(index->ended_tournaments, &tour_id, data) == MAP_OUT_OF_MEMORY){
+        return TOUR_MEMORY_PROBLEM;
     }
-    data->tour_ended = true;
-    data->tournament_winner = playerGetTournamentWinnerID(data->Players);
+    tournamentMarkPending(index, tour_id, data);
+    tournamentComplete(data);
     return TOUR_SUCCESS;
 }
 
-double tournamentCalculateTotalTime(Map tournament, int player_id)
+TournamentResult tournamentEndAll(Map* tournaments, TourIndex index, const int* tour_ids,
+                                  int num_of_tournaments, ThreadPool pool, TournamentResult* results)
 {
-    if(tournament == NULL) {
+    assert(tournaments != NULL && index != NULL && tour_ids != NULL && results != NULL);
+    if(num_of_tournaments <= 0){
+        return TOUR_SUCCESS;
+    }
+    TourEndEntry* entries = malloc(num_of_tournaments * sizeof(*entries));
+    if(entries == NULL){
+        for (int i = 0; i < num_of_tournaments; ++i) {
+            results[i] = TOUR_MEMORY_PROBLEM;
+        }
+        return TOUR_MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        entries[i].id = tour_ids[i];
+        entries[i].position = i;
+        entries[i].data = mapGet(tournaments[i], (MapKeyElement)&tour_ids[i]);
+    }
+    qsort(entries, num_of_tournaments, sizeof(*entries), tournamentEndEntryCompare);
+    // the entries to close are moved to the front, behind the entry that is checked
+    int num_to_close = 0;
+    int previous_position = EMPTY;
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        TourEndEntry entry = entries[i];
+        if(previous_position != EMPTY && tour_ids[previous_position] == entry.id){
+            TournamentResult first_result = results[previous_position];
+            results[entry.position] = first_result == TOUR_SUCCESS ? TOUR_ENDED : first_result;
+            continue;
+        }
+        previous_position = entry.position;
+        results[entry.position] = entry.data == NULL ? TOUR_NOT_EXIST : tournamentCheckEnd(entry.data);
+        if(results[entry.position] == TOUR_SUCCESS){
+            entries[num_to_close++] = entry;
+        }
+    }
+    for (int i = 0; i < num_to_close; ++i) {
+        if(mapPut(index->ended_tournaments, &entries[i].id, entries[i].data) == MAP_OUT_OF_MEMORY){
+            for (int j = 0; j < i; ++j) {
+                mapRemove(index->ended_tournaments, &entries[j].id);
+            }
+            // the entries to close are still sorted by id, so the repeated ids of them are found too
+            for (int j = 0; j < num_of_tournaments; ++j) {
+                if(bsearch(&tour_ids[j], entries, num_to_close, sizeof(*entries),
+                           tournamentEndEntryIdCompare) != NULL){
+                    results[j] = TOUR_MEMORY_PROBLEM;
+                }
+            }
+            free(entries);
+            return TOUR_MEMORY_PROBLEM;
+        }
+    }
+    for (int i = 0; i < num_to_close; ++i) {
+        tournamentMarkPending(index, entries[i].id, entries[i].data);
+    }
+    threadPoolRun(pool, num_to_close, tournamentCompleteTask, entries);
+    free(entries);
+    return TOUR_SUCCESS;
+}
+
+double tournamentCalculateTotalTime(TourIndex index, int player_id)
+{
+    if(index == NULL) {
+        return 0;
+    }
+    Map player_tournaments = mapGet(index->player_tournaments, &player_id);
+    if(player_tournaments == NULL) {
         return 0;
     }
     double average_time = 0;
-    MAP_FOREACH(int*, iter, tournament)
+    MAP_FOREACH(int*, iter, player_tournaments)
     {
-        TourData data = mapGet(tournament, iter);
-        if(mapContains(data->Players, &player_id)) {
+        TourData data = mapGet(player_tournaments, iter);
+        if(tournamentHasPlayer(data, player_id)) {
             average_time += (gamePlayedTime(data->games, player_id));
         }
         destroyIntKey(iter);
@@ -184,18 +486,243 @@ double tournamentCalculateTotalTime(Map tournament, int player_id)
     return average_time;
 
 }
-bool tournamentExistEnded(Map tournament)
+InternedString tournamentGetLocation(Map tournament, int tour_id)
 {
-    MAP_FOREACH(int*, iter, tournament)
-    {
-        TourData data = mapGet(tournament, iter);
-        if(data->tour_ended == true) {
-            destroyIntKey(iter);
-            return true;
+    TourData data = mapGet(tournament, &tour_id);
+    if(data == NULL){
+        return NULL;
+    }
+    return data->tournament_location;
+}
+
+TournamentResult tournamentGetByLocation(TourIndex index, const char* location,
+                                         int** tournament_ids, int* num_of_tournaments)
+{
+    assert(index != NULL && location != NULL && tournament_ids != NULL && num_of_tournaments != NULL);
+    *tournament_ids = NULL;
+    *num_of_tournaments = 0;
+    Map location_tournaments = mapGet(index->location_tournaments, (MapKeyElement)location);
+    if(location_tournaments == NULL){
+        return TOUR_SUCCESS;
+    }
+    int* ids = malloc(mapGetSize(location_tournaments) * sizeof(int));
+    if(ids == NULL){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    int* next_id = ids;
+    mapApply(location_tournaments, tournamentCollectId, &next_id);
+    *tournament_ids = ids;
+    *num_of_tournaments = mapGetSize(location_tournaments);
+    return TOUR_SUCCESS;
+}
+
+void tournamentLocationStatistic(TourIndex index, const char* location,
+                                 ChessLocationStatistics* statistics)
+{
+    assert(index != NULL && location != NULL && statistics != NULL);
+    statistics->num_tournaments = 0;
+    statistics->num_ended_tournaments = 0;
+    statistics->num_games = 0;
+    statistics->longest_game = 0;
+    statistics->total_play_time = 0;
+    statistics->average_play_time = 0;
+    Map location_tournaments = mapGet(index->location_tournaments, (MapKeyElement)location);
+    if(location_tournaments == NULL){
+        return;
+    }
+    mapApply(location_tournaments, tournamentAddStatistic, statistics);
+    if(statistics->num_games > 0){
+        statistics->average_play_time = statistics->total_play_time / statistics->num_games;
+    }
+}
+
+TournamentResult tournamentSave(Map tournament, SnapshotWriter writer)
+{
+    assert(tournament != NULL && writer != NULL);
+    mapApply(tournament, tournamentSaveData, writer);
+    return TOUR_SUCCESS;
+}
+
+TournamentResult tournamentLoad(Map tournament, TourIndex index, int tournament_id, SnapshotReader reader)
+{
+    assert(tournament != NULL && index != NULL && reader != NULL);
+    const char* location = snapshotReadString(reader);
+    int max_games = snapshotReadInt(reader);
+    int tour_ended = snapshotReadInt(reader);
+    int tournament_winner = snapshotReadInt(reader);
+    if(snapshotReaderFailed(reader) || max_games <= 0 || (tour_ended != false && tour_ended != true)){
+        snapshotReaderReject(reader);
+        return TOUR_SUCCESS;
+    }
+    TourData tour_data = tournamentCreateData(tournament, index, tournament_id, location, max_games);
+    if(tour_data == NULL){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    if(gameLoad(tour_data->games, reader) == GAME_OUT_OF_MEMORY ||
+       playersLoad(tour_data->Players, reader) == PLAYER_MEMORY_FAILED){
+        mapRemove(tournament, &tournament_id);
+        return TOUR_MEMORY_PROBLEM;
+    }
+    if(tour_ended == true){
+        tour_data->tour_ended = true;
+        tour_data->tournament_winner = tournament_winner;
+        tournamentFormatStatistics(tour_data);
+        tournamentFreeze(tour_data);
+    }
+    return TOUR_SUCCESS;
+}
+
+TournamentResult tournamentRebuildIndex(Map* tournaments, int num_of_maps, TourIndex index)
+{
+    assert(tournaments != NULL && index != NULL);
+    assert(mapGetSize(index->player_tournaments) == 0 && mapGetSize(index->ended_tournaments) == 0);
+    int num_of_tournaments = 0;
+    for (int i = 0; i < num_of_maps; ++i) {
+        num_of_tournaments += mapGetSize(tournaments[i]);
+    }
+    TourEndEntry* entries = malloc((num_of_tournaments + 1) * sizeof(*entries));
+    if(entries == NULL){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    TourEndEntry* next_entry = entries;
+    for (int i = 0; i < num_of_maps; ++i) {
+        mapApply(tournaments[i], tournamentCollectEntry, &next_entry);
+    }
+    qsort(entries, num_of_tournaments, sizeof(*entries), tournamentEndEntryCompare);
+    // every set of the index gets its ids in ascending order, so they are all appended
+    int num_of_players = 0;
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        TourData data = entries[i].data;
+        if((data->tour_ended == true &&
+            (mapPut(index->ended_tournaments, &entries[i].id, data) == MAP_OUT_OF_MEMORY ||
+             mapPut(index->pending_statistics, &entries[i].id, data) == MAP_OUT_OF_MEMORY)) ||
+           tournamentIndexLocation(index, entries[i].id, data) == TOUR_MEMORY_PROBLEM){
+            free(entries);
+            return TOUR_MEMORY_PROBLEM;
         }
-        destroyIntKey(iter);
+        num_of_players += data->frozen_players != NULL ? playerTableGetSize(data->frozen_players) :
+                          mapGetSize(data->Players);
+    }
+    TourPlayerEntry* players = malloc((num_of_players + 1) * sizeof(*players));
+    if(players == NULL){
+        free(entries);
+        return TOUR_MEMORY_PROBLEM;
+    }
+    TourPlayerEntry* next_player = players;
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        TourData data = entries[i].data;
+        TourPlayerEntry* first_player = next_player;
+        if(data->frozen_players != NULL){
+            for (int j = 0; j < playerTableGetSize(data->frozen_players); ++j) {
+                next_player->player_id = playerTableGetId(data->frozen_players, j);
+                next_player++;
+            }
+        }
+        else{
+            mapApply(data->Players, tournamentCollectPlayer, &next_player);
+        }
+        for (TourPlayerEntry* player = first_player; player < next_player; ++player) {
+            player->tournament_id = entries[i].id;
+            player->data = data;
+        }
+    }
+    free(entries);
+    qsort(players, num_of_players, sizeof(*players), tournamentPlayerEntryCompare);
+    TournamentResult result = tournamentIndexPlayerEntries(index, players, num_of_players);
+    free(players);
+    return result;
+}
+
+bool tournamentExistEnded(TourIndex index)
+{
+    assert(index != NULL);
+    return mapGetSize(index->ended_tournaments) > 0;
+}
+
+int tournamentGetNumEnded(TourIndex index)
+{
+    assert(index != NULL);
+    return mapGetSize(index->ended_tournaments);
+}
+
+void tournamentForEachPlayer(Map tournament, int tour_id, PlayerStatsFunction function, void* context)
+{
+    assert(tournament != NULL && function != NULL);
+    TourData data = mapGet(tournament, &tour_id);
+    assert(data != NULL);
+    if(data->frozen_players != NULL){
+        playerTableForEach(data->frozen_players, function, context);
+    }
+    else if(data->Players != NULL){
+        playersForEach(data->Players, function, context);
+    }
+}
+
+int tournamentGetWinner(Map tournament, int tour_id)
+{
+    assert(tournament != NULL);
+    TourData data = mapGet(tournament, &tour_id);
+    assert(data != NULL);
+    return data->tour_ended ? data->tournament_winner : TOUR_NOT_OVER;
+}
+
+TournamentResult tournamentGetPlayerStats(Map tournament, int tour_id, int player_id, PlayerStats* stats,
+                                          double* level)
+{
+    assert(tournament != NULL && stats != NULL && level != NULL);
+    TourData data = mapGet(tournament, &tour_id);
+    if(data == NULL){
+        return TOUR_NOT_EXIST;
+    }
+    PlayerNodeResult result = PLAYER_NOT_EXIST;
+    if(data->frozen_players != NULL){
+        result = playerTableGetStats(data->frozen_players, player_id, stats, level);
+    }
+    else if(data->Players != NULL){
+        result = playerGetStats(data->Players, player_id, stats, level);
+    }
+    return result == PLAYER_SUCCESS ? TOUR_SUCCESS : TOUR_PLAYER_NOT_EXIST;
+}
+
+static TourData tournamentCreateData(Map tournament, TourIndex index, int tournament_id,
+                                     const char* location, int max_games)
+{
+    assert(tournament != NULL && index != NULL && location != NULL);
+    TourData tour_data = malloc(sizeof(*tour_data));
+    if(tour_data == NULL){
+        return NULL;
     }
-    return false;
+    tour_data->locations = index->locations;
+    tour_data->tournament_location = stringPoolIntern(index->locations, location);
+    if(tour_data->tournament_location == NULL)
+    {
+        free(tour_data);
+        return NULL;
+    }
+    tour_data->tournament_winner = TOUR_NOT_OVER;
+    tour_data->tour_ended = false;
+    tour_data->statistics = NULL;
+    tour_data->statistics_length = 0;
+    tour_data->max_game_player = max_games;
+    tour_data->arena = NULL;
+    tour_data->games = NULL;
+    tour_data->Players = NULL;
+    tour_data->frozen_players = NULL;
+    MapResult put_result = mapPut(tournament, &tournament_id, tour_data);
+    tournamentFreeData(tour_data);
+    if(put_result == MAP_OUT_OF_MEMORY){
+        return NULL;
+    }
+    // the map keeps a copy, so the arena is created for the copy and the games and players are created in place
+    tour_data = mapGet(tournament, &tournament_id);
+    tour_data->arena = arenaCreate();
+    tour_data->games = gameCreate(tour_data->arena);
+    tour_data->Players = playersCreateMap(tour_data->arena);
+    if(tour_data->arena == NULL || tour_data->games == NULL || tour_data->Players == NULL){
+        mapRemove(tournament, &tournament_id);
+        return NULL;
+    }
+    return tour_data;
 }
 
 static void tournamentFreeData(MapDataElement tournament_data)
@@ -204,10 +731,6 @@ static void tournamentFreeData(MapDataElement tournament_data)
         return;
     }
     TourData data = tournament_data;
-    if(data->tournament_location != NULL)
-    {
-        free(data->tournament_location);
-    }
     if(data->games != NULL)
     {
         gameDestroy(data->games);
@@ -216,6 +739,10 @@ static void tournamentFreeData(MapDataElement tournament_data)
     {
         mapDestroy(data->Players);
     }
+    playerTableDestroy(data->frozen_players);
+    free(data->statistics);
+    arenaDestroy(data->arena);
+    stringPoolRelease(data->locations, data->tournament_location);
     free(data);
 }
 static MapDataElement tournamentDataCopy(MapDataElement tournament_data)
@@ -225,26 +752,474 @@ static MapDataElement tournamentDataCopy(MapDataElement tournament_data)
     if(new_data == NULL){
         return NULL;
     }
-    new_data->tournament_location = malloc(strlen(old_data->tournament_location) + 1);
+    // the copy does not share the arena, its games and players are allocated on their own
+    new_data->arena = NULL;
+    new_data->games = NULL;
+    new_data->Players = NULL;
+    new_data->frozen_players = NULL;
+    new_data->statistics = NULL;
+    new_data->statistics_length = 0;
+    new_data->locations = old_data->locations;
+    new_data->tournament_location = stringPoolIntern(old_data->locations, old_data->tournament_location);
     if(new_data->tournament_location == NULL){
         free(new_data);
         return NULL;
     }
-    strcpy(new_data->tournament_location, old_data->tournament_location);
-    new_data->games = gameCopy(old_data->games);
-    if(new_data->games == NULL){
-        tournamentFreeData(new_data);
-        return NULL;
+    if(old_data->games != NULL){
+        new_data->games = gameCopy(old_data->games);
+        if(new_data->games == NULL){
+            tournamentFreeData(new_data);
+            return NULL;
+        }
     }
-    new_data->Players = mapCopy(old_data->Players);
-    if(new_data->Players == NULL){
+    if(old_data->frozen_players != NULL){
+        new_data->frozen_players = playerTableCopy(old_data->frozen_players);
+    }
+    else if(old_data->Players != NULL){
+        new_data->Players = mapCopy(old_data->Players);
+    }
+    if((old_data->Players != NULL || old_data->frozen_players != NULL) &&
+       new_data->Players == NULL && new_data->frozen_players == NULL){
         tournamentFreeData(new_data);
         return NULL;
     }
     new_data->tournament_winner = old_data->tournament_winner;
     new_data->max_game_player = old_data->max_game_player;
     new_data->tour_ended = old_data->tour_ended;
+    if(old_data->statistics != NULL){
+        new_data->statistics = malloc(old_data->statistics_length + 1);
+        if(new_data->statistics == NULL){
+            tournamentFreeData(new_data);
+            return NULL;
+        }
+        memcpy(new_data->statistics, old_data->statistics, old_data->statistics_length + 1);
+        new_data->statistics_length = old_data->statistics_length;
+    }
     return new_data;
 }
 
+static TournamentResult tournamentFormatStatistics(TourData tour_data)
+{
+    assert(tour_data != NULL && tour_data->tour_ended == true);
+    tournamentInvalidateStatistics(tour_data);
+    int length = snprintf(NULL, 0, STATISTICS_FORMAT, tour_data->tournament_winner,
+                          gameGetInfo(tour_data->games, GAME_LONGEST), gameAvgTime(tour_data->games),
+                          tour_data->tournament_location, gameGetInfo(tour_data->games, GAME_NUM_GAMES),
+                          gameGetInfo(tour_data->games, GAME_NUM_PLAYERS));
+    if(length < 0){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    char* statistics = malloc(length + 1);
+    if(statistics == NULL){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    snprintf(statistics, length + 1, STATISTICS_FORMAT, tour_data->tournament_winner,
+             gameGetInfo(tour_data->games, GAME_LONGEST), gameAvgTime(tour_data->games),
+             tour_data->tournament_location, gameGetInfo(tour_data->games, GAME_NUM_GAMES),
+             gameGetInfo(tour_data->games, GAME_NUM_PLAYERS));
+    tour_data->statistics = statistics;
+    tour_data->statistics_length = length;
+    return TOUR_SUCCESS;
+}
+
+static void tournamentFormatStatisticsTask(int task_index, void* tournaments)
+{
+    tournamentFormatStatistics(((TourData*)tournaments)[task_index]);
+}
+
+static TournamentResult tournamentWriteStatistics(Map tournament_set, const char* path_file, const char* mode,
+                                                  bool with_ids, ThreadPool pool)
+{
+    assert(tournament_set != NULL && path_file != NULL && mode != NULL);
+    int num_of_tournaments = mapGetSize(tournament_set);
+    TourEndEntry* entries = malloc(num_of_tournaments * sizeof(*entries));
+    if(entries == NULL && num_of_tournaments > 0){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    TourEndEntry* next_entry = entries;
+    mapApply(tournament_set, tournamentCollectEntry, &next_entry);
+    // the blocks that are not cached are moved to a second array, so they are formatted together
+    TourData* unformatted = malloc(num_of_tournaments * sizeof(*unformatted));
+    if(unformatted == NULL && num_of_tournaments > 0){
+        free(entries);
+        return TOUR_MEMORY_PROBLEM;
+    }
+    int num_unformatted = 0;
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        assert(entries[i].data->tour_ended == true);
+        if(entries[i].data->statistics == NULL){
+            unformatted[num_unformatted++] = entries[i].data;
+        }
+    }
+    threadPoolRun(pool, num_unformatted, tournamentFormatStatisticsTask, unformatted);
+    free(unformatted);
+    FILE* file = fopen(path_file, mode);
+    if(file == NULL){
+        free(entries);
+        return TOUR_MEMORY_PROBLEM;
+    }
+    setvbuf(file, NULL, _IOFBF, STATISTICS_WRITE_BUFFER);
+    for (int i = 0; i < num_of_tournaments; ++i) {
+        TourData data = entries[i].data;
+        if(data->statistics == NULL || (with_ids && fprintf(file, STATISTICS_ID_FORMAT, entries[i].id) < 0) ||
+           fwrite(data->statistics, 1, data->statistics_length, file) != data->statistics_length){
+            fclose(file);
+            free(entries);
+            return TOUR_MEMORY_PROBLEM;
+        }
+    }
+    free(entries);
+    if(fclose(file) == EOF){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    return TOUR_SUCCESS;
+}
+
+static void tournamentMarkPending(TourIndex index, int tournament_id, TourData tour_data)
+{
+    assert(index != NULL && tour_data != NULL);
+    if(index->pending_statistics_lost == false &&
+       mapPut(index->pending_statistics, &tournament_id, tour_data) == MAP_OUT_OF_MEMORY){
+        index->pending_statistics_lost = true;
+    }
+}
+
+static void tournamentInvalidateStatistics(TourData tour_data)
+{
+    assert(tour_data != NULL);
+    free(tour_data->statistics);
+    tour_data->statistics = NULL;
+    tour_data->statistics_length = 0;
+}
+
+static TournamentResult tournamentCheckEnd(TourData tour_data)
+{
+    assert(tour_data != NULL);
+    if(tour_data->tour_ended == true){
+        return TOUR_ENDED;
+    }
+    if(tour_data->games == NULL || gameGetInfo(tour_data->games, GAME_NUM_GAMES) == 0){
+        return TOUR_N0_GAMES;
+    }
+    return TOUR_SUCCESS;
+}
+
+static void tournamentComplete(TourData tour_data)
+{
+    assert(tour_data != NULL && tour_data->tour_ended == false);
+    tour_data->tour_ended = true;
+    tour_data->tournament_winner = playerGetTournamentWinnerID(tour_data->Players);
+    tournamentFormatStatistics(tour_data);
+    tournamentFreeze(tour_data);
+}
+
+static void tournamentCompleteTask(int task_index, void* entries)
+{
+    tournamentComplete(((TourEndEntry*)entries)[task_index].data);
+}
+
+static int tournamentEndEntryCompare(const void* entry1, const void* entry2)
+{
+    const TourEndEntry* first = entry1;
+    const TourEndEntry* second = entry2;
+    if(first->id != second->id){
+        return first->id < second->id ? -1 : 1;
+    }
+    return first->position - second->position;
+}
+
+static int tournamentEndEntryIdCompare(const void* id, const void* entry)
+{
+    int first = *(const int*)id;
+    int second = ((const TourEndEntry*)entry)->id;
+    return first == second ? 0 : (first < second ? -1 : 1);
+}
+
+static void tournamentCollectEntry(MapKeyElement tournament_id, MapDataElement tour_data, void* next_entry)
+{
+    assert(tournament_id != NULL && tour_data != NULL && next_entry != NULL);
+    TourEndEntry** next = next_entry;
+    (*next)->id = *(int*)tournament_id;
+    (*next)->position = 0;
+    (*next)->data = tour_data;
+    (*next)++;
+}
+
+static void tournamentCollectPlayer(MapKeyElement player_id, MapDataElement player_data, void* next_entry)
+{
+    assert(player_id != NULL && next_entry != NULL);
+    (void)player_data;
+    TourPlayerEntry** next = next_entry;
+    (*next)->player_id = *(int*)player_id;
+    (*next)++;
+}
 
+static int tournamentPlayerEntryCompare(const void* entry1, const void* entry2)
+{
+    const TourPlayerEntry* first = entry1;
+    const TourPlayerEntry* second = entry2;
+    if(first->player_id != second->player_id){
+        return first->player_id < second->player_id ? -1 : 1;
+    }
+    if(first->tournament_id != second->tournament_id){
+        return first->tournament_id < second->tournament_id ? -1 : 1;
+    }
+    return EQUAL;
+}
+
+static TournamentResult tournamentIndexPlayerEntries(TourIndex index, TourPlayerEntry* entries,
+                                                     int num_of_entries)
+{
+    assert(index != NULL && (entries != NULL || num_of_entries == 0));
+    int first = 0;
+    while(first < num_of_entries)
+    {
+        Map player_tournaments = tournamentCreateSet();
+        if(player_tournaments == NULL){
+            return TOUR_MEMORY_PROBLEM;
+        }
+        int player_id = entries[first].player_id;
+        int next = first;
+        for (; next < num_of_entries && entries[next].player_id == player_id; ++next) {
+            if(mapPut(player_tournaments, &entries[next].tournament_id, entries[next].data) == MAP_OUT_OF_MEMORY){
+                mapDestroy(player_tournaments);
+                return TOUR_MEMORY_PROBLEM;
+            }
+        }
+        MapResult result = mapPut(index->player_tournaments, &player_id, player_tournaments);
+        mapDestroy(player_tournaments);
+        if(result == MAP_OUT_OF_MEMORY){
+            return TOUR_MEMORY_PROBLEM;
+        }
+        first = next;
+    }
+    return TOUR_SUCCESS;
+}
+
+static void tournamentSaveData(MapKeyElement tournament_id, MapDataElement tour_data, void* writer)
+{
+    assert(tournament_id != NULL && tour_data != NULL && writer != NULL);
+    TourData data = tour_data;
+    snapshotWriteInt(writer, *(int*)tournament_id);
+    snapshotWriteString(writer, data->tournament_location);
+    snapshotWriteInt(writer, data->max_game_player);
+    snapshotWriteInt(writer, data->tour_ended);
+    snapshotWriteInt(writer, data->tournament_winner);
+    gameSave(data->games, writer);
+    if(data->frozen_players != NULL){
+        playerTableSave(data->frozen_players, writer);
+    }
+    else{
+        playersSave(data->Players, writer);
+    }
+}
+
+static void tournamentFreeze(TourData tour_data)
+{
+    assert(tour_data != NULL && tour_data->tour_ended == true);
+    bool games_frozen = gameFreeze(tour_data->games) == GAME_SUCCESS;
+    if(tour_data->frozen_players == NULL){
+        tour_data->frozen_players = playerTableCreate(tour_data->Players);
+        if(tour_data->frozen_players != NULL){
+            mapDestroy(tour_data->Players);
+            tour_data->Players = NULL;
+        }
+    }
+    // the frozen games and players do not use the arena, so it is freed once both are taken
+    if(games_frozen && tour_data->Players == NULL){
+        arenaDestroy(tour_data->arena);
+        tour_data->arena = NULL;
+    }
+}
+
+static bool tournamentHasPlayer(TourData tour_data, int player_id)
+{
+    assert(tour_data != NULL);
+    if(tour_data->frozen_players != NULL){
+        return playerTableContains(tour_data->frozen_players, player_id);
+    }
+    return mapContains(tour_data->Players, &player_id);
+}
+
+static MapKeyElement tournamentLocationCopy(MapKeyElement location)
+{
+    return location;
+}
+
+static void tournamentLocationFree(MapKeyElement location)
+{
+    (void)location;
+}
+
+static int tournamentLocationCompare(MapKeyElement location1, MapKeyElement location2)
+{
+    assert(location1 != NULL && location2 != NULL);
+    if(location1 == location2){
+        return EQUAL;
+    }
+    return strcmp(location1, location2);
+}
+
+static TournamentResult tournamentIndexLocation(TourIndex index, int tournament_id, TourData tour_data)
+{
+    assert(index != NULL && tour_data != NULL);
+    MapKeyElement location = (MapKeyElement)tour_data->tournament_location;
+    Map location_tournaments = mapGet(index->location_tournaments, location);
+    if(location_tournaments == NULL)
+    {
+        Map new_set = tournamentCreateSet();
+        if(new_set == NULL){
+            return TOUR_MEMORY_PROBLEM;
+        }
+        MapResult result = mapPut(index->location_tournaments, location, new_set);
+        mapDestroy(new_set);
+        if(result == MAP_OUT_OF_MEMORY){
+            return TOUR_MEMORY_PROBLEM;
+        }
+        location_tournaments = mapGet(index->location_tournaments, location);
+    }
+    if(mapPut(location_tournaments, &tournament_id, tour_data) == MAP_OUT_OF_MEMORY){
+        if(mapGetSize(location_tournaments) == 0){
+            mapRemove(index->location_tournaments, location);
+        }
+        return TOUR_MEMORY_PROBLEM;
+    }
+    return TOUR_SUCCESS;
+}
+
+static void tournamentUnindexLocation(TourIndex index, int tournament_id, TourData tour_data)
+{
+    assert(index != NULL && tour_data != NULL);
+    MapKeyElement location = (MapKeyElement)tour_data->tournament_location;
+    Map location_tournaments = mapGet(index->location_tournaments, location);
+    if(location_tournaments == NULL){
+        return;
+    }
+    mapRemove(location_tournaments, &tournament_id);
+    // the key is the interned location, so it must go before the tournament releases the location
+    if(mapGetSize(location_tournaments) == 0){
+        mapRemove(index->location_tournaments, location);
+    }
+}
+
+static void tournamentCollectId(MapKeyElement tournament_id, MapDataElement tour_data, void* ids)
+{
+    assert(tournament_id != NULL && ids != NULL);
+    (void)tour_data;
+    int** next_id = ids;
+    **next_id = *(int*)tournament_id;
+    (*next_id)++;
+}
+
+static void tournamentAddStatistic(MapKeyElement tournament_id, MapDataElement tour_data, void* statistics)
+{
+    assert(tour_data != NULL && statistics != NULL);
+    (void)tournament_id;
+    TourData data = tour_data;
+    ChessLocationStatistics* location_statistics = statistics;
+    location_statistics->num_tournaments++;
+    if(data->tour_ended == true){
+        location_statistics->num_ended_tournaments++;
+    }
+    location_statistics->num_games += gameGetInfo(data->games, GAME_NUM_GAMES);
+    if(gameGetInfo(data->games, GAME_LONGEST) > location_statistics->longest_game){
+        location_statistics->longest_game = gameGetInfo(data->games, GAME_LONGEST);
+    }
+    location_statistics->total_play_time += gameTotalTime(data->games);
+}
+
+static Map tournamentCreateSet()
+{
+    return mapCreate(tournamentPointerCopy, copyIntKey, tournamentPointerFree,
+                     destroyIntKey, intKeyCompare);
+}
+
+static MapDataElement tournamentPointerCopy(MapDataElement tournament_data)
+{
+    return tournament_data;
+}
+
+static void tournamentPointerFree(MapDataElement tournament_data)
+{
+    (void)tournament_data;
+}
+
+static MapDataElement tournamentSetCopy(MapDataElement tournament_set)
+{
+    return mapCopy(tournament_set);
+}
+
+static void tournamentSetFree(MapDataElement tournament_set)
+{
+    mapDestroy(tournament_set);
+}
+
+static TournamentResult tournamentIndexPlayer(TourIndex index, int player_id,
+                                              int tournament_id, TourData tour_data)
+{
+    assert(index != NULL && tour_data != NULL);
+    Map player_tournaments = mapGet(index->player_tournaments, &player_id);
+    if(player_tournaments == NULL)
+    {
+        Map new_set = tournamentCreateSet();
+        if(new_set == NULL){
+            return TOUR_MEMORY_PROBLEM;
+        }
+        MapResult result = mapPut(index->player_tournaments, &player_id, new_set);
+        mapDestroy(new_set);
+        if(result == MAP_OUT_OF_MEMORY){
+            return TOUR_MEMORY_PROBLEM;
+        }
+        player_tournaments = mapGet(index->player_tournaments, &player_id);
+    }
+    if(mapPut(player_tournaments, &tournament_id, tour_data) == MAP_OUT_OF_MEMORY){
+        return TOUR_MEMORY_PROBLEM;
+    }
+    return TOUR_SUCCESS;
+}
+
+static void tournamentUnindexNewPlayer(TourIndex index, TourData tour_data, int player_id, int tournament_id)
+{
+    assert(index != NULL && tour_data != NULL);
+    if(mapContains(tour_data->Players, &player_id)){
+        return;
+    }
+    Map player_tournaments = mapGet(index->player_tournaments, &player_id);
+    if(player_tournaments == NULL){
+        return;
+    }
+    mapRemove(player_tournaments, &tournament_id);
+    if(mapGetSize(player_tournaments) == 0){
+        mapRemove(index->player_tournaments, &player_id);
+    }
+}
+
+static void tournamentUnindexPlayer(MapKeyElement player_id, MapDataElement player_data,
+                                    MapDataElement player_tournaments, void* tour_unindex)
+{
+    assert(player_id != NULL && player_tournaments != NULL && tour_unindex != NULL);
+    (void)player_data;
+    tournamentUnindexFromSet(tour_unindex, *(int*)player_id, player_tournaments);
+}
+
+static void tournamentUnindexFrozenPlayer(MapKeyElement player_id, MapDataElement player_tournaments,
+                                          void* tour_unindex)
+{
+    assert(player_id != NULL && player_tournaments != NULL && tour_unindex != NULL);
+    TourUnindex* unindex = tour_unindex;
+    int size = playerTableGetSize(unindex->players);
+    while(unindex->position < size && playerTableGetId(unindex->players, unindex->position) < *(int*)player_id){
+        unindex->position++;
+    }
+    if(unindex->position < size && playerTableGetId(unindex->players, unindex->position) == *(int*)player_id){
+        tournamentUnindexFromSet(unindex, *(int*)player_id, player_tournaments);
+    }
+}
+
+static void tournamentUnindexFromSet(TourUnindex* unindex, int player_id, Map player_tournaments)
+{
+    mapRemove(player_tournaments, &unindex->tournament_id);
+    if(unindex->emptied != NULL && mapGetSize(player_tournaments) == 0){
+        unindex->emptied[unindex->num_of_emptied++] = player_id;
+    }
+}
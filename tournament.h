@@ -1,9 +1,12 @@
 #include "games.h"
 #include "chessSystem.h"
+#include "chessSystemExtended.h"
+#include "stringPool.h"
 #ifndef MTM_3_2_TOURNAMENT_H
 #define MTM_3_2_TOURNAMENT_H
 
 typedef struct tour_data *TourData;
+typedef struct tour_index_t *TourIndex;
 
 typedef enum ChessTournament_t {
     TOUR_MEMORY_PROBLEM,
@@ -13,7 +16,8 @@ typedef enum ChessTournament_t {
     TOUR_NEGATIVE_TIME,
     TOUR_ENDED,
     TOUR_NOT_EXIST,
-    TOUR_N0_GAMES
+    TOUR_N0_GAMES,
+    TOUR_PLAYER_NOT_EXIST
 
 }TournamentResult;
 
@@ -26,9 +30,28 @@ typedef enum ChessTournament_t {
 */
 Map tournamentCreateNew();
 /**
-* tournamentAddGame: Added a new tournament to the system.
+* tournamentCreateIndex: create the secondary indexes of the tournaments map
+* (player id -> the tournaments the player has played in, the ended tournaments,
+* the pool that stores every distinct tournament location once, and location -> its tournaments).
+*
+* @return
+ * 	Null - allocation failed.
+ * 	pointer to the index - allocation success.
+*/
+TourIndex tournamentCreateIndex();
+/**
+* tournamentDestroyIndex: deallocate the tournaments index.
+* the tournaments themselves are not freed.
+*
+* @param index - pointer to the index.
+*/
+void tournamentDestroyIndex(TourIndex index);
+/**
+* tournamentAdd: Added a new tournament to the system.
+* the location is interned in the locations pool of the index.
 *
 * @param tournament - pointer to the tournament map.
+* @param index - pointer to the tournaments index.
 * @param tournament_id - the id of the tournament.
 * @param location - pointer to const char that has the location of the tournament.
 * @param max_games - the max game that allowed in this tournament per player.
@@ -36,87 +59,274 @@ Map tournamentCreateNew();
 *  TOUR_MEMORY_PROBLEM - allocation failed.
  * 	TOUR_SUCCESS - the tour added successfully.
 */
-TournamentResult tournamentAdd(Map tournament, int tournament_id,
+TournamentResult tournamentAdd(Map tournament, TourIndex index, int tournament_id,
                                const char* location, int max_games);
 
 /**
-* tournamentAddGame: Added a new game to the tournament.
+* tournamentCheckGame: checks if a new game can be added to the tournament, without changing anything
+* and without allocating. the first phase of adding a game, tournamentCommitGame is the second.
 *
 * @param tournament - pointer to the tournament map.
 * @param tournament_id - the id of the tournament.
 * @param id1 - the id of the first player.
 * @param id2 - the id of the second player.
-* @param winner - the id of the winner, if its a tide will be -1.
 * @param game_time - the time of the game.
+* @param tour_data - a pointer where to put the tournament, if the game can be added.
 * @return
  *  TOUR_NOT_EXIST - there is no tournament with this id
 *   TOUR_ENDED - if the tournament end.
 *   TOUR_EXIST_GAME - already exist a game in this tournament with this 2 id.
 *   TOUR_NEGATIVE_TIME - the time is negative.
 * 	TOUR_EXCEEDED_GAMES - one of the players has exceeded the max number of game.
+* 	TOUR_SUCCESS - the game can be added.
+*/
+TournamentResult tournamentCheckGame(Map tournament, int tournament_id, int id1, int id2, int game_time,
+                                     TourData* tour_data);
+/**
+* tournamentCommitGame: adds a game that was checked by tournamentCheckGame to the tournament.
+* the tournament must not change between the check and the commit.
+*
+* @param tour_data - the tournament that tournamentCheckGame has found.
+* @param index - pointer to the tournaments index.
+* @param tournament_id - the id of the tournament.
+* @param id1 - the id of the first player.
+* @param id2 - the id of the second player.
+* @param winner - the winner of the game.
+* @param game_time - the time of the game.
+* @return
 * 	TOUR_MEMORY_PROBLEM - allocation failed.
 * 	TOUR_SUCCESS - the game added successfully.
 */
-TournamentResult tournamentAddGame(Map tournament, int tournament_id, int id1,
-                                   int id2, Winner winner, int game_time);
+TournamentResult tournamentCommitGame(TourData tour_data, TourIndex index, int tournament_id, int id1,
+                                      int id2, Winner winner, int game_time);
 /**
 * tournamentStatistic: Added a statistics about ended tournament to a file.
+* only the ended tournaments are visited. the blocks that are not formatted yet are formatted
+* in parallel on the pool first, and then all the blocks are written in the order of the ids.
 *
 * @param path_file - the location of the file which the data will be add.
-* @param tournament - pointer to the tournament map.
+* @param index - pointer to the tournaments index.
+* @param pool - the pool that formats the blocks, NULL to format them on the calling thread.
 * @return
 * 	TOUR_MEMORY_PROBLEM - file opening failed or failing during save.
 * 	TOUR_SUCCESS - the data added successfully.
 */
-TournamentResult tournamentStatistic(char* path_file, Map tournament);
+TournamentResult tournamentStatistic(char* path_file, TourIndex index, ThreadPool pool);
+/**
+* tournamentStatisticDelta: append to a file the statistics of the ended tournaments that changed since
+* the last delta export (that ended, or that a player was removed from), in the order of the ids.
+* every block is the line of the id of the tournament and then the block of tournamentStatistic.
+* only the pending tournaments are visited, and they are not pending anymore after a successful export.
+*
+* @param path_file - the location of the file which the data will be appended to.
+* @param index - pointer to the tournaments index.
+* @param pool - the pool that formats the blocks, NULL to format them on the calling thread.
+* @param num_of_tournaments - a pointer where to put the number of tournaments that were written.
+* @return
+* 	TOUR_MEMORY_PROBLEM - file opening failed or failing during save. the tournaments stay pending.
+* 	TOUR_SUCCESS - the data added successfully.
+*/
+TournamentResult tournamentStatisticDelta(char* path_file, TourIndex index, ThreadPool pool,
+                                          int* num_of_tournaments);
+/**
+* tournamentGetNumPending: return the number of tournaments that the next delta export writes.
+*
+* @param index - pointer to the tournaments index.
+*/
+int tournamentGetNumPending(TourIndex index);
 /**
 * tournamentDestroy: destroy a tournament and deallocate its all memory.
 *
 * @param tournament - pointer to the tournament map.
 * @param external_player - pointer to the player external map.
+* @param index - pointer to the tournaments index.
 * @param tour_id - this id of the tournament.
 * @return
 * 	TOUR_MEMORY_PROBLEM - file opening failed or failing during save.
 * 	TOUR_SUCCESS - the data added successfully.
 */
-void tournamentDestroy(Map tournament, Map external_player, int id);
+void tournamentDestroy(Map tournament, Map external_player, TourIndex index, int id);
 /**
 * tournamentRemovePlayer: remove a player and its data from all the tournaments.
+* only the tournaments that the player has played in are visited.
 *
-* @param tournament - pointer to the tournament map.
+* @param index - pointer to the tournaments index.
 * @param external_player - pointer to the external map of the players.
 * @param player_id - the id of the player which we want to remove.
+* @param on_change - function that is called with the change of the results of every opponent whose
+* game became a win (in the tournaments that did not end), NULL for none.
+* @param context - a pointer that is passed as is to on_change.
 * @return
 * 	TOUR_NULL_ARGUMENT - NULL pointers was sent.
  * 	TOUR_SUCCESS - deleted successfully.
 */
-void tournamentRemovePlayer(Map tournament, Map external_player, int player_id);
+void tournamentRemovePlayer(TourIndex index, Map external_player, int player_id,
+                            PlayerStatsFunction on_change, void* context);
 /**
 * tournamentEnd: close the tournament and find the winner.
 *
 * @param tournament - pointer to the tournament map.
-* @param player_id - the id of the player which we want to remove.
+* @param index - pointer to the tournaments index.
+* @param tour_id - the id of the tournament to close.
 * @return
  * 	TOUR_ENDED - if the tournament ended.
  * 	TOUR_N0_GAMES - there is no games in the tournament.
- * 	TOUR_SUCCESS - closed successfully.
+ * 	TOUR_MEMORY_PROBLEM - allocation failed, the tournament is not closed.
+* 	TOUR_SUCCESS - closed successfully.
 */
-TournamentResult tournamentEnd(Map tournament, int tour_id);
+TournamentResult tournamentEnd(Map tournament, TourIndex index, int tour_id);
+/**
+* tournamentEndAll: close a batch of tournaments together. all the tournaments that can be closed
+* are added to the ended tournaments first, and only then their winners are found and their statistics
+* are formatted, in parallel on the pool. so either all of them are closed or none of them.
+* an id that appears more than once is closed once, the next ones get TOUR_ENDED.
+*
+* @param tournaments - for every id, pointer to the tournament map that holds it.
+* @param index - pointer to the tournaments index.
+* @param tour_ids - the ids of the tournaments to close.
+* @param num_of_tournaments - the number of ids.
+* @param pool - the pool that runs the closing, NULL to run it on the calling thread.
+* @param results - array of num_of_tournaments results, filled with the result of every id:
+* 	TOUR_NOT_EXIST, TOUR_ENDED, TOUR_N0_GAMES or TOUR_SUCCESS as in tournamentEnd, and
+* 	TOUR_MEMORY_PROBLEM for every id that was not closed because allocation failed.
+* @return
+* 	TOUR_MEMORY_PROBLEM - allocation failed, none of the tournaments is closed.
+* 	TOUR_SUCCESS - otherwise.
+*/
+TournamentResult tournamentEndAll(Map* tournaments, TourIndex index, const int* tour_ids,
+                                  int num_of_tournaments, ThreadPool pool, TournamentResult* results);
 /**
 * tournamentCalculateTotalTime: calculate the total time that a player has been played.
+* only the tournaments that the player has played in are visited.
+* @param index - pointer to the tournaments index.
+* @param player_id - the id of the player.
 * @return
 * 	the time.
 */
-double tournamentCalculateTotalTime(Map tournament, int player_id);
+double tournamentCalculateTotalTime(TourIndex index, int player_id);
 /**
-* touramentExistEnded: checks if there is closed tournament.
+* tournamentGetLocation: return the interned location of a tournament.
+* the locations of 2 tournaments are equal if and only if the handles are equal.
 *
 * @param tournament - pointer to the tournaments map
+* @param tour_id - the id of the tournament
+* @return
+* 	NULL - there is no tournament with this id.
+* 	the handle of the location - otherwise.
+*/
+InternedString tournamentGetLocation(Map tournament, int tour_id);
+/**
+* tournamentGetByLocation: return the ids of the tournaments that are held in a location.
+*
+* @param index - pointer to the tournaments index
+* @param location - the location
+* @param tournament_ids - a pointer where to put a new array of the ids (NULL if there are none).
+* @param num_of_tournaments - a pointer where to put the number of ids.
+* @return
+* 	TOUR_MEMORY_PROBLEM - allocation failed.
+* 	TOUR_SUCCESS - otherwise.
+*/
+TournamentResult tournamentGetByLocation(TourIndex index, const char* location,
+                                         int** tournament_ids, int* num_of_tournaments);
+/**
+* tournamentLocationStatistic: aggregate the statistics of the tournaments that are held in a location.
+*
+* @param index - pointer to the tournaments index
+* @param location - the location
+* @param statistics - a pointer where to put the statistics.
+*/
+void tournamentLocationStatistic(TourIndex index, const char* location,
+                                 ChessLocationStatistics* statistics);
+/**
+* touramentExistEnded: checks if there is closed tournament, in O(1).
+*
+* @param index - pointer to the tournaments index
 * @return
 * 	true - there is.
  * 	false - there is not.
 */
-bool tournamentExistEnded(Map tournament);
+bool tournamentExistEnded(TourIndex index);
+/**
+* tournamentGetNumEnded: returns the number of closed tournaments, in O(1).
+*
+* @param index - pointer to the tournaments index
+* @return
+* 	the number of closed tournaments.
+*/
+int tournamentGetNumEnded(TourIndex index);
+/**
+* tournamentSave: write all the tournaments of a tournament map to a snapshot, in the order of the ids:
+* for each of them its id, location, flags, games and players.
+*
+* @param tournament - pointer to the tournament map.
+* @param writer - the snapshot to write to.
+* @return
+* 	TOUR_SUCCESS - always, a failed write is reported when the writer is closed.
+*/
+TournamentResult tournamentSave(Map tournament, SnapshotWriter writer);
+/**
+* tournamentLoad: read a tournament that was written by tournamentSave, after its id, into the map.
+* the tournament is not indexed; tournamentRebuildIndex indexes all the tournaments once they are loaded.
+* data that is not valid fails the reader.
+*
+* @param tournament - pointer to the tournament map.
+* @param index - pointer to the tournaments index, that holds the locations.
+* @param tournament_id - the id of the tournament, that was read from the snapshot.
+* @param reader - the snapshot to read from.
+* @return
+* 	TOUR_MEMORY_PROBLEM - allocation failed.
+* 	TOUR_SUCCESS - otherwise, also when the reader failed.
+*/
+TournamentResult tournamentLoad(Map tournament, TourIndex index, int tournament_id, SnapshotReader reader);
+/**
+* tournamentRebuildIndex: index all the tournaments of the maps in an empty index
+* (the ended tournaments, the locations and the players). the pairs are sorted first,
+* so the whole index is built in O(n log n) instead of a search per pair.
+*
+* @param tournaments - array of the tournament maps.
+* @param num_of_maps - the number of maps.
+* @param index - pointer to the tournaments index.
+* @return
+* 	TOUR_MEMORY_PROBLEM - allocation failed.
+* 	TOUR_SUCCESS - otherwise.
+*/
+TournamentResult tournamentRebuildIndex(Map* tournaments, int num_of_maps, TourIndex index);
+/**
+* tournamentForEachPlayer: call a function with the id and the results in the tournament of every player
+* of the tournament, in the order of the ids.
+*
+* @param tournament - pointer to the tournament map.
+* @param tour_id - the id of the tournament, that is in the map.
+* @param function - the function to call.
+* @param context - a pointer that is passed as is to the function.
+*/
+void tournamentForEachPlayer(Map tournament, int tour_id, PlayerStatsFunction function, void* context);
+/**
+* tournamentGetWinner: return the id of the winner of an ended tournament.
+*
+* @param tournament - pointer to the tournament map.
+* @param tour_id - the id of the tournament, that is in the map.
+* @return
+* 	the id of the winner, or a negative value if the tournament did not end.
+*/
+int tournamentGetWinner(Map tournament, int tour_id);
+
+/**
+* tournamentGetPlayerStats: get the results and the level of a player in one tournament,
+* from the players of the tournament (the frozen table of an ended one).
+*
+* @param tournament - pointer to the tournament map.
+* @param tour_id - the id of the tournament.
+* @param player_id - the id of the player.
+* @param stats - where to put the results of the player in the tournament.
+* @param level - where to put the level of the player in the tournament, 0 if it has no games.
+* @return
+* 	TOUR_NOT_EXIST - the tournament is not in the map.
+* 	TOUR_PLAYER_NOT_EXIST - the player has no games in the tournament.
+* 	TOUR_SUCCESS - otherwise.
+*/
+TournamentResult tournamentGetPlayerStats(Map tournament, int tour_id, int player_id, PlayerStats* stats,
+                                          double* level);
 
 
 